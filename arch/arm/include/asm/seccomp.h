@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _ASM_ARM_SECCOMP_H
+#define _ASM_ARM_SECCOMP_H
+
+#include <uapi/linux/audit.h>
+
+/* syscall_get_arch() reports AUDIT_ARCH_ARM for every ARM task */
+#define SECCOMP_ARCH_NATIVE		AUDIT_ARCH_ARM
+#define SECCOMP_ARCH_NATIVE_NR		NR_syscalls
+#define SECCOMP_ARCH_NATIVE_NAME	"arm"
+
+#include <asm-generic/seccomp.h>
+
+#endif /* _ASM_ARM_SECCOMP_H */
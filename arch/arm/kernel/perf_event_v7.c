@@ -902,9 +902,11 @@ static void armv7pmu_enable_event(struct perf_event *event)
 		armv7_pmnc_write_evtsel(idx, hwc->config_base);
 
 	/*
-	 * Enable interrupt for this counter
+	 * Enable interrupt for this counter, unless the overflow flags are
+	 * polled because the interrupt isn't (reliably) wired up.
 	 */
-	armv7_pmnc_enable_intens(idx);
+	if (!cpu_pmu->poll)
+		armv7_pmnc_enable_intens(idx);
 
 	/*
 	 * Enable counter
@@ -13,7 +13,9 @@
 #include <linux/device.h>
 #include <linux/regmap.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/wait.h>
 
 struct regmap;
@@ -40,6 +42,18 @@ struct regmap_format {
 	void (*parse_inplace)(void *buf);
 };
 
+enum regmap_stat_item {
+	REGMAP_STAT_READ,
+	REGMAP_STAT_WRITE,
+	REGMAP_STAT_CACHE_HIT,
+	REGMAP_STAT_HW_READ,
+	REGMAP_STAT_HW_WRITE,
+	REGMAP_NR_STATS,
+};
+
+/* hardware access latency histogram, bucket n counts [2^n, 2^(n+1)) ns */
+#define REGMAP_LAT_BUCKETS	24
+
 struct regmap_async {
 	struct list_head list;
 	struct regmap *map;
@@ -84,6 +98,12 @@ struct regmap {
 
 	struct list_head debugfs_off_cache;
 	struct mutex cache_lock;
+
+	/* access statistics, only gathered while stats_enabled is set */
+	bool stats_enabled;
+	atomic_long_t stats[REGMAP_NR_STATS];
+	atomic_long_t read_lat[REGMAP_LAT_BUCKETS];
+	atomic_long_t write_lat[REGMAP_LAT_BUCKETS];
 #endif
 
 	unsigned int max_register;
@@ -166,6 +186,8 @@ struct regmap {
 struct regcache_ops {
 	const char *name;
 	enum regcache_type type;
+	/* read may be called without the map lock held */
+	bool lockless;
 	int (*init)(struct regmap *map);
 	int (*exit)(struct regmap *map);
 #ifdef CONFIG_DEBUG_FS
@@ -225,11 +247,54 @@ static inline void regmap_debugfs_disable(struct regmap *map)
 	map->debugfs_disable = true;
 }
 
+static inline bool regmap_stats_enabled(struct regmap *map)
+{
+	return READ_ONCE(map->stats_enabled);
+}
+
+static inline void regmap_stat_inc(struct regmap *map,
+				   enum regmap_stat_item item)
+{
+	if (regmap_stats_enabled(map))
+		atomic_long_inc(&map->stats[item]);
+}
+
+static inline u64 regmap_stat_start(struct regmap *map)
+{
+	return regmap_stats_enabled(map) ? ktime_get_ns() : 0;
+}
+
+static inline void regmap_stat_latency(struct regmap *map,
+				       enum regmap_stat_item item, u64 start)
+{
+	u64 delta;
+	int bucket;
+
+	if (!start)
+		return;
+
+	atomic_long_inc(&map->stats[item]);
+
+	delta = ktime_get_ns() - start;
+	bucket = delta ? min(ilog2(delta), REGMAP_LAT_BUCKETS - 1) : 0;
+	if (item == REGMAP_STAT_HW_READ)
+		atomic_long_inc(&map->read_lat[bucket]);
+	else
+		atomic_long_inc(&map->write_lat[bucket]);
+}
+
 #else
 static inline void regmap_debugfs_initcall(void) { }
 static inline void regmap_debugfs_init(struct regmap *map, const char *name) { }
 static inline void regmap_debugfs_exit(struct regmap *map) { }
 static inline void regmap_debugfs_disable(struct regmap *map) { }
+
+static inline void regmap_stat_inc(struct regmap *map,
+				   enum regmap_stat_item item) { }
+static inline u64 regmap_stat_start(struct regmap *map) { return 0; }
+static inline void regmap_stat_latency(struct regmap *map,
+				       enum regmap_stat_item item,
+				       u64 start) { }
 #endif
 
 /* regcache core declarations */
@@ -237,6 +302,8 @@ int regcache_init(struct regmap *map, const struct regmap_config *config);
 void regcache_exit(struct regmap *map);
 int regcache_read(struct regmap *map,
 		       unsigned int reg, unsigned int *value);
+int regcache_read_lockless(struct regmap *map,
+			   unsigned int reg, unsigned int *value);
 int regcache_write(struct regmap *map,
 			unsigned int reg, unsigned int value);
 int regcache_sync(struct regmap *map);
@@ -270,6 +337,7 @@ enum regmap_endian regmap_get_val_endian(struct device *dev,
 extern struct regcache_ops regcache_rbtree_ops;
 extern struct regcache_ops regcache_lzo_ops;
 extern struct regcache_ops regcache_flat_ops;
+extern struct regcache_ops regcache_flat_sparse_ops;
 
 static inline const char *regmap_name(const struct regmap *map)
 {
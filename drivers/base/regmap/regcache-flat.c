@@ -6,12 +6,23 @@
 //
 // Author: Mark Brown <broonie@opensource.wolfsonmicro.com>
 
+#include <linux/bitmap.h>
 #include <linux/device.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
 
 #include "internal.h"
 
+/*
+ * The cache is an array indexed by register, with a bitmap recording
+ * which entries hold a value.  Entries are single words updated under
+ * the map lock, so lookups can also be done without it.
+ */
+struct regcache_flat_data {
+	unsigned long *valid;
+	unsigned int data[];
+};
+
 static inline unsigned int regcache_flat_get_index(const struct regmap *map,
 						   unsigned int reg)
 {
@@ -21,31 +32,51 @@ static inline unsigned int regcache_flat_get_index(const struct regmap *map,
 static int regcache_flat_init(struct regmap *map)
 {
 	int i;
-	unsigned int *cache;
+	unsigned int n;
+	struct regcache_flat_data *cache;
 
 	if (!map || map->reg_stride_order < 0 || !map->max_register)
 		return -EINVAL;
 
-	map->cache = kcalloc(regcache_flat_get_index(map, map->max_register)
-			     + 1, sizeof(unsigned int), GFP_KERNEL);
-	if (!map->cache)
+	n = regcache_flat_get_index(map, map->max_register) + 1;
+	cache = kzalloc(struct_size(cache, data, n), GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+
+	cache->valid = bitmap_zalloc(n, GFP_KERNEL);
+	if (!cache->valid) {
+		kfree(cache);
 		return -ENOMEM;
+	}
 
-	cache = map->cache;
+	/*
+	 * The plain flat cache treats every register as cached, reading
+	 * back zero for those without a default; the sparse one goes to
+	 * the hardware until it has seen a value.
+	 */
+	if (map->cache_type == REGCACHE_FLAT)
+		bitmap_fill(cache->valid, n);
 
 	for (i = 0; i < map->num_reg_defaults; i++) {
 		unsigned int reg = map->reg_defaults[i].reg;
 		unsigned int index = regcache_flat_get_index(map, reg);
 
-		cache[index] = map->reg_defaults[i].def;
+		cache->data[index] = map->reg_defaults[i].def;
+		__set_bit(index, cache->valid);
 	}
 
+	map->cache = cache;
+
 	return 0;
 }
 
 static int regcache_flat_exit(struct regmap *map)
 {
-	kfree(map->cache);
+	struct regcache_flat_data *cache = map->cache;
+
+	if (cache)
+		bitmap_free(cache->valid);
+	kfree(cache);
 	map->cache = NULL;
 
 	return 0;
@@ -54,10 +85,15 @@ static int regcache_flat_exit(struct regmap *map)
 static int regcache_flat_read(struct regmap *map,
 			      unsigned int reg, unsigned int *value)
 {
-	unsigned int *cache = map->cache;
+	struct regcache_flat_data *cache = map->cache;
 	unsigned int index = regcache_flat_get_index(map, reg);
 
-	*value = cache[index];
+	if (!test_bit(index, cache->valid))
+		return -ENOENT;
+
+	/* Pairs with the barrier in regcache_flat_write() */
+	smp_rmb();
+	*value = READ_ONCE(cache->data[index]);
 
 	return 0;
 }
@@ -65,10 +101,36 @@ static int regcache_flat_read(struct regmap *map,
 static int regcache_flat_write(struct regmap *map, unsigned int reg,
 			       unsigned int value)
 {
-	unsigned int *cache = map->cache;
+	struct regcache_flat_data *cache = map->cache;
 	unsigned int index = regcache_flat_get_index(map, reg);
 
-	cache[index] = value;
+	WRITE_ONCE(cache->data[index], value);
+	/* Publish the value before marking it valid for lockless readers */
+	smp_mb__before_atomic();
+	set_bit(index, cache->valid);
+
+	return 0;
+}
+
+static int regcache_flat_drop(struct regmap *map, unsigned int min,
+			      unsigned int max)
+{
+	struct regcache_flat_data *cache = map->cache;
+	unsigned int bitmap_min, bitmap_max;
+
+	if (min > max)
+		return -EINVAL;
+
+	/* Nothing past the last register is cached */
+	if (min > map->max_register)
+		return 0;
+	if (max > map->max_register)
+		max = map->max_register;
+
+	bitmap_min = regcache_flat_get_index(map, min);
+	bitmap_max = regcache_flat_get_index(map, max);
+
+	bitmap_clear(cache->valid, bitmap_min, bitmap_max + 1 - bitmap_min);
 
 	return 0;
 }
@@ -76,8 +138,21 @@ static int regcache_flat_write(struct regmap *map, unsigned int reg,
 struct regcache_ops regcache_flat_ops = {
 	.type = REGCACHE_FLAT,
 	.name = "flat",
+	.lockless = true,
+	.init = regcache_flat_init,
+	.exit = regcache_flat_exit,
+	.read = regcache_flat_read,
+	.write = regcache_flat_write,
+	.drop = regcache_flat_drop,
+};
+
+struct regcache_ops regcache_flat_sparse_ops = {
+	.type = REGCACHE_FLAT_S,
+	.name = "flat-sparse",
+	.lockless = true,
 	.init = regcache_flat_init,
 	.exit = regcache_flat_exit,
 	.read = regcache_flat_read,
 	.write = regcache_flat_write,
+	.drop = regcache_flat_drop,
 };
@@ -21,6 +21,7 @@ static const struct regcache_ops *cache_types[] = {
 	&regcache_lzo_ops,
 #endif
 	&regcache_flat_ops,
+	&regcache_flat_sparse_ops,
 };
 
 static int regcache_hw_init(struct regmap *map)
@@ -243,8 +244,10 @@ int regcache_read(struct regmap *map,
 	if (!regmap_volatile(map, reg)) {
 		ret = map->cache_ops->read(map, reg, value);
 
-		if (ret == 0)
+		if (ret == 0) {
+			regmap_stat_inc(map, REGMAP_STAT_CACHE_HIT);
 			trace_regmap_reg_read_cache(map, reg, *value);
+		}
 
 		return ret;
 	}
@@ -252,6 +255,44 @@ int regcache_read(struct regmap *map,
 	return -EINVAL;
 }
 
+/**
+ * regcache_read_lockless - Fetch a register value without taking the map lock
+ *
+ * @map: map to configure.
+ * @reg: The register index.
+ * @value: The value to be returned.
+ *
+ * Only cache types whose lookups are safe against concurrent updates
+ * support this.  Return -EAGAIN if the value could not be provided
+ * this way and the caller should fall back to the locked path.
+ */
+int regcache_read_lockless(struct regmap *map,
+			   unsigned int reg, unsigned int *value)
+{
+	int ret;
+
+	if (!map->cache_ops || !map->cache_ops->lockless)
+		return -EAGAIN;
+
+	if (READ_ONCE(map->cache_bypass))
+		return -EAGAIN;
+
+	if (map->max_register && reg > map->max_register)
+		return -EAGAIN;
+
+	if (regmap_volatile(map, reg))
+		return -EAGAIN;
+
+	ret = map->cache_ops->read(map, reg, value);
+	if (ret)
+		return -EAGAIN;
+
+	regmap_stat_inc(map, REGMAP_STAT_CACHE_HIT);
+	trace_regmap_reg_read_cache(map, reg, *value);
+
+	return 0;
+}
+
 /**
  * regcache_write - Set the value of a given register in the cache.
  *
@@ -305,6 +346,8 @@ static int regcache_default_sync(struct regmap *map, unsigned int min,
 			continue;
 
 		ret = regcache_read(map, reg, &val);
+		if (ret == -ENOENT)
+			continue;
 		if (ret)
 			return ret;
 
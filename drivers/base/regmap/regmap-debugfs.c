@@ -532,6 +532,39 @@ static const struct file_operations regmap_cache_bypass_fops = {
 	.write = regmap_cache_bypass_write_file,
 };
 
+static const char * const regmap_stat_names[REGMAP_NR_STATS] = {
+	[REGMAP_STAT_READ] = "reads",
+	[REGMAP_STAT_WRITE] = "writes",
+	[REGMAP_STAT_CACHE_HIT] = "cache_hits",
+	[REGMAP_STAT_HW_READ] = "hw_reads",
+	[REGMAP_STAT_HW_WRITE] = "hw_writes",
+};
+
+static int regmap_stats_show(struct seq_file *s, void *ignored)
+{
+	struct regmap *map = s->private;
+	int i;
+
+	for (i = 0; i < REGMAP_NR_STATS; i++)
+		seq_printf(s, "%s: %ld\n", regmap_stat_names[i],
+			   atomic_long_read(&map->stats[i]));
+
+	seq_puts(s, "\nlatency_ns hw_reads hw_writes\n");
+	for (i = 0; i < REGMAP_LAT_BUCKETS; i++) {
+		long r = atomic_long_read(&map->read_lat[i]);
+		long w = atomic_long_read(&map->write_lat[i]);
+
+		if (!r && !w)
+			continue;
+
+		seq_printf(s, "%llu %ld %ld\n", 1ULL << i, r, w);
+	}
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(regmap_stats);
+
 void regmap_debugfs_init(struct regmap *map, const char *name)
 {
 	struct rb_node *next;
@@ -628,6 +661,11 @@ void regmap_debugfs_init(struct regmap *map, const char *name)
 				    &regmap_cache_bypass_fops);
 	}
 
+	debugfs_create_bool("stats_enable", 0600, map->debugfs,
+			    &map->stats_enabled);
+	debugfs_create_file("stats", 0400, map->debugfs,
+			    map, &regmap_stats_fops);
+
 	next = rb_first(&map->range_tree);
 	while (next) {
 		range_node = rb_entry(next, struct regmap_range_node, node);
@@ -1761,11 +1761,14 @@ int _regmap_write(struct regmap *map, unsigned int reg,
 		  unsigned int val)
 {
 	int ret;
+	u64 start;
 	void *context = _regmap_map_get_context(map);
 
 	if (!regmap_writeable(map, reg))
 		return -EIO;
 
+	regmap_stat_inc(map, REGMAP_STAT_WRITE);
+
 	if (!map->cache_bypass && !map->defer_caching) {
 		ret = regcache_write(map, reg, val);
 		if (ret != 0)
@@ -1781,7 +1784,11 @@ int _regmap_write(struct regmap *map, unsigned int reg,
 
 	trace_regmap_reg_write(map, reg, val);
 
-	return map->reg_write(context, reg, val);
+	start = regmap_stat_start(map);
+	ret = map->reg_write(context, reg, val);
+	regmap_stat_latency(map, REGMAP_STAT_HW_WRITE, start);
+
+	return ret;
 }
 
 /**
@@ -2516,6 +2523,7 @@ static int _regmap_read(struct regmap *map, unsigned int reg,
 			unsigned int *val)
 {
 	int ret;
+	u64 start;
 	void *context = _regmap_map_get_context(map);
 
 	if (!map->cache_bypass) {
@@ -2530,7 +2538,9 @@ static int _regmap_read(struct regmap *map, unsigned int reg,
 	if (!regmap_readable(map, reg))
 		return -EIO;
 
+	start = regmap_stat_start(map);
 	ret = map->reg_read(context, reg, val);
+	regmap_stat_latency(map, REGMAP_STAT_HW_READ, start);
 	if (ret == 0) {
 		if (regmap_should_log(map))
 			dev_info(map->dev, "%x => %x\n", reg, *val);
@@ -2561,6 +2571,12 @@ int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val)
 	if (!IS_ALIGNED(reg, map->reg_stride))
 		return -EINVAL;
 
+	regmap_stat_inc(map, REGMAP_STAT_READ);
+
+	/* Cache hits on lockless cache types need not wait for the lock */
+	if (!regcache_read_lockless(map, reg, val))
+		return 0;
+
 	map->lock(map->lock_arg);
 
 	ret = _regmap_read(map, reg, val);
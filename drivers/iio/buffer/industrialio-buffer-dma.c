@@ -15,6 +15,7 @@
 #include <linux/iio/buffer.h>
 #include <linux/iio/buffer_impl.h>
 #include <linux/iio/buffer-dma.h>
+#include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
 #include <linux/sizes.h>
 
@@ -89,8 +90,18 @@
  * has special requirements that are not handled by the generic functions. If a
  * driver chooses to overload a callback it has to ensure that the generic
  * callback is called from within the custom callback.
+ *
+ * Instead of read() an application can also use block based access, where it
+ * exchanges blocks with the queue directly. The blocks are allocated on
+ * request and each is exported as a DMA-BUF, which the application can mmap()
+ * or pass on to another device. Dequeued blocks are owned by the application
+ * until it enqueues them again. As long as blocks are allocated the FileIO
+ * blocks are not, and read() is refused.
  */
 
+/* Upper limit on the number of blocks allocated for block based access */
+#define IIO_DMA_BUFFER_MAX_BLOCKS	64
+
 static void iio_buffer_block_release(struct kref *kref)
 {
 	struct iio_dma_buffer_block *block = container_of(kref,
@@ -297,6 +308,10 @@ int iio_dma_buffer_request_update(struct iio_buffer *buffer)
 
 	mutex_lock(&queue->lock);
 
+	/* The application manages the blocks in block mode */
+	if (queue->num_blocks)
+		goto out_unlock;
+
 	/* Allocations are page aligned */
 	if (PAGE_ALIGN(queue->fileio.block_size) == PAGE_ALIGN(size))
 		try_reuse = true;
@@ -491,6 +506,11 @@ int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
 
 	mutex_lock(&queue->lock);
 
+	if (queue->num_blocks) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
 	if (!queue->fileio.active_block) {
 		block = iio_dma_buffer_dequeue(queue);
 		if (block == NULL) {
@@ -556,12 +576,392 @@ size_t iio_dma_buffer_data_available(struct iio_buffer *buf)
 	list_for_each_entry(block, &queue->outgoing, head)
 		data_available += block->size;
 	spin_unlock_irq(&queue->list_lock);
+
+	/*
+	 * In block mode any completed block can be dequeued, regardless of its
+	 * size, so make sure it is enough to reach the watermark.
+	 */
+	if (queue->num_blocks && data_available)
+		data_available = max_t(size_t, data_available, buf->watermark);
 	mutex_unlock(&queue->lock);
 
 	return data_available;
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_data_available);
 
+static struct sg_table *iio_dma_buffer_dmabuf_map(
+	struct dma_buf_attachment *at, enum dma_data_direction dir)
+{
+	struct iio_dma_buffer_block *block = at->dmabuf->priv;
+	struct sg_table *sgt;
+	int ret;
+
+	sgt = kzalloc(sizeof(*sgt), GFP_KERNEL);
+	if (!sgt)
+		return ERR_PTR(-ENOMEM);
+
+	ret = dma_get_sgtable(block->queue->dev, sgt, block->vaddr,
+		block->phys_addr, PAGE_ALIGN(block->size));
+	if (ret < 0)
+		goto err_free_sgt;
+
+	if (!dma_map_sg(at->dev, sgt->sgl, sgt->nents, dir)) {
+		ret = -ENOMEM;
+		goto err_free_table;
+	}
+
+	return sgt;
+
+err_free_table:
+	sg_free_table(sgt);
+err_free_sgt:
+	kfree(sgt);
+	return ERR_PTR(ret);
+}
+
+static void iio_dma_buffer_dmabuf_unmap(struct dma_buf_attachment *at,
+	struct sg_table *sgt, enum dma_data_direction dir)
+{
+	dma_unmap_sg(at->dev, sgt->sgl, sgt->nents, dir);
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static void iio_dma_buffer_dmabuf_release(struct dma_buf *dmabuf)
+{
+	iio_buffer_block_put(dmabuf->priv);
+}
+
+static int iio_dma_buffer_dmabuf_mmap(struct dma_buf *dmabuf,
+	struct vm_area_struct *vma)
+{
+	struct iio_dma_buffer_block *block = dmabuf->priv;
+
+	return dma_mmap_coherent(block->queue->dev, vma, block->vaddr,
+		block->phys_addr, PAGE_ALIGN(block->size));
+}
+
+static void *iio_dma_buffer_dmabuf_kmap(struct dma_buf *dmabuf,
+	unsigned long pgnum)
+{
+	struct iio_dma_buffer_block *block = dmabuf->priv;
+
+	return block->vaddr + pgnum * PAGE_SIZE;
+}
+
+static void *iio_dma_buffer_dmabuf_vmap(struct dma_buf *dmabuf)
+{
+	struct iio_dma_buffer_block *block = dmabuf->priv;
+
+	return block->vaddr;
+}
+
+static const struct dma_buf_ops iio_dma_buffer_dmabuf_ops = {
+	.map_dma_buf = iio_dma_buffer_dmabuf_map,
+	.unmap_dma_buf = iio_dma_buffer_dmabuf_unmap,
+	.release = iio_dma_buffer_dmabuf_release,
+	.mmap = iio_dma_buffer_dmabuf_mmap,
+	.map = iio_dma_buffer_dmabuf_kmap,
+	.vmap = iio_dma_buffer_dmabuf_vmap,
+};
+
+/*
+ * Drops the queue's references to the blocks for block based access, they are
+ * freed once the DMA controller and all users of their DMA-BUF are done. Must
+ * be called with queue->lock held.
+ */
+static void iio_dma_buffer_put_blocks(struct iio_dma_buffer_queue *queue,
+	struct iio_dma_buffer_block **blocks, unsigned int num_blocks)
+{
+	unsigned int i;
+
+	spin_lock_irq(&queue->list_lock);
+	for (i = 0; i < num_blocks; i++)
+		blocks[i]->state = IIO_BLOCK_STATE_DEAD;
+	INIT_LIST_HEAD(&queue->outgoing);
+	spin_unlock_irq(&queue->list_lock);
+
+	INIT_LIST_HEAD(&queue->incoming);
+
+	for (i = 0; i < num_blocks; i++) {
+		dma_buf_put(blocks[i]->dmabuf);
+		iio_buffer_block_put(blocks[i]);
+	}
+	kfree(blocks);
+}
+
+/* Frees the FileIO blocks, must be called with queue->lock held */
+static void iio_dma_buffer_fileio_free(struct iio_dma_buffer_queue *queue)
+{
+	unsigned int i;
+
+	spin_lock_irq(&queue->list_lock);
+	for (i = 0; i < ARRAY_SIZE(queue->fileio.blocks); i++) {
+		if (!queue->fileio.blocks[i])
+			continue;
+		queue->fileio.blocks[i]->state = IIO_BLOCK_STATE_DEAD;
+	}
+	INIT_LIST_HEAD(&queue->outgoing);
+	spin_unlock_irq(&queue->list_lock);
+
+	INIT_LIST_HEAD(&queue->incoming);
+
+	for (i = 0; i < ARRAY_SIZE(queue->fileio.blocks); i++) {
+		if (!queue->fileio.blocks[i])
+			continue;
+		iio_buffer_block_put(queue->fileio.blocks[i]);
+		queue->fileio.blocks[i] = NULL;
+	}
+	queue->fileio.active_block = NULL;
+	queue->fileio.block_size = 0;
+}
+
+static struct iio_dma_buffer_block *iio_dma_buffer_alloc_dmabuf_block(
+	struct iio_dma_buffer_queue *queue, size_t size, unsigned int id)
+{
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct iio_dma_buffer_block *block;
+	struct dma_buf *dmabuf;
+
+	block = iio_dma_buffer_alloc_block(queue, size);
+	if (!block)
+		return NULL;
+
+	block->id = id;
+
+	exp_info.ops = &iio_dma_buffer_dmabuf_ops;
+	exp_info.size = PAGE_ALIGN(size);
+	exp_info.flags = O_RDWR;
+	exp_info.priv = block;
+
+	/* The DMA-BUF holds a reference to the block until it is released */
+	iio_buffer_block_get(block);
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		block->state = IIO_BLOCK_STATE_DEAD;
+		iio_buffer_block_put(block);
+		iio_buffer_block_put(block);
+		return NULL;
+	}
+
+	block->dmabuf = dmabuf;
+
+	return block;
+}
+
+/**
+ * iio_dma_buffer_alloc_blocks() - DMA buffer alloc_blocks callback
+ * @buffer: Buffer to allocate the blocks for
+ * @req: The allocation request
+ *
+ * Should be used as the alloc_blocks callback for iio_buffer_access_ops
+ * struct for DMA buffers. Switches the buffer to block mode, freeing the
+ * blocks used for read().
+ */
+int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
+	struct iio_buffer_block_alloc_req *req)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_block **blocks;
+	unsigned int count, i;
+	int ret = 0;
+
+	if (req->type || !req->size || !req->count)
+		return -EINVAL;
+
+	count = min_t(unsigned int, req->count, IIO_DMA_BUFFER_MAX_BLOCKS);
+
+	mutex_lock(&queue->lock);
+
+	if (queue->num_blocks) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	blocks = kcalloc(count, sizeof(*blocks), GFP_KERNEL);
+	if (!blocks) {
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	for (i = 0; i < count; i++) {
+		blocks[i] = iio_dma_buffer_alloc_dmabuf_block(queue,
+			req->size, i);
+		if (!blocks[i])
+			break;
+	}
+
+	/* Settle for fewer blocks if memory is short, but not for none */
+	if (i == 0) {
+		kfree(blocks);
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	iio_dma_buffer_fileio_free(queue);
+
+	queue->blocks = blocks;
+	queue->num_blocks = i;
+
+	req->count = i;
+	req->id = 0;
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_alloc_blocks);
+
+/**
+ * iio_dma_buffer_free_blocks() - DMA buffer free_blocks callback
+ * @buffer: Buffer to free the blocks of
+ *
+ * Should be used as the free_blocks callback for iio_buffer_access_ops
+ * struct for DMA buffers. Blocks still exported as DMA-BUF stay valid until
+ * those are released, but are no longer part of the buffer.
+ */
+int iio_dma_buffer_free_blocks(struct iio_buffer *buffer)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+
+	mutex_lock(&queue->lock);
+	if (queue->num_blocks) {
+		iio_dma_buffer_put_blocks(queue, queue->blocks,
+			queue->num_blocks);
+		queue->blocks = NULL;
+		queue->num_blocks = 0;
+	}
+	mutex_unlock(&queue->lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_free_blocks);
+
+/**
+ * iio_dma_buffer_export_block() - DMA buffer export_block callback
+ * @buffer: Buffer the block belongs to
+ * @block: Descriptor of the block, the fd and size fields are filled in
+ *
+ * Should be used as the export_block callback for iio_buffer_access_ops
+ * struct for DMA buffers.
+ */
+int iio_dma_buffer_export_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct dma_buf *dmabuf;
+	int ret;
+
+	mutex_lock(&queue->lock);
+
+	if (block->id >= queue->num_blocks) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	dmabuf = queue->blocks[block->id]->dmabuf;
+	get_dma_buf(dmabuf);
+	ret = dma_buf_fd(dmabuf, O_CLOEXEC);
+	if (ret < 0) {
+		dma_buf_put(dmabuf);
+		goto out_unlock;
+	}
+
+	block->fd = ret;
+	block->size = queue->blocks[block->id]->size;
+	ret = 0;
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_export_block);
+
+/**
+ * iio_dma_buffer_enqueue_block() - DMA buffer enqueue_block callback
+ * @buffer: Buffer the block belongs to
+ * @block: Descriptor of the block to enqueue
+ *
+ * Should be used as the enqueue_block callback for iio_buffer_access_ops
+ * struct for DMA buffers. The block must be owned by the application.
+ */
+int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_block *dma_block;
+	int ret = 0;
+
+	if (block->flags || block->reserved)
+		return -EINVAL;
+
+	mutex_lock(&queue->lock);
+
+	if (block->id >= queue->num_blocks) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	dma_block = queue->blocks[block->id];
+	if (dma_block->state != IIO_BLOCK_STATE_DEQUEUED) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	dma_block->bytes_used = 0;
+	iio_dma_buffer_enqueue(queue, dma_block);
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_enqueue_block);
+
+/**
+ * iio_dma_buffer_dequeue_block() - DMA buffer dequeue_block callback
+ * @buffer: Buffer to dequeue the block from
+ * @block: Filled in with the descriptor of the dequeued block
+ *
+ * Should be used as the dequeue_block callback for iio_buffer_access_ops
+ * struct for DMA buffers. Returns -EAGAIN if no block has completed.
+ */
+int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_block *dma_block;
+	int ret = 0;
+
+	mutex_lock(&queue->lock);
+
+	if (!queue->num_blocks) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	dma_block = iio_dma_buffer_dequeue(queue);
+	if (!dma_block) {
+		ret = -EAGAIN;
+		goto out_unlock;
+	}
+
+	block->id = dma_block->id;
+	block->size = dma_block->size;
+	block->bytes_used = dma_block->bytes_used;
+	block->fd = -1;
+	block->flags = 0;
+	block->reserved = 0;
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_dequeue_block);
+
 /**
  * iio_dma_buffer_set_bytes_per_datum() - DMA buffer set_bytes_per_datum callback
  * @buffer: Buffer to set the bytes-per-datum for
@@ -636,28 +1036,15 @@ EXPORT_SYMBOL_GPL(iio_dma_buffer_init);
  */
 void iio_dma_buffer_exit(struct iio_dma_buffer_queue *queue)
 {
-	unsigned int i;
-
 	mutex_lock(&queue->lock);
 
-	spin_lock_irq(&queue->list_lock);
-	for (i = 0; i < ARRAY_SIZE(queue->fileio.blocks); i++) {
-		if (!queue->fileio.blocks[i])
-			continue;
-		queue->fileio.blocks[i]->state = IIO_BLOCK_STATE_DEAD;
-	}
-	INIT_LIST_HEAD(&queue->outgoing);
-	spin_unlock_irq(&queue->list_lock);
-
-	INIT_LIST_HEAD(&queue->incoming);
-
-	for (i = 0; i < ARRAY_SIZE(queue->fileio.blocks); i++) {
-		if (!queue->fileio.blocks[i])
-			continue;
-		iio_buffer_block_put(queue->fileio.blocks[i]);
-		queue->fileio.blocks[i] = NULL;
+	iio_dma_buffer_fileio_free(queue);
+	if (queue->num_blocks) {
+		iio_dma_buffer_put_blocks(queue, queue->blocks,
+			queue->num_blocks);
+		queue->blocks = NULL;
+		queue->num_blocks = 0;
 	}
-	queue->fileio.active_block = NULL;
 	queue->ops = NULL;
 
 	mutex_unlock(&queue->lock);
@@ -180,6 +180,127 @@ __poll_t iio_buffer_poll(struct file *filp,
 	return 0;
 }
 
+static int iio_buffer_alloc_blocks(struct iio_dev *indio_dev,
+				   struct iio_buffer *rb, void __user *p)
+{
+	struct iio_buffer_block_alloc_req req;
+	int ret;
+
+	if (copy_from_user(&req, p, sizeof(req)))
+		return -EFAULT;
+
+	mutex_lock(&indio_dev->mlock);
+	if (iio_buffer_is_active(rb))
+		ret = -EBUSY;
+	else
+		ret = rb->access->alloc_blocks(rb, &req);
+	mutex_unlock(&indio_dev->mlock);
+	if (ret)
+		return ret;
+
+	if (copy_to_user(p, &req, sizeof(req)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int iio_buffer_free_blocks(struct iio_dev *indio_dev,
+				  struct iio_buffer *rb)
+{
+	int ret;
+
+	mutex_lock(&indio_dev->mlock);
+	if (iio_buffer_is_active(rb))
+		ret = -EBUSY;
+	else
+		ret = rb->access->free_blocks(rb);
+	mutex_unlock(&indio_dev->mlock);
+
+	return ret;
+}
+
+static int iio_buffer_dequeue_block(struct iio_dev *indio_dev,
+				    struct file *filp, struct iio_buffer *rb,
+				    struct iio_buffer_block *block)
+{
+	DEFINE_WAIT_FUNC(wait, woken_wake_function);
+	int ret;
+
+	add_wait_queue(&rb->pollq, &wait);
+	for (;;) {
+		if (!indio_dev->info) {
+			ret = -ENODEV;
+			break;
+		}
+
+		ret = rb->access->dequeue_block(rb, block);
+		if (ret != -EAGAIN || (filp->f_flags & O_NONBLOCK))
+			break;
+
+		if (signal_pending(current)) {
+			ret = -ERESTARTSYS;
+			break;
+		}
+
+		wait_woken(&wait, TASK_INTERRUPTIBLE, MAX_SCHEDULE_TIMEOUT);
+	}
+	remove_wait_queue(&rb->pollq, &wait);
+
+	return ret;
+}
+
+/**
+ * iio_buffer_ioctl() - handle the block based buffer access ioctls
+ * @indio_dev:	The IIO device
+ * @filp:	File structure pointer for the char device
+ * @cmd:	The ioctl command
+ * @arg:	The ioctl argument
+ *
+ * Return: 0 on success, -EINVAL if the command is unknown or the buffer
+ *	   does not support block based access, or a negative error code
+ */
+long iio_buffer_ioctl(struct iio_dev *indio_dev, struct file *filp,
+		      unsigned int cmd, unsigned long arg)
+{
+	struct iio_buffer *rb = indio_dev->buffer;
+	void __user *p = (void __user *)arg;
+	struct iio_buffer_block block;
+	int ret;
+
+	if (!rb || !rb->access->alloc_blocks)
+		return -EINVAL;
+
+	switch (cmd) {
+	case IIO_BUFFER_BLOCK_ALLOC_IOCTL:
+		return iio_buffer_alloc_blocks(indio_dev, rb, p);
+	case IIO_BUFFER_BLOCK_FREE_IOCTL:
+		return iio_buffer_free_blocks(indio_dev, rb);
+	case IIO_BUFFER_BLOCK_EXPORT_IOCTL:
+	case IIO_BUFFER_BLOCK_ENQUEUE_IOCTL:
+		if (copy_from_user(&block, p, sizeof(block)))
+			return -EFAULT;
+
+		if (cmd == IIO_BUFFER_BLOCK_ENQUEUE_IOCTL)
+			return rb->access->enqueue_block(rb, &block);
+
+		ret = rb->access->export_block(rb, &block);
+		break;
+	case IIO_BUFFER_BLOCK_DEQUEUE_IOCTL:
+		ret = iio_buffer_dequeue_block(indio_dev, filp, rb, &block);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (ret)
+		return ret;
+
+	if (copy_to_user(p, &block, sizeof(block)))
+		return -EFAULT;
+
+	return 0;
+}
+
 /**
  * iio_buffer_wakeup_poll - Wakes up the buffer waitqueue
  * @indio_dev: The IIO device
@@ -12,6 +12,7 @@
 #define EVDEV_MIN_BUFFER_SIZE	64U
 #define EVDEV_BUF_PACKETS	8
 
+#include <linux/hrtimer.h>
 #include <linux/poll.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
@@ -56,6 +57,25 @@ struct evdev_client {
 	unsigned int clk_type;
 	bool revoked;
 	unsigned long *evmasks[EV_CNT];
+
+	/* wakeup batching, protected by buffer_lock */
+	unsigned int batch_packets;
+	ktime_t batch_timeout;
+	unsigned int pending_packets;
+	bool batch_due;
+	struct hrtimer batch_timer;
+
+	struct input_client_stats stats; /* protected by buffer_lock */
+
+	/* mmap'd ring, replaces buffer once set up; protected by buffer_lock */
+	struct input_ring_header *ring;
+	struct input_ring_event *ring_events;
+	unsigned int ring_size;
+	unsigned int ring_head;		/* next slot to write */
+	unsigned int ring_published;	/* head as last published */
+	bool ring_skip;			/* dropping the rest of a packet */
+	bool ring_resync;		/* SYN_DROPPED owed */
+
 	unsigned int bufsize;
 	struct input_event buffer[];
 };
@@ -114,6 +134,10 @@ static void __evdev_flush_queue(struct evdev_client *client, unsigned int type)
 
 	BUG_ON(type == EV_SYN);
 
+	/* events already in the mmap'd ring belong to userspace */
+	if (client->ring)
+		return;
+
 	head = client->tail;
 	client->packet_head = client->tail;
 
@@ -153,6 +177,11 @@ static void __evdev_queue_syn_dropped(struct evdev_client *client)
 	ktime_t time;
 	struct timespec64 ts;
 
+	if (client->ring) {
+		client->ring_resync = true;
+		return;
+	}
+
 	time = client->clk_type == EV_CLK_REAL ?
 			ktime_get_real() :
 			client->clk_type == EV_CLK_MONO ?
@@ -225,6 +254,188 @@ static int evdev_set_clk_type(struct evdev_client *client, unsigned int clkid)
 	return 0;
 }
 
+/* caller must hold client->buffer_lock */
+static bool __evdev_packets_queued(struct evdev_client *client)
+{
+	if (client->ring)
+		return client->ring_published !=
+			smp_load_acquire(&client->ring->tail);
+
+	return client->packet_head != client->tail;
+}
+
+/*
+ * Whether the packet being built holds no events, so that its SYN_REPORT
+ * can be dropped.  A pending SYN_DROPPED on the ring counts as an event.
+ * Caller must hold client->buffer_lock.
+ */
+static bool __evdev_packet_empty(struct evdev_client *client)
+{
+	if (client->ring)
+		return client->ring_head == client->ring_published &&
+		       !client->ring_resync;
+
+	return client->packet_head == client->head;
+}
+
+/* whether readers of @client should see it as readable */
+static bool evdev_client_ready(struct evdev_client *client)
+{
+	bool queued;
+
+	if (client->ring)
+		queued = READ_ONCE(client->ring_published) !=
+			 READ_ONCE(client->ring->tail);
+	else
+		queued = client->packet_head != client->tail;
+
+	return queued && (client->batch_packets <= 1 ||
+			  READ_ONCE(client->batch_due));
+}
+
+/*
+ * Account a completed packet for wakeup batching; returns true if readers
+ * should be woken.  Caller must hold client->buffer_lock and call this
+ * before the packet is published.
+ */
+static bool __evdev_batch_packet(struct evdev_client *client)
+{
+	if (client->batch_packets <= 1) {
+		client->stats.wakeups++;
+		return true;
+	}
+
+	/* the reader caught up, start a new batch */
+	if (!__evdev_packets_queued(client)) {
+		client->pending_packets = 0;
+		client->batch_due = false;
+	}
+
+	if (client->batch_due)
+		return false;
+
+	if (++client->pending_packets >= client->batch_packets) {
+		hrtimer_try_to_cancel(&client->batch_timer);
+		client->batch_due = true;
+		client->stats.wakeups++;
+		return true;
+	}
+
+	if (client->pending_packets == 1 && client->batch_timeout)
+		hrtimer_start(&client->batch_timer, client->batch_timeout,
+			      HRTIMER_MODE_REL);
+
+	return false;
+}
+
+static enum hrtimer_restart evdev_batch_timer_fn(struct hrtimer *timer)
+{
+	struct evdev_client *client =
+		container_of(timer, struct evdev_client, batch_timer);
+	unsigned long flags;
+	bool wakeup = false;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	if (!client->batch_due && __evdev_packets_queued(client)) {
+		client->batch_due = true;
+		client->stats.wakeups++;
+		wakeup = true;
+	}
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	if (wakeup) {
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+		wake_up_interruptible(&client->evdev->wait);
+	}
+
+	return HRTIMER_NORESTART;
+}
+
+static int evdev_set_batch(struct evdev_client *client,
+			   const struct input_batch *batch)
+{
+	if (batch->timeout_us > USEC_PER_SEC)
+		return -EINVAL;
+
+	hrtimer_cancel(&client->batch_timer);
+
+	spin_lock_irq(&client->buffer_lock);
+	client->batch_packets = batch->packets;
+	client->batch_timeout = us_to_ktime(batch->timeout_us);
+	client->pending_packets = 0;
+	/* don't hold back what is already queued */
+	client->batch_due = true;
+	spin_unlock_irq(&client->buffer_lock);
+
+	wake_up_interruptible(&client->evdev->wait);
+
+	return 0;
+}
+
+static bool __ring_put(struct evdev_client *client,
+		       const struct input_event *event,
+		       unsigned int type, unsigned int code, int value)
+{
+	struct input_ring_event *rev;
+
+	/* the tail is written by userspace, only trust it for the fill level */
+	if (client->ring_head - smp_load_acquire(&client->ring->tail) >=
+	    client->ring_size)
+		return false;
+
+	rev = &client->ring_events[client->ring_head & (client->ring_size - 1)];
+	rev->sec = event->input_event_sec;
+	rev->usec = event->input_event_usec;
+	rev->type = type;
+	rev->code = code;
+	rev->value = value;
+	rev->reserved = 0;
+	client->ring_head++;
+
+	return true;
+}
+
+static void __pass_event_ring(struct evdev_client *client,
+			      const struct input_event *event)
+{
+	bool report = event->type == EV_SYN && event->code == SYN_REPORT;
+	unsigned int n;
+
+	if (client->ring_skip) {
+		client->stats.dropped++;
+		client->ring->dropped++;
+		client->ring_skip = !report;
+		return;
+	}
+
+	if (client->ring_resync && client->ring_head == client->ring_published) {
+		if (!__ring_put(client, event, EV_SYN, SYN_DROPPED, 0))
+			goto full;
+		client->ring_resync = false;
+	}
+
+	if (!__ring_put(client, event, event->type, event->code, event->value))
+		goto full;
+
+	if (report) {
+		/* events before the new head are visible once it is */
+		smp_store_release(&client->ring->head, client->ring_head);
+		client->ring_published = client->ring_head;
+	}
+	return;
+
+full:
+	/* drop the whole packet, and have the next one say so */
+	n = client->ring_head - client->ring_published + 1;
+	client->stats.dropped += n;
+	client->ring->dropped += n;
+	if (!client->ring_resync)
+		client->stats.overflows++;
+	client->ring_head = client->ring_published;
+	client->ring_resync = true;
+	client->ring_skip = !report;
+}
+
 static void __pass_event(struct evdev_client *client,
 			 const struct input_event *event)
 {
@@ -247,12 +458,13 @@ static void __pass_event(struct evdev_client *client,
 		client->buffer[client->tail].value = 0;
 
 		client->packet_head = client->tail;
+
+		client->stats.dropped += client->bufsize - 1;
+		client->stats.overflows++;
 	}
 
-	if (event->type == EV_SYN && event->code == SYN_REPORT) {
+	if (event->type == EV_SYN && event->code == SYN_REPORT)
 		client->packet_head = client->head;
-		kill_fasync(&client->fasync, SIGIO, POLL_IN);
-	}
 }
 
 static void evdev_pass_values(struct evdev_client *client,
@@ -281,22 +493,29 @@ static void evdev_pass_values(struct evdev_client *client,
 
 		if (v->type == EV_SYN && v->code == SYN_REPORT) {
 			/* drop empty SYN_REPORT */
-			if (client->packet_head == client->head)
+			if (__evdev_packet_empty(client))
 				continue;
 
-			wakeup = true;
+			if (__evdev_batch_packet(client))
+				wakeup = true;
 		}
 
 		event.type = v->type;
 		event.code = v->code;
 		event.value = v->value;
-		__pass_event(client, &event);
+		client->stats.events++;
+		if (client->ring)
+			__pass_event_ring(client, &event);
+		else
+			__pass_event(client, &event);
 	}
 
 	spin_unlock(&client->buffer_lock);
 
-	if (wakeup)
+	if (wakeup) {
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
 		wake_up_interruptible(&evdev->wait);
+	}
 }
 
 /*
@@ -476,10 +695,12 @@ static int evdev_release(struct inode *inode, struct file *file)
 	mutex_unlock(&evdev->mutex);
 
 	evdev_detach_client(evdev, client);
+	hrtimer_cancel(&client->batch_timer);
 
 	for (i = 0; i < EV_CNT; ++i)
 		bitmap_free(client->evmasks[i]);
 
+	vfree(client->ring);
 	kvfree(client);
 
 	evdev_close_device(evdev);
@@ -512,6 +733,8 @@ static int evdev_open(struct inode *inode, struct file *file)
 
 	client->bufsize = bufsize;
 	spin_lock_init(&client->buffer_lock);
+	hrtimer_init(&client->batch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	client->batch_timer.function = evdev_batch_timer_fn;
 	client->evdev = evdev;
 	evdev_attach_client(evdev, client);
 
@@ -602,6 +825,10 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 		if (!evdev->exist || client->revoked)
 			return -ENODEV;
 
+		/* once the ring is mapped events are only delivered there */
+		if (READ_ONCE(client->ring))
+			return -EBUSY;
+
 		if (client->packet_head == client->tail &&
 		    (file->f_flags & O_NONBLOCK))
 			return -EAGAIN;
@@ -627,7 +854,7 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 
 		if (!(file->f_flags & O_NONBLOCK)) {
 			error = wait_event_interruptible(evdev->wait,
-					client->packet_head != client->tail ||
+					evdev_client_ready(client) ||
 					!evdev->exist || client->revoked);
 			if (error)
 				return error;
@@ -651,12 +878,80 @@ static __poll_t evdev_poll(struct file *file, poll_table *wait)
 	else
 		mask = EPOLLHUP | EPOLLERR;
 
-	if (client->packet_head != client->tail)
+	if (evdev_client_ready(client))
 		mask |= EPOLLIN | EPOLLRDNORM;
 
 	return mask;
 }
 
+/*
+ * Map a ring of input_ring_event behind a header page; see the comment
+ * above struct input_ring_header.  The ring replaces the client's queue
+ * for the rest of its life.
+ */
+static int evdev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct evdev_client *client = file->private_data;
+	struct evdev *evdev = client->evdev;
+	unsigned long len = vma->vm_end - vma->vm_start;
+	struct input_ring_header *ring;
+	unsigned int n;
+	int error;
+
+	if (!(vma->vm_flags & VM_SHARED) || vma->vm_pgoff != 0 ||
+	    len <= PAGE_SIZE)
+		return -EINVAL;
+
+	n = (len - PAGE_SIZE) / sizeof(struct input_ring_event);
+	if (n < 2 || n > SZ_1M)
+		return -EINVAL;
+	n = rounddown_pow_of_two(n);
+
+	error = mutex_lock_interruptible(&evdev->mutex);
+	if (error)
+		return error;
+
+	if (!evdev->exist || client->revoked) {
+		error = -ENODEV;
+		goto out;
+	}
+
+	if (client->ring) {
+		error = -EBUSY;
+		goto out;
+	}
+
+	ring = vmalloc_user(len);
+	if (!ring) {
+		error = -ENOMEM;
+		goto out;
+	}
+
+	error = remap_vmalloc_range(vma, ring, 0);
+	if (error) {
+		vfree(ring);
+		goto out;
+	}
+
+	ring->size = n;
+	ring->offset = PAGE_SIZE;
+
+	spin_lock_irq(&client->buffer_lock);
+	client->ring_events = (void *)ring + PAGE_SIZE;
+	client->ring_size = n;
+	client->ring_head = client->ring_published = 0;
+	/* what was queued for read() is lost, say so in the ring */
+	client->ring_resync = client->head != client->tail;
+	client->ring_skip = false;
+	client->packet_head = client->head = client->tail;
+	client->ring = ring;
+	spin_unlock_irq(&client->buffer_lock);
+
+ out:
+	mutex_unlock(&evdev->mutex);
+	return error;
+}
+
 #ifdef CONFIG_COMPAT
 
 #define BITS_PER_LONG_COMPAT (sizeof(compat_long_t) * 8)
@@ -947,6 +1242,17 @@ static int evdev_handle_get_val(struct evdev_client *client,
 	return ret;
 }
 
+static int evdev_get_stats(struct evdev_client *client, void __user *p)
+{
+	struct input_client_stats stats;
+
+	spin_lock_irq(&client->buffer_lock);
+	stats = client->stats;
+	spin_unlock_irq(&client->buffer_lock);
+
+	return copy_to_user(p, &stats, sizeof(stats)) ? -EFAULT : 0;
+}
+
 static int evdev_handle_mt_request(struct input_dev *dev,
 				   unsigned int size,
 				   int __user *ip)
@@ -1156,6 +1462,18 @@ static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 
 		return evdev_set_clk_type(client, i);
 
+	case EVIOCSBATCH: {
+		struct input_batch batch;
+
+		if (copy_from_user(&batch, p, sizeof(batch)))
+			return -EFAULT;
+
+		return evdev_set_batch(client, &batch);
+	}
+
+	case EVIOCGSTATS:
+		return evdev_get_stats(client, p);
+
 	case EVIOCGKEYCODE:
 		return evdev_handle_get_keycode(dev, p);
 
@@ -1325,6 +1643,7 @@ static const struct file_operations evdev_fops = {
 	.read		= evdev_read,
 	.write		= evdev_write,
 	.poll		= evdev_poll,
+	.mmap		= evdev_mmap,
 	.open		= evdev_open,
 	.release	= evdev_release,
 	.unlocked_ioctl	= evdev_ioctl,
@@ -27,6 +27,7 @@
 struct m25p {
 	struct spi_mem		*spimem;
 	struct spi_nor		spi_nor;
+	struct spi_mem_dirmap_desc *rdesc;
 };
 
 static int m25p80_read_reg(struct spi_nor *nor, u8 code, u8 *val, int len)
@@ -108,6 +109,24 @@ static ssize_t m25p80_write(struct spi_nor *nor, loff_t to, size_t len,
 	return op.data.nbytes;
 }
 
+static void m25p80_read_op(struct spi_nor *nor, struct spi_mem_op *op)
+{
+	*op = (struct spi_mem_op)
+		SPI_MEM_OP(SPI_MEM_OP_CMD(nor->read_opcode, 1),
+			   SPI_MEM_OP_ADDR(nor->addr_width, 0, 1),
+			   SPI_MEM_OP_DUMMY(nor->read_dummy, 1),
+			   SPI_MEM_OP_DATA_IN(0, NULL, 1));
+
+	/* get transfer protocols. */
+	op->cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
+	op->addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
+	op->dummy.buswidth = op->addr.buswidth;
+	op->data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+
+	/* convert the dummy cycles to the number of bytes */
+	op->dummy.nbytes = (nor->read_dummy * op->dummy.buswidth) / 8;
+}
+
 /*
  * Read an address range from the nor chip.  The address range
  * may be any size provided it is within the physical boundaries.
@@ -116,22 +135,21 @@ static ssize_t m25p80_read(struct spi_nor *nor, loff_t from, size_t len,
 			   u_char *buf)
 {
 	struct m25p *flash = nor->priv;
-	struct spi_mem_op op =
-			SPI_MEM_OP(SPI_MEM_OP_CMD(nor->read_opcode, 1),
-				   SPI_MEM_OP_ADDR(nor->addr_width, from, 1),
-				   SPI_MEM_OP_DUMMY(nor->read_dummy, 1),
-				   SPI_MEM_OP_DATA_IN(len, buf, 1));
+	struct spi_mem_op op;
 	size_t remaining = len;
 	int ret;
 
-	/* get transfer protocols. */
-	op.cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
-	op.addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
-	op.dummy.buswidth = op.addr.buswidth;
-	op.data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+	/*
+	 * The direct mapping lets the controller use its memory-mapped or
+	 * DMA read path, and falls back to the largest regular transfers the
+	 * controller accepts when it has neither.
+	 */
+	if (flash->rdesc)
+		return spi_mem_dirmap_read(flash->rdesc, from, len, buf);
 
-	/* convert the dummy cycles to the number of bytes */
-	op.dummy.nbytes = (nor->read_dummy * op.dummy.buswidth) / 8;
+	m25p80_read_op(nor, &op);
+	op.addr.val = from;
+	op.data.buf.in = buf;
 
 	while (remaining) {
 		op.data.nbytes = remaining < UINT_MAX ? remaining : UINT_MAX;
@@ -151,6 +169,31 @@ static ssize_t m25p80_read(struct spi_nor *nor, loff_t from, size_t len,
 	return len;
 }
 
+static void m25p_create_read_dirmap(struct m25p *flash)
+{
+	struct spi_nor *nor = &flash->spi_nor;
+	struct spi_mem_dirmap_info info = {
+		.offset = 0,
+		.length = nor->mtd.size,
+	};
+	struct spi_mem_dirmap_desc *desc;
+
+	/* Addresses are remapped on the fly for these, see spi_nor_read() */
+	if (nor->flags & SNOR_F_S3AN_ADDR_DEFAULT)
+		return;
+
+	m25p80_read_op(nor, &info.op_tmpl);
+	desc = devm_spi_mem_dirmap_create(&flash->spimem->spi->dev,
+					  flash->spimem, &info);
+	if (IS_ERR(desc)) {
+		dev_dbg(nor->dev, "no read direct mapping: %ld\n",
+			PTR_ERR(desc));
+		return;
+	}
+
+	flash->rdesc = desc;
+}
+
 /*
  * board specific setup should have ensured the SPI clock used here
  * matches what the READ command supports, at least until this driver
@@ -234,6 +277,8 @@ static int m25p_probe(struct spi_mem *spimem)
 	if (ret)
 		return ret;
 
+	m25p_create_read_dirmap(flash);
+
 	return mtd_device_register(&nor->mtd, data ? data->parts : NULL,
 				   data ? data->nr_parts : 0);
 }
@@ -29,6 +29,7 @@
 #include <linux/kernel.h>
 #include <linux/slab.h>
 #include <linux/major.h>
+#include <linux/math64.h>
 #include "ubi.h"
 
 /* Maximum length of the 'mtd=' parameter */
@@ -140,6 +141,18 @@ static struct device_attribute dev_mtd_num =
 	__ATTR(mtd_num, S_IRUGO, dev_attribute_show, NULL);
 static struct device_attribute dev_ro_mode =
 	__ATTR(ro_mode, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_wl_moves =
+	__ATTR(wl_moves, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_wl_moved_bytes =
+	__ATTR(wl_moved_bytes, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_wl_yields =
+	__ATTR(wl_yields, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_wl_max_move_us =
+	__ATTR(wl_max_move_us, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_read_avg_us =
+	__ATTR(read_avg_us, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_read_max_us =
+	__ATTR(read_max_us, S_IRUGO, dev_attribute_show, NULL);
 
 /**
  * ubi_volume_notify - send a volume change notification.
@@ -378,6 +391,24 @@ static ssize_t dev_attribute_show(struct device *dev,
 		ret = sprintf(buf, "%d\n", ubi->mtd->index);
 	else if (attr == &dev_ro_mode)
 		ret = sprintf(buf, "%d\n", ubi->ro_mode);
+	else if (attr == &dev_wl_moves)
+		ret = sprintf(buf, "%llu\n", ubi->wl_moves);
+	else if (attr == &dev_wl_moved_bytes)
+		ret = sprintf(buf, "%llu\n", ubi->wl_moved_bytes);
+	else if (attr == &dev_wl_yields)
+		ret = sprintf(buf, "%lu\n", ubi->wl_yields);
+	else if (attr == &dev_wl_max_move_us)
+		ret = sprintf(buf, "%u\n", ubi->wl_max_move_us);
+	else if (attr == &dev_read_avg_us) {
+		unsigned long long avg = 0;
+
+		spin_lock(&ubi->stats_lock);
+		if (ubi->read_count)
+			avg = div64_u64(ubi->read_total_us, ubi->read_count);
+		spin_unlock(&ubi->stats_lock);
+		ret = sprintf(buf, "%llu\n", avg);
+	} else if (attr == &dev_read_max_us)
+		ret = sprintf(buf, "%u\n", ubi->read_max_us);
 	else
 		ret = -EINVAL;
 
@@ -398,6 +429,12 @@ static struct attribute *ubi_dev_attrs[] = {
 	&dev_bgt_enabled.attr,
 	&dev_mtd_num.attr,
 	&dev_ro_mode.attr,
+	&dev_wl_moves.attr,
+	&dev_wl_moved_bytes.attr,
+	&dev_wl_yields.attr,
+	&dev_wl_max_move_us.attr,
+	&dev_read_avg_us.attr,
+	&dev_read_max_us.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(ubi_dev);
@@ -923,6 +960,8 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	mutex_init(&ubi->ckvol_mutex);
 	mutex_init(&ubi->device_mutex);
 	spin_lock_init(&ubi->volumes_lock);
+	spin_lock_init(&ubi->stats_lock);
+	init_waitqueue_head(&ubi->fg_io_wait);
 	init_rwsem(&ubi->fm_protect);
 	init_rwsem(&ubi->fm_eba_sem);
 
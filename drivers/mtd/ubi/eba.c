@@ -31,6 +31,7 @@
 #include <linux/slab.h>
 #include <linux/crc32.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
 #include "ubi.h"
 
 /* Number of physical eraseblocks reserved for atomic LEB change operation */
@@ -574,42 +575,20 @@ static int check_mapping(struct ubi_device *ubi, struct ubi_volume *vol, int lnu
 }
 #endif
 
-/**
- * ubi_eba_read_leb - read data.
- * @ubi: UBI device description object
- * @vol: volume description object
- * @lnum: logical eraseblock number
- * @buf: buffer to store the read data
- * @offset: offset from where to read
- * @len: how many bytes to read
- * @check: data CRC check flag
- *
- * If the logical eraseblock @lnum is unmapped, @buf is filled with 0xFF
- * bytes. The @check flag only makes sense for static volumes and forces
- * eraseblock data CRC checking.
- *
- * In case of success this function returns zero. In case of a static volume,
- * if data CRC mismatches - %-EBADMSG is returned. %-EBADMSG may also be
- * returned for any volume type if an ECC error was detected by the MTD device
- * driver. Other negative error cored may be returned in case of other errors.
- */
-int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
-		     void *buf, int offset, int len, int check)
+/* The actual read, done under the LEB read lock, see 'ubi_eba_read_leb()' */
+static int do_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
+		       void *buf, int offset, int len, int check)
 {
 	int err, pnum, scrub = 0, vol_id = vol->vol_id;
 	struct ubi_vid_io_buf *vidb;
 	struct ubi_vid_hdr *vid_hdr;
 	uint32_t uninitialized_var(crc);
 
-	err = leb_read_lock(ubi, vol_id, lnum);
-	if (err)
-		return err;
-
 	pnum = vol->eba_tbl->entries[lnum].pnum;
 	if (pnum >= 0) {
 		err = check_mapping(ubi, vol, lnum, &pnum);
 		if (err < 0)
-			goto out_unlock;
+			return err;
 	}
 
 	if (pnum == UBI_LEB_UNMAPPED) {
@@ -620,7 +599,6 @@ int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 		 */
 		dbg_eba("read %d bytes from offset %d of LEB %d:%d (unmapped)",
 			len, offset, vol_id, lnum);
-		leb_read_unlock(ubi, vol_id, lnum);
 		ubi_assert(vol->vol_type != UBI_STATIC_VOLUME);
 		memset(buf, 0xFF, len);
 		return 0;
@@ -635,10 +613,8 @@ int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 retry:
 	if (check) {
 		vidb = ubi_alloc_vid_buf(ubi, GFP_NOFS);
-		if (!vidb) {
-			err = -ENOMEM;
-			goto out_unlock;
-		}
+		if (!vidb)
+			return -ENOMEM;
 
 		vid_hdr = ubi_get_vid_hdr(vidb);
 
@@ -697,7 +673,7 @@ int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 			scrub = 1;
 		else if (mtd_is_eccerr(err)) {
 			if (vol->vol_type == UBI_DYNAMIC_VOLUME)
-				goto out_unlock;
+				return err;
 			scrub = 1;
 			if (!check) {
 				ubi_msg(ubi, "force data checking");
@@ -705,7 +681,7 @@ int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 				goto retry;
 			}
 		} else
-			goto out_unlock;
+			return err;
 	}
 
 	if (check) {
@@ -713,21 +689,69 @@ int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 		if (crc1 != crc) {
 			ubi_warn(ubi, "CRC error: calculated %#08x, must be %#08x",
 				 crc1, crc);
-			err = -EBADMSG;
-			goto out_unlock;
+			return -EBADMSG;
 		}
 	}
 
 	if (scrub)
 		err = ubi_wl_scrub_peb(ubi, pnum);
 
-	leb_read_unlock(ubi, vol_id, lnum);
 	return err;
 
 out_free:
 	ubi_free_vid_buf(vidb);
-out_unlock:
-	leb_read_unlock(ubi, vol_id, lnum);
+	return err;
+}
+
+/**
+ * ubi_eba_read_leb - read data.
+ * @ubi: UBI device description object
+ * @vol: volume description object
+ * @lnum: logical eraseblock number
+ * @buf: buffer to store the read data
+ * @offset: offset from where to read
+ * @len: how many bytes to read
+ * @check: data CRC check flag
+ *
+ * If the logical eraseblock @lnum is unmapped, @buf is filled with 0xFF
+ * bytes. The @check flag only makes sense for static volumes and forces
+ * eraseblock data CRC checking.
+ *
+ * In case of success this function returns zero. In case of a static volume,
+ * if data CRC mismatches - %-EBADMSG is returned. %-EBADMSG may also be
+ * returned for any volume type if an ECC error was detected by the MTD device
+ * driver. Other negative error cored may be returned in case of other errors.
+ */
+int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
+		     void *buf, int offset, int len, int check)
+{
+	ktime_t start = ktime_get();
+	unsigned int us;
+	int err;
+
+	err = leb_read_lock(ubi, vol->vol_id, lnum);
+	if (err)
+		return err;
+
+	/*
+	 * Only count the read once it holds the LEB lock: a move holds the
+	 * lock of the LEB it copies, and must not wait for a read that is
+	 * itself waiting for the move.
+	 */
+	atomic_inc(&ubi->fg_io_count);
+	err = do_read_leb(ubi, vol, lnum, buf, offset, len, check);
+	if (atomic_dec_and_test(&ubi->fg_io_count))
+		wake_up(&ubi->fg_io_wait);
+	leb_read_unlock(ubi, vol->vol_id, lnum);
+
+	us = ktime_us_delta(ktime_get(), start);
+	spin_lock(&ubi->stats_lock);
+	ubi->read_count += 1;
+	ubi->read_total_us += us;
+	if (us > ubi->read_max_us)
+		ubi->read_max_us = us;
+	spin_unlock(&ubi->stats_lock);
+
 	return err;
 }
 
@@ -1285,6 +1309,77 @@ static int is_error_sane(int err)
 	return 1;
 }
 
+/*
+ * Eraseblock moves are done by the background thread and read and write the
+ * whole eraseblock. To not hold the flash for that long in one go, they are
+ * split into chunks of %UBI_MOVE_CHUNK bytes, and between two chunks the move
+ * waits for foreground reads to finish, for at most %UBI_MOVE_MAX_YIELD_MS
+ * per move.
+ */
+#define UBI_MOVE_CHUNK		(16 * 1024)
+#define UBI_MOVE_MAX_YIELD_MS	50
+
+static int move_chunk_size(const struct ubi_device *ubi)
+{
+	return max(ubi->min_io_size,
+		   round_down(UBI_MOVE_CHUNK, ubi->min_io_size));
+}
+
+static void move_yield(struct ubi_device *ubi, unsigned long deadline)
+{
+	long timeout = deadline - jiffies;
+
+	if (!atomic_read(&ubi->fg_io_count) || timeout <= 0)
+		return;
+
+	wait_event_timeout(ubi->fg_io_wait, !atomic_read(&ubi->fg_io_count),
+			   timeout);
+
+	spin_lock(&ubi->stats_lock);
+	ubi->wl_yields += 1;
+	spin_unlock(&ubi->stats_lock);
+}
+
+static int move_read_data(struct ubi_device *ubi, void *buf, int pnum,
+			  int len, unsigned long deadline)
+{
+	int offs, chunk = move_chunk_size(ubi), ret = 0;
+
+	for (offs = 0; offs < len; offs += chunk) {
+		int err = ubi_io_read_data(ubi, buf + offs, pnum, offs,
+					   min(chunk, len - offs));
+
+		if (err == UBI_IO_BITFLIPS)
+			ret = err;
+		else if (err)
+			return err;
+
+		cond_resched();
+		move_yield(ubi, deadline);
+	}
+
+	return ret;
+}
+
+static int move_write_data(struct ubi_device *ubi, const void *buf, int pnum,
+			   int len, unsigned long deadline)
+{
+	int offs, chunk = move_chunk_size(ubi);
+
+	for (offs = 0; offs < len; offs += chunk) {
+		int err = ubi_io_write_data(ubi, buf + offs, pnum, offs,
+					    min(chunk, len - offs));
+
+		if (err)
+			return err;
+
+		cond_resched();
+		move_yield(ubi, deadline);
+	}
+
+	return 0;
+}
+
 /**
  * ubi_eba_copy_leb - copy logical eraseblock.
  * @ubi: UBI device description object
@@ -1306,6 +1401,9 @@ int ubi_eba_copy_leb(struct ubi_device *ubi, int from, int to,
 	struct ubi_vid_hdr *vid_hdr = ubi_get_vid_hdr(vidb);
 	struct ubi_volume *vol;
 	uint32_t crc;
+	ktime_t start = ktime_get();
+	unsigned long deadline;
+	unsigned int us;
 
 	ubi_assert(rwsem_is_locked(&ubi->fm_eba_sem));
 
@@ -1378,7 +1476,8 @@ int ubi_eba_copy_leb(struct ubi_device *ubi, int from, int to,
 	 */
 	mutex_lock(&ubi->buf_mutex);
 	dbg_wl("read %d bytes of data", aldata_size);
-	err = ubi_io_read_data(ubi, ubi->peb_buf, from, 0, aldata_size);
+	deadline = jiffies + msecs_to_jiffies(UBI_MOVE_MAX_YIELD_MS);
+	err = move_read_data(ubi, ubi->peb_buf, from, aldata_size, deadline);
 	if (err && err != UBI_IO_BITFLIPS) {
 		ubi_warn(ubi, "error %d while reading data from PEB %d",
 			 err, from);
@@ -1440,19 +1539,26 @@ int ubi_eba_copy_leb(struct ubi_device *ubi, int from, int to,
 	}
 
 	if (data_size > 0) {
-		err = ubi_io_write_data(ubi, ubi->peb_buf, to, 0, aldata_size);
+		err = move_write_data(ubi, ubi->peb_buf, to, aldata_size,
+				      deadline);
 		if (err) {
 			if (err == -EIO)
 				err = MOVE_TARGET_WR_ERR;
 			goto out_unlock_buf;
 		}
-
-		cond_resched();
 	}
 
 	ubi_assert(vol->eba_tbl->entries[lnum].pnum == from);
 	vol->eba_tbl->entries[lnum].pnum = to;
 
+	us = ktime_us_delta(ktime_get(), start);
+	spin_lock(&ubi->stats_lock);
+	ubi->wl_moves += 1;
+	ubi->wl_moved_bytes += aldata_size;
+	if (us > ubi->wl_max_move_us)
+		ubi->wl_max_move_us = us;
+	spin_unlock(&ubi->stats_lock);
+
 out_unlock_buf:
 	mutex_unlock(&ubi->buf_mutex);
 out_unlock_leb:
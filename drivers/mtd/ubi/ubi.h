@@ -552,6 +552,18 @@ struct ubi_debug_info {
  * @buf_mutex: protects @peb_buf
  * @ckvol_mutex: serializes static volume checking when opening
  *
+ * @fg_io_count: count of foreground reads in progress
+ * @fg_io_wait: background eraseblock copies wait here for @fg_io_count to
+ *		drop to zero
+ * @stats_lock: protects the statistics below
+ * @wl_moves: count of eraseblocks moved by the background thread
+ * @wl_moved_bytes: amount of data copied by those moves
+ * @wl_yields: how many times a move waited for foreground reads
+ * @wl_max_move_us: longest time an eraseblock move took
+ * @read_count: count of foreground reads
+ * @read_total_us: total time spent in foreground reads
+ * @read_max_us: longest foreground read
+ *
  * @dbg: debugging information for this UBI device
  */
 struct ubi_device {
@@ -650,6 +662,17 @@ struct ubi_device {
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
 
+	atomic_t fg_io_count;
+	wait_queue_head_t fg_io_wait;
+	spinlock_t stats_lock;
+	unsigned long long wl_moves;
+	unsigned long long wl_moved_bytes;
+	unsigned long wl_yields;
+	unsigned int wl_max_move_us;
+	unsigned long long read_count;
+	unsigned long long read_total_us;
+	unsigned int read_max_us;
+
 	struct ubi_debug_info dbg;
 };
 
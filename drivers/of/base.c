@@ -20,6 +20,8 @@
 #include <linux/console.h>
 #include <linux/ctype.h>
 #include <linux/cpu.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
@@ -124,16 +126,88 @@ int __weak of_node_to_nid(struct device_node *np)
 #endif
 
 /*
- * Assumptions behind phandle_cache implementation:
- *   - phandle property values are in a contiguous range of 1..n
- *
- * If the assumptions do not hold, then
- *   - the phandle lookup overhead reduction provided by the cache
- *     will likely be less
+ * The phandle cache is an open addressing hash table, sized to twice the
+ * number of phandles in the live tree, holding a reference to every node
+ * that has a phandle.  Nodes attached later are added while the load factor
+ * allows.  Nodes can also reach the live tree without __of_attach_node(),
+ * so a lookup that misses in the table still falls back to walking the
+ * tree, and caches what it finds.
  */
 
 static struct device_node **phandle_cache;
 static u32 phandle_cache_mask;
+static u32 phandle_cache_bits;
+static u32 phandle_cache_used;
+/* set by of_free_phandle_cache(), stops the cache being rebuilt on lookup */
+static bool phandle_cache_disabled;
+
+/* lookup statistics, protected by devtree_lock */
+static unsigned long phandle_lookups;
+static unsigned long phandle_scans;
+
+static inline u32 phandle_cache_hash(phandle handle)
+{
+	return hash_32(handle, phandle_cache_bits);
+}
+
+/*
+ * Caller must hold devtree_lock.
+ */
+static struct device_node **__of_phandle_cache_slot(phandle handle)
+{
+	u32 k = phandle_cache_hash(handle);
+
+	while (phandle_cache[k]) {
+		if (phandle_cache[k]->phandle == handle)
+			return &phandle_cache[k];
+		k = (k + 1) & phandle_cache_mask;
+	}
+
+	return NULL;
+}
+
+/*
+ * Caller must hold devtree_lock.
+ */
+static void __of_phandle_cache_add(struct device_node *np)
+{
+	u32 k = phandle_cache_hash(np->phandle);
+
+	while (phandle_cache[k])
+		k = (k + 1) & phandle_cache_mask;
+
+	/* will put when removed from cache */
+	of_node_get(np);
+	phandle_cache[k] = np;
+	phandle_cache_used++;
+}
+
+/*
+ * Drop the entry in slot @k, moving later entries of its probe sequence
+ * back so that they stay reachable.  Caller must hold devtree_lock.
+ */
+static void __of_phandle_cache_remove(u32 k)
+{
+	u32 j = k, home;
+
+	of_node_put(phandle_cache[k]);
+	phandle_cache_used--;
+
+	for (;;) {
+		j = (j + 1) & phandle_cache_mask;
+		if (!phandle_cache[j])
+			break;
+
+		home = phandle_cache_hash(phandle_cache[j]->phandle);
+		/* leave entries whose home slot lies in (k, j] */
+		if (k <= j ? (k < home && home <= j) : (k < home || home <= j))
+			continue;
+
+		phandle_cache[k] = phandle_cache[j];
+		k = j;
+	}
+	phandle_cache[k] = NULL;
+}
 
 /*
  * Caller must hold devtree_lock.
@@ -151,6 +225,7 @@ static void __of_free_phandle_cache(void)
 
 	kfree(phandle_cache);
 	phandle_cache = NULL;
+	phandle_cache_used = 0;
 }
 
 int of_free_phandle_cache(void)
@@ -160,46 +235,73 @@ int of_free_phandle_cache(void)
 	raw_spin_lock_irqsave(&devtree_lock, flags);
 
 	__of_free_phandle_cache();
+	phandle_cache_disabled = true;
 
 	raw_spin_unlock_irqrestore(&devtree_lock, flags);
 
 	return 0;
 }
+
+static int __init of_phandle_cache_stats(void)
+{
+	pr_info("phandle cache: %u entries, %lu lookups, %lu tree walks\n",
+		phandle_cache_used, phandle_lookups, phandle_scans);
+	return 0;
+}
+late_initcall_sync(of_phandle_cache_stats);
+
 #if !defined(CONFIG_MODULES)
 late_initcall_sync(of_free_phandle_cache);
 #endif
 
 /*
- * Caller must hold devtree_lock.
+ * Caller must hold devtree_lock, and @handle belong to a node that has
+ * just been marked OF_DETACHED.
  */
 void __of_free_phandle_cache_entry(phandle handle)
 {
-	phandle masked_handle;
-	struct device_node *np;
+	u32 k;
 
-	if (!handle)
+	if (!handle || !phandle_cache)
 		return;
 
-	masked_handle = handle & phandle_cache_mask;
+	/* skip live nodes sharing the phandle of the detached one */
+	for (k = phandle_cache_hash(handle); phandle_cache[k];
+	     k = (k + 1) & phandle_cache_mask) {
+		struct device_node *np = phandle_cache[k];
 
-	if (phandle_cache) {
-		np = phandle_cache[masked_handle];
-		if (np && handle == np->phandle) {
-			of_node_put(np);
-			phandle_cache[masked_handle] = NULL;
+		if (np->phandle == handle &&
+		    of_node_check_flag(np, OF_DETACHED)) {
+			__of_phandle_cache_remove(k);
+			return;
 		}
 	}
 }
 
-void of_populate_phandle_cache(void)
+/*
+ * Caller must hold devtree_lock.
+ */
+void __of_phandle_cache_insert(struct device_node *np)
+{
+	if (!np->phandle || np->phandle == OF_PHANDLE_ILLEGAL ||
+	    !phandle_cache)
+		return;
+
+	if (2 * (phandle_cache_used + 1) > phandle_cache_mask + 1)
+		return;
+
+	__of_phandle_cache_add(np);
+}
+
+/*
+ * Caller must hold devtree_lock.
+ */
+static void __of_populate_phandle_cache(void)
 {
-	unsigned long flags;
 	u32 cache_entries;
 	struct device_node *np;
 	u32 phandles = 0;
 
-	raw_spin_lock_irqsave(&devtree_lock, flags);
-
 	__of_free_phandle_cache();
 
 	for_each_of_allnodes(np)
@@ -207,23 +309,31 @@ void of_populate_phandle_cache(void)
 			phandles++;
 
 	if (!phandles)
-		goto out;
+		return;
 
-	cache_entries = roundup_pow_of_two(phandles);
+	cache_entries = roundup_pow_of_two(2 * phandles);
 	phandle_cache_mask = cache_entries - 1;
+	phandle_cache_bits = ilog2(cache_entries);
 
 	phandle_cache = kcalloc(cache_entries, sizeof(*phandle_cache),
 				GFP_ATOMIC);
 	if (!phandle_cache)
-		goto out;
+		return;
 
 	for_each_of_allnodes(np)
-		if (np->phandle && np->phandle != OF_PHANDLE_ILLEGAL) {
-			of_node_get(np);
-			phandle_cache[np->phandle & phandle_cache_mask] = np;
-		}
+		if (np->phandle && np->phandle != OF_PHANDLE_ILLEGAL)
+			__of_phandle_cache_add(np);
+}
+
+void of_populate_phandle_cache(void)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&devtree_lock, flags);
+
+	phandle_cache_disabled = false;
+	__of_populate_phandle_cache();
 
-out:
 	raw_spin_unlock_irqrestore(&devtree_lock, flags);
 }
 
@@ -1222,37 +1332,37 @@ EXPORT_SYMBOL_GPL(of_modalias_node);
 struct device_node *of_find_node_by_phandle(phandle handle)
 {
 	struct device_node *np = NULL;
+	struct device_node **slot;
 	unsigned long flags;
-	phandle masked_handle;
 
 	if (!handle)
 		return NULL;
 
 	raw_spin_lock_irqsave(&devtree_lock, flags);
 
-	masked_handle = handle & phandle_cache_mask;
+	phandle_lookups++;
+
+	/* Lookups from early init code can come before of_core_init() */
+	if (!phandle_cache && !phandle_cache_disabled && slab_is_available())
+		__of_populate_phandle_cache();
 
 	if (phandle_cache) {
-		if (phandle_cache[masked_handle] &&
-		    handle == phandle_cache[masked_handle]->phandle)
-			np = phandle_cache[masked_handle];
+		slot = __of_phandle_cache_slot(handle);
+		if (slot)
+			np = *slot;
 		if (np && of_node_check_flag(np, OF_DETACHED)) {
 			WARN_ON(1); /* did not uncache np on node removal */
-			of_node_put(np);
-			phandle_cache[masked_handle] = NULL;
+			__of_phandle_cache_remove(slot - phandle_cache);
 			np = NULL;
 		}
 	}
 
 	if (!np) {
+		phandle_scans++;
 		for_each_of_allnodes(np)
 			if (np->phandle == handle &&
 			    !of_node_check_flag(np, OF_DETACHED)) {
-				if (phandle_cache) {
-					/* will put when removed from cache */
-					of_node_get(np);
-					phandle_cache[masked_handle] = np;
-				}
+				__of_phandle_cache_insert(np);
 				break;
 			}
 	}
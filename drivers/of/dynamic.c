@@ -225,6 +225,8 @@ static void __of_attach_node(struct device_node *np)
 	np->sibling = np->parent->child;
 	np->parent->child = np;
 	of_node_clear_flag(np, OF_DETACHED);
+
+	__of_phandle_cache_insert(np);
 }
 
 /**
@@ -11,6 +11,7 @@
 #include <linux/crc32.h>
 #include <linux/kernel.h>
 #include <linux/initrd.h>
+#include <linux/math64.h>
 #include <linux/memblock.h>
 #include <linux/mutex.h>
 #include <linux/of.h>
@@ -22,6 +23,7 @@
 #include <linux/slab.h>
 #include <linux/libfdt.h>
 #include <linux/debugfs.h>
+#include <linux/sched/clock.h>
 #include <linux/serial_core.h>
 #include <linux/sysfs.h>
 
@@ -103,12 +105,33 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
 	return res;
 }
 
+/*
+ * Length, including the terminator, of the "name" property recreated from
+ * the unit name @nodename, which starts at *@start.
+ */
+static int unflatten_dt_name_len(const char *nodename, const char **start)
+{
+	const char *p = nodename, *ps = p, *pa = NULL;
+
+	while (*p) {
+		if ((*p) == '@')
+			pa = p;
+		else if ((*p) == '/')
+			ps = p + 1;
+		p++;
+	}
+
+	if (pa < ps)
+		pa = p;
+	*start = ps;
+	return (pa - ps) + 1;
+}
+
 static void populate_properties(const void *blob,
 				int offset,
 				void **mem,
 				struct device_node *np,
-				const char *nodename,
-				bool dryrun)
+				const char *nodename)
 {
 	struct property *pp, **pprev = NULL;
 	int cur;
@@ -138,8 +161,6 @@ static void populate_properties(const void *blob,
 
 		pp = unflatten_dt_alloc(mem, sizeof(struct property),
 					__alignof__(struct property));
-		if (dryrun)
-			continue;
 
 		/* We accept flattened tree phandles either in
 		 * ePAPR-style "phandle" properties, or the
@@ -171,49 +192,36 @@ static void populate_properties(const void *blob,
 	 * recreate it here from the unit name if absent
 	 */
 	if (!has_name) {
-		const char *p = nodename, *ps = p, *pa = NULL;
+		const char *ps;
 		int len;
 
-		while (*p) {
-			if ((*p) == '@')
-				pa = p;
-			else if ((*p) == '/')
-				ps = p + 1;
-			p++;
-		}
-
-		if (pa < ps)
-			pa = p;
-		len = (pa - ps) + 1;
+		len = unflatten_dt_name_len(nodename, &ps);
 		pp = unflatten_dt_alloc(mem, sizeof(struct property) + len,
 					__alignof__(struct property));
-		if (!dryrun) {
-			pp->name   = "name";
-			pp->length = len;
-			pp->value  = pp + 1;
-			*pprev     = pp;
-			pprev      = &pp->next;
-			memcpy(pp->value, ps, len - 1);
-			((char *)pp->value)[len - 1] = 0;
-			pr_debug("fixed up name for %s -> %s\n",
-				 nodename, (char *)pp->value);
-		}
+		pp->name   = "name";
+		pp->length = len;
+		pp->value  = pp + 1;
+		*pprev     = pp;
+		pprev      = &pp->next;
+		memcpy(pp->value, ps, len - 1);
+		((char *)pp->value)[len - 1] = 0;
+		pr_debug("fixed up name for %s -> %s\n",
+			 nodename, (char *)pp->value);
 	}
 
-	if (!dryrun)
-		*pprev = NULL;
+	*pprev = NULL;
 }
 
 static bool populate_node(const void *blob,
 			  int offset,
 			  void **mem,
 			  struct device_node *dad,
-			  struct device_node **pnp,
-			  bool dryrun)
+			  struct device_node **pnp)
 {
 	struct device_node *np;
 	const char *pathp;
 	unsigned int l, allocl;
+	char *fn;
 
 	pathp = fdt_get_name(blob, offset, &l);
 	if (!pathp) {
@@ -225,26 +233,21 @@ static bool populate_node(const void *blob,
 
 	np = unflatten_dt_alloc(mem, sizeof(struct device_node) + allocl,
 				__alignof__(struct device_node));
-	if (!dryrun) {
-		char *fn;
-		of_node_init(np);
-		np->full_name = fn = ((char *)np) + sizeof(*np);
+	of_node_init(np);
+	np->full_name = fn = ((char *)np) + sizeof(*np);
 
-		memcpy(fn, pathp, l);
+	memcpy(fn, pathp, l);
 
-		if (dad != NULL) {
-			np->parent = dad;
-			np->sibling = dad->child;
-			dad->child = np;
-		}
+	if (dad != NULL) {
+		np->parent = dad;
+		np->sibling = dad->child;
+		dad->child = np;
 	}
 
-	populate_properties(blob, offset, mem, np, pathp, dryrun);
-	if (!dryrun) {
-		np->name = of_get_property(np, "name", NULL);
-		if (!np->name)
-			np->name = "<NULL>";
-	}
+	populate_properties(blob, offset, mem, np, pathp);
+	np->name = of_get_property(np, "name", NULL);
+	if (!np->name)
+		np->name = "<NULL>";
 
 	*pnp = np;
 	return true;
@@ -274,6 +277,85 @@ static void reverse_nodes(struct device_node *parent)
 	}
 }
 
+/**
+ * unflatten_dt_size - Size the unflattened tree from the flat tree's tags
+ * @blob: The device tree blob
+ *
+ * Walks the structure block tag by tag, doing the same allocations as
+ * unflatten_dt_nodes() on a zero based offset, without looking up or
+ * validating any property.  Nodes unflatten_dt_nodes() skips are still
+ * counted, so the result is an upper bound.
+ *
+ * It returns the size or an error code
+ */
+static int unflatten_dt_size(const void *blob)
+{
+	unsigned long size = 0;
+	const char *name = NULL;
+	bool has_name = false;
+	int offset = 0, next, depth = 0;
+	unsigned int l;
+
+	for (;;) {
+		u32 tag = fdt_next_tag(blob, offset, &next);
+
+		/* the "name" fixup is sized once a node's properties are done */
+		if (name && tag != FDT_PROP && tag != FDT_NOP) {
+			if (!has_name) {
+				const char *ps;
+
+				size = ALIGN(size, __alignof__(struct property));
+				size += sizeof(struct property) +
+					unflatten_dt_name_len(name, &ps);
+			}
+			name = NULL;
+		}
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			name = fdt_get_name(blob, offset, &l);
+			if (!name)
+				return -EINVAL;
+			has_name = false;
+			size = ALIGN(size, __alignof__(struct device_node));
+			size += sizeof(struct device_node) + l + 1;
+			depth++;
+			break;
+		case FDT_PROP: {
+			const struct fdt_property *prop;
+			const char *pname;
+
+			prop = fdt_offset_ptr(blob, offset, sizeof(*prop));
+			if (!prop)
+				return -EINVAL;
+			/* populate_properties() skips properties without a name */
+			pname = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
+			if (!pname)
+				break;
+			if (!strcmp(pname, "name"))
+				has_name = true;
+			size = ALIGN(size, __alignof__(struct property));
+			size += sizeof(struct property);
+			break;
+		}
+		case FDT_END_NODE:
+			if (--depth <= 0)
+				return size;
+			break;
+		case FDT_NOP:
+			break;
+		default:
+			/* FDT_END before the root node closed, or a bad tag */
+			pr_err("Error %d processing FDT\n", next);
+			return -EINVAL;
+		}
+
+		if (next < 0)
+			return -EINVAL;
+		offset = next;
+	}
+}
+
 /**
  * unflatten_dt_nodes - Alloc and populate a device_node from the flat tree
  * @blob: The parent device tree blob
@@ -293,7 +375,6 @@ static int unflatten_dt_nodes(const void *blob,
 #define FDT_MAX_DEPTH	64
 	struct device_node *nps[FDT_MAX_DEPTH];
 	void *base = mem;
-	bool dryrun = !base;
 
 	if (nodepp)
 		*nodepp = NULL;
@@ -322,12 +403,12 @@ static int unflatten_dt_nodes(const void *blob,
 			continue;
 
 		if (!populate_node(blob, offset, &mem, nps[depth],
-				   &nps[depth+1], dryrun))
+				   &nps[depth+1]))
 			return mem - base;
 
-		if (!dryrun && nodepp && !*nodepp)
+		if (nodepp && !*nodepp)
 			*nodepp = nps[depth+1];
-		if (!dryrun && !root)
+		if (!root)
 			root = nps[depth+1];
 	}
 
@@ -340,8 +421,7 @@ static int unflatten_dt_nodes(const void *blob,
 	 * Reverse the child list. Some drivers assumes node order matches .dts
 	 * node order
 	 */
-	if (!dryrun)
-		reverse_nodes(root);
+	reverse_nodes(root);
 
 	return mem - base;
 }
@@ -369,7 +449,7 @@ void *__unflatten_device_tree(const void *blob,
 			      void *(*dt_alloc)(u64 size, u64 align),
 			      bool detached)
 {
-	int size;
+	int size, used;
 	void *mem;
 
 	pr_debug(" -> unflatten_device_tree()\n");
@@ -389,8 +469,8 @@ void *__unflatten_device_tree(const void *blob,
 		return NULL;
 	}
 
-	/* First pass, scan for size */
-	size = unflatten_dt_nodes(blob, NULL, dad, NULL);
+	/* Size from the tags alone, properties are only parsed once */
+	size = unflatten_dt_size(blob);
 	if (size < 0)
 		return NULL;
 
@@ -408,8 +488,8 @@ void *__unflatten_device_tree(const void *blob,
 
 	pr_debug("  unflattening %p...\n", mem);
 
-	/* Second pass, do actual unflattening */
-	unflatten_dt_nodes(blob, mem, dad, mynodes);
+	used = unflatten_dt_nodes(blob, mem, dad, mynodes);
+	pr_debug("  used %d of %d bytes\n", used, size);
 	if (be32_to_cpup(mem + size) != 0xdeadbeef)
 		pr_warning("End of tree marker overwritten: %08x\n",
 			   be32_to_cpup(mem + size));
@@ -1210,9 +1290,14 @@ bool __init early_init_dt_scan(void *params)
  */
 void __init unflatten_device_tree(void)
 {
+	u64 start = local_clock();
+
 	__unflatten_device_tree(initial_boot_params, NULL, &of_root,
 				early_init_dt_alloc_memory_arch, false);
 
+	pr_info("unflattened device tree in %llu us\n",
+		div_u64(local_clock() - start, NSEC_PER_USEC));
+
 	/* Get pointer to "/chosen" and "/aliases" nodes for use everywhere */
 	of_alias_scan(early_init_dt_alloc_memory_arch);
 
@@ -84,6 +84,7 @@ static inline void __of_detach_node_sysfs(struct device_node *np) {}
 int of_resolve_phandles(struct device_node *tree);
 #endif
 
+void __of_phandle_cache_insert(struct device_node *np);
 #if defined(CONFIG_OF_DYNAMIC)
 void __of_free_phandle_cache_entry(phandle handle);
 #endif
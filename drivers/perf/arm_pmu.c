@@ -23,12 +23,23 @@
 #include <linux/spinlock.h>
 #include <linux/irq.h>
 #include <linux/irqdesc.h>
+#include <linux/moduleparam.h>
 
 #include <asm/irq_regs.h>
 
 static DEFINE_PER_CPU(struct arm_pmu *, cpu_armpmu);
 static DEFINE_PER_CPU(int, cpu_irq);
 
+/*
+ * How often PMUs without a usable overflow interrupt check their counters.
+ * Samples are taken at most this late, and a counter whose period is
+ * shorter than this loses overflows.
+ */
+static unsigned int armpmu_poll_period_us = 1000;
+module_param_named(poll_period_us, armpmu_poll_period_us, uint, 0644);
+MODULE_PARM_DESC(poll_period_us,
+		 "Overflow polling period for PMUs without an interrupt (default 1000)");
+
 static inline u64 arm_pmu_event_max_period(struct perf_event *event)
 {
 	if (event->hw.flags & ARMPMU_EVT_64BIT)
@@ -182,6 +193,35 @@ u64 armpmu_event_update(struct perf_event *event)
 	return new_raw_count;
 }
 
+static ktime_t armpmu_poll_period(void)
+{
+	return us_to_ktime(max(READ_ONCE(armpmu_poll_period_us), 10U));
+}
+
+/*
+ * Stand-in for the overflow interrupt: the counters still flag their
+ * overflows, so the regular handler finds them and samples the context
+ * the timer interrupted.  The timer stops once no counter is in use.
+ */
+static enum hrtimer_restart armpmu_poll(struct hrtimer *hrtimer)
+{
+	struct pmu_hw_events *hw_events =
+		container_of(hrtimer, struct pmu_hw_events, poll_timer);
+	struct arm_pmu *armpmu = hw_events->percpu_pmu;
+	u64 start_clock, finish_clock;
+
+	if (bitmap_empty(hw_events->used_mask, ARMPMU_MAX_HWEVENTS))
+		return HRTIMER_NORESTART;
+
+	start_clock = sched_clock();
+	armpmu->handle_irq(armpmu);
+	finish_clock = sched_clock();
+	perf_sample_event_took(finish_clock - start_clock);
+
+	hrtimer_forward_now(hrtimer, armpmu_poll_period());
+	return HRTIMER_RESTART;
+}
+
 static void
 armpmu_read(struct perf_event *event)
 {
@@ -274,6 +314,10 @@ armpmu_add(struct perf_event *event, int flags)
 	if (flags & PERF_EF_START)
 		armpmu_start(event, PERF_EF_RELOAD);
 
+	if (armpmu->poll && !hrtimer_active(&hw_events->poll_timer))
+		hrtimer_start(&hw_events->poll_timer, armpmu_poll_period(),
+			      HRTIMER_MODE_REL_PINNED);
+
 	/* Propagate our changes to the userspace mapping. */
 	perf_event_update_userpage(event);
 
@@ -825,6 +869,9 @@ static struct arm_pmu *__armpmu_alloc(gfp_t flags)
 		events = per_cpu_ptr(pmu->hw_events, cpu);
 		raw_spin_lock_init(&events->pmu_lock);
 		events->percpu_pmu = pmu;
+		hrtimer_init(&events->poll_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL_PINNED);
+		events->poll_timer.function = armpmu_poll;
 	}
 
 	return pmu;
@@ -870,8 +917,9 @@ int armpmu_register(struct arm_pmu *pmu)
 	if (!__oprofile_cpu_pmu)
 		__oprofile_cpu_pmu = pmu;
 
-	pr_info("enabled with %s PMU driver, %d counters available\n",
-		pmu->name, pmu->num_events);
+	pr_info("enabled with %s PMU driver, %d counters available%s\n",
+		pmu->name, pmu->num_events,
+		pmu->poll ? ", polling for overflows" : "");
 
 	return 0;
 
@@ -110,8 +110,8 @@ static int pmu_parse_irqs(struct arm_pmu *pmu)
 	 * To match our prior behaviour, we assume all CPUs in this case.
 	 */
 	if (num_irqs == 0) {
-		pr_warn("no irqs for PMU, sampling events not supported\n");
-		pmu->pmu.capabilities |= PERF_PMU_CAP_NO_INTERRUPT;
+		pr_warn("no irqs for PMU, polling for counter overflows\n");
+		pmu->poll = true;
 		cpumask_setall(&pmu->supported_cpus);
 		return 0;
 	}
@@ -157,6 +157,15 @@ static int pmu_parse_irqs(struct arm_pmu *pmu)
 	return 0;
 }
 
+static void pmu_forget_irqs(struct arm_pmu *pmu)
+{
+	int cpu;
+
+	for_each_cpu(cpu, &pmu->supported_cpus)
+		per_cpu(pmu->hw_events->irq, cpu) = 0;
+	pmu->poll = true;
+}
+
 static int armpmu_request_irqs(struct arm_pmu *armpmu)
 {
 	struct pmu_hw_events __percpu *hw_events = armpmu->hw_events;
@@ -219,6 +228,13 @@ int arm_pmu_device_probe(struct platform_device *pdev,
 			pmu->secure_access = false;
 		}
 
+		/*
+		 * Some SoCs describe PMU interrupts that are not (or not
+		 * reliably) routed. Leave them alone and poll instead.
+		 */
+		if (of_property_read_bool(node, "poll-overflows"))
+			pmu_forget_irqs(pmu);
+
 		ret = init_fn(pmu);
 	} else if (probe_table) {
 		cpumask_setall(&pmu->supported_cpus);
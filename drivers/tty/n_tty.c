@@ -1507,11 +1507,22 @@ n_tty_receive_char_lnext(struct tty_struct *tty, unsigned char c, char flag)
 		n_tty_receive_char_flagged(tty, c, flag);
 }
 
-static void
-n_tty_receive_buf_real_raw(struct tty_struct *tty, const unsigned char *cp,
-			   char *fp, int count)
+/**
+ *	n_tty_queue_block	-	add a run of chars to the read queue
+ *	@ldata: n_tty data
+ *	@cp: chars to add
+ *	@count: number of chars in @cp
+ *
+ *	Copy a block of characters which need no further processing into
+ *	the read_buf ring, in at most two pieces.
+ *
+ *	n_tty_receive_buf()/producer path:
+ *		caller holds non-exclusive termios_rwsem
+ */
+
+static void n_tty_queue_block(struct n_tty_data *ldata,
+			      const unsigned char *cp, size_t count)
 {
-	struct n_tty_data *ldata = tty->disc_data;
 	size_t n, head;
 
 	head = ldata->read_head & (N_TTY_BUF_SIZE - 1);
@@ -1527,20 +1538,39 @@ n_tty_receive_buf_real_raw(struct tty_struct *tty, const unsigned char *cp,
 	ldata->read_head += n;
 }
 
+static void
+n_tty_receive_buf_real_raw(struct tty_struct *tty, const unsigned char *cp,
+			   char *fp, int count)
+{
+	n_tty_queue_block(tty->disc_data, cp, count);
+}
+
 static void
 n_tty_receive_buf_raw(struct tty_struct *tty, const unsigned char *cp,
 		      char *fp, int count)
 {
 	struct n_tty_data *ldata = tty->disc_data;
-	char flag = TTY_NORMAL;
+	int n;
 
-	while (count--) {
-		if (fp)
-			flag = *fp++;
-		if (likely(flag == TTY_NORMAL))
-			put_tty_queue(*cp++, ldata);
-		else
-			n_tty_receive_char_flagged(tty, *cp++, flag);
+	if (!fp) {
+		n_tty_queue_block(ldata, cp, count);
+		return;
+	}
+
+	while (count) {
+		/* Copy the run of unflagged chars in one go */
+		char *end = memchr_inv(fp, TTY_NORMAL, count);
+
+		n = end ? end - fp : count;
+		n_tty_queue_block(ldata, cp, n);
+		cp += n;
+		fp += n;
+		count -= n;
+
+		if (count) {
+			n_tty_receive_char_flagged(tty, *cp++, *fp++);
+			count--;
+		}
 	}
 }
 
@@ -1592,14 +1622,47 @@ n_tty_receive_buf_standard(struct tty_struct *tty, const unsigned char *cp,
 	}
 }
 
+/*
+ * Length of the leading run of chars which n_tty_receive_char_fast() would
+ * only queue: unflagged and not in char_map.
+ */
+static int n_tty_plain_run(struct n_tty_data *ldata, const unsigned char *cp,
+			   const char *fp, int count)
+{
+	int n;
+
+	for (n = 0; n < count; n++) {
+		if (fp && fp[n] != TTY_NORMAL)
+			break;
+		if (test_bit(cp[n], ldata->char_map))
+			break;
+	}
+	return n;
+}
+
 static void
 n_tty_receive_buf_fast(struct tty_struct *tty, const unsigned char *cp,
 		       char *fp, int count)
 {
 	struct n_tty_data *ldata = tty->disc_data;
 	char flag = TTY_NORMAL;
+	/* without echo or IXANY restarts, ordinary chars are just queued */
+	bool bulk = !L_ECHO(tty) && !(I_IXON(tty) && I_IXANY(tty));
 
-	while (count--) {
+	while (count) {
+		if (bulk) {
+			int n = n_tty_plain_run(ldata, cp, fp, count);
+
+			n_tty_queue_block(ldata, cp, n);
+			cp += n;
+			if (fp)
+				fp += n;
+			count -= n;
+			if (!count)
+				break;
+		}
+
+		count--;
 		if (fp)
 			flag = *fp++;
 		if (likely(flag == TTY_NORMAL)) {
@@ -1947,10 +2010,10 @@ static inline int input_available_p(struct tty_struct *tty, int poll)
  *
  *	Helper function to speed up n_tty_read.  It is only called when
  *	ICANON is off; it copies characters straight from the tty queue to
- *	user space directly.  It can be profitably called twice; once to
- *	drain the space from the tail pointer to the (physical) end of the
- *	buffer, and once to drain the space from the (physical) beginning of
- *	the buffer to head pointer.
+ *	user space directly, draining both the space from the tail pointer
+ *	to the (physical) end of the buffer and the space from the (physical)
+ *	beginning of the buffer to the head pointer before publishing the
+ *	new read_tail.
  *
  *	Called under the ldata->atomic_read_lock sem
  *
@@ -1966,28 +2029,39 @@ static int copy_from_read_buf(struct tty_struct *tty,
 {
 	struct n_tty_data *ldata = tty->disc_data;
 	int retval;
-	size_t n;
+	size_t n, c, copied;
 	bool is_eof;
 	size_t head = smp_load_acquire(&ldata->commit_head);
-	size_t tail = ldata->read_tail & (N_TTY_BUF_SIZE - 1);
+	size_t tail;
 
 	retval = 0;
-	n = min(head - ldata->read_tail, N_TTY_BUF_SIZE - tail);
-	n = min(*nr, n);
+	n = min(head - ldata->read_tail, *nr);
 	if (n) {
-		unsigned char *from = read_buf_addr(ldata, tail);
-		retval = copy_to_user(*b, from, n);
-		n -= retval;
-		is_eof = n == 1 && *from == EOF_CHAR(tty);
-		tty_audit_add_data(tty, from, n);
-		zero_buffer(tty, from, n);
-		smp_store_release(&ldata->read_tail, ldata->read_tail + n);
+		is_eof = n == 1 &&
+			 read_buf(ldata, ldata->read_tail) == EOF_CHAR(tty);
+		/* both pieces of a wrapped ring, published with one store */
+		for (copied = 0; copied < n; copied += c) {
+			unsigned char *from;
+
+			tail = (ldata->read_tail + copied) & (N_TTY_BUF_SIZE - 1);
+			c = min(n - copied, N_TTY_BUF_SIZE - tail);
+			from = read_buf_addr(ldata, tail);
+			retval = copy_to_user(*b + copied, from, c);
+			c -= retval;
+			tty_audit_add_data(tty, from, c);
+			zero_buffer(tty, from, c);
+			if (retval) {
+				copied += c;
+				break;
+			}
+		}
+		smp_store_release(&ldata->read_tail, ldata->read_tail + copied);
 		/* Turn single EOF into zero-length read */
 		if (L_EXTPROC(tty) && ldata->icanon && is_eof &&
 		    (head == ldata->read_tail))
-			n = 0;
-		*b += n;
-		*nr -= n;
+			copied = 0;
+		*b += copied;
+		*nr -= copied;
 	}
 	return retval;
 }
@@ -2249,7 +2323,6 @@ static ssize_t n_tty_read(struct tty_struct *tty, struct file *file,
 			}
 
 			uncopied = copy_from_read_buf(tty, &b, &nr);
-			uncopied += copy_from_read_buf(tty, &b, &nr);
 			if (uncopied) {
 				retval = -EFAULT;
 				break;
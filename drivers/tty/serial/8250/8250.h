@@ -48,6 +48,12 @@ struct uart_8250_dma {
 	unsigned char		tx_running;
 	unsigned char		tx_err;
 	unsigned char		rx_running;
+
+	/* RX as one cyclic transfer, drained on timeouts and period ends */
+	unsigned char		rx_cyclic;
+	unsigned char		rx_paused;
+	/* Offset in rx_buf up to which cyclic RX data has been pushed */
+	size_t			rx_pos;
 };
 
 struct old_serial_port {
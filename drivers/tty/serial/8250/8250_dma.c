@@ -59,6 +59,62 @@ static void __dma_rx_complete(void *param)
 	tty_flip_buffer_push(tty_port);
 }
 
+/* Number of periods, i.e. completion callbacks, per cyclic RX buffer */
+#define RX_CYCLIC_PERIODS	4
+
+static void __dma_rx_insert(struct uart_8250_port *p, unsigned char *buf,
+			    size_t count)
+{
+	struct tty_port *tty_port = &p->port.state->port;
+	int copied;
+
+	copied = tty_insert_flip_string(tty_port, buf, count);
+	p->port.icount.rx += copied;
+	if (copied < count) {
+		p->port.icount.buf_overrun++;
+		dev_warn_ratelimited(p->port.dev,
+				     "RX DMA: dropped %zu bytes\n",
+				     count - copied);
+	}
+}
+
+/*
+ * Push everything the cyclic transfer has written since the last call.
+ * Called with the port lock held.
+ */
+static void __dma_rx_cyclic_push(struct uart_8250_port *p)
+{
+	struct uart_8250_dma	*dma = p->dma;
+	struct dma_tx_state	state;
+	size_t			pos;
+
+	dmaengine_tx_status(dma->rxchan, dma->rx_cookie, &state);
+	pos = dma->rx_size - state.residue;
+	if (pos == dma->rx_pos)
+		return;
+
+	if (pos < dma->rx_pos) {
+		__dma_rx_insert(p, dma->rx_buf + dma->rx_pos,
+				dma->rx_size - dma->rx_pos);
+		dma->rx_pos = 0;
+	}
+	__dma_rx_insert(p, dma->rx_buf + dma->rx_pos, pos - dma->rx_pos);
+	dma->rx_pos = pos % dma->rx_size;
+
+	tty_flip_buffer_push(&p->port.state->port);
+}
+
+static void __dma_rx_cyclic_complete(void *param)
+{
+	struct uart_8250_port	*p = param;
+	unsigned long		flags;
+
+	spin_lock_irqsave(&p->port.lock, flags);
+	if (p->dma->rx_running)
+		__dma_rx_cyclic_push(p);
+	spin_unlock_irqrestore(&p->port.lock, flags);
+}
+
 int serial8250_tx_dma(struct uart_8250_port *p)
 {
 	struct uart_8250_dma		*dma = p->dma;
@@ -106,11 +162,47 @@ int serial8250_tx_dma(struct uart_8250_port *p)
 	return ret;
 }
 
+static int serial8250_rx_dma_cyclic(struct uart_8250_port *p)
+{
+	struct uart_8250_dma		*dma = p->dma;
+	struct dma_async_tx_descriptor	*desc;
+
+	if (dma->rx_running) {
+		/* Restart after serial8250_rx_dma_flush() */
+		if (dma->rx_paused) {
+			dmaengine_resume(dma->rxchan);
+			dma->rx_paused = 0;
+		}
+		return 0;
+	}
+
+	desc = dmaengine_prep_dma_cyclic(dma->rxchan, dma->rx_addr,
+					 dma->rx_size,
+					 dma->rx_size / RX_CYCLIC_PERIODS,
+					 DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+	if (!desc)
+		return -EBUSY;
+
+	dma->rx_running = 1;
+	dma->rx_pos = 0;
+	desc->callback = __dma_rx_cyclic_complete;
+	desc->callback_param = p;
+
+	dma->rx_cookie = dmaengine_submit(desc);
+
+	dma_async_issue_pending(dma->rxchan);
+
+	return 0;
+}
+
 int serial8250_rx_dma(struct uart_8250_port *p)
 {
 	struct uart_8250_dma		*dma = p->dma;
 	struct dma_async_tx_descriptor	*desc;
 
+	if (dma->rx_cyclic)
+		return serial8250_rx_dma_cyclic(p);
+
 	if (dma->rx_running)
 		return 0;
 
@@ -137,6 +229,15 @@ void serial8250_rx_dma_flush(struct uart_8250_port *p)
 
 	if (dma->rx_running) {
 		dmaengine_pause(dma->rxchan);
+		/*
+		 * A cyclic transfer stays set up; it is only held while the
+		 * FIFO is drained by PIO, so that no bytes get reordered.
+		 */
+		if (dma->rx_cyclic) {
+			dma->rx_paused = 1;
+			__dma_rx_cyclic_push(p);
+			return;
+		}
 		__dma_rx_complete(p);
 		dmaengine_terminate_async(dma->rxchan);
 	}
@@ -183,6 +284,14 @@ int serial8250_request_dma(struct uart_8250_port *p)
 		goto release_rx;
 	}
 
+	/* cyclic RX also needs resume, fall back to one-shot transfers */
+	if (dma->rx_cyclic &&
+	    (!dma_has_cap(DMA_CYCLIC, dma->rxchan->device->cap_mask) ||
+	     !caps.cmd_resume)) {
+		dev_dbg(p->port.dev, "no cyclic rx dma support\n");
+		dma->rx_cyclic = 0;
+	}
+
 	dmaengine_slave_config(dma->rxchan, &dma->rxconf);
 
 	/* Get a channel for TX */
@@ -205,9 +314,9 @@ int serial8250_request_dma(struct uart_8250_port *p)
 
 	dmaengine_slave_config(dma->txchan, &dma->txconf);
 
-	/* RX buffer */
+	/* RX buffer, with some slack for the cyclic callback latency */
 	if (!dma->rx_size)
-		dma->rx_size = PAGE_SIZE;
+		dma->rx_size = dma->rx_cyclic ? 4 * PAGE_SIZE : PAGE_SIZE;
 
 	dma->rx_buf = dma_alloc_coherent(dma->rxchan->device->dev, dma->rx_size,
 					&dma->rx_addr, GFP_KERNEL);
@@ -252,6 +361,8 @@ void serial8250_release_dma(struct uart_8250_port *p)
 			  dma->rx_addr);
 	dma_release_channel(dma->rxchan);
 	dma->rxchan = NULL;
+	dma->rx_running = 0;
+	dma->rx_paused = 0;
 
 	/* Release TX resources */
 	dmaengine_terminate_sync(dma->txchan);
@@ -634,6 +634,8 @@ static int dw8250_probe(struct platform_device *pdev)
 	if (p->fifosize) {
 		data->dma.rxconf.src_maxburst = p->fifosize / 4;
 		data->dma.txconf.dst_maxburst = p->fifosize / 4;
+		/* Keep RX DMA running if the engine can do cyclic transfers */
+		data->dma.rx_cyclic = 1;
 		uart.dma = &data->dma;
 	}
 
@@ -1868,8 +1868,12 @@ int serial8250_handle_irq(struct uart_port *port, unsigned int iir)
 	status = serial_port_in(port, UART_LSR);
 
 	if (status & (UART_LSR_DR | UART_LSR_BI)) {
-		if (!up->dma || handle_rx_dma(up, iir))
+		if (!up->dma || handle_rx_dma(up, iir)) {
 			status = serial8250_rx_chars(up, status);
+			/* Resume a cyclic transfer held for the PIO drain */
+			if (up->dma && up->dma->rx_paused)
+				up->dma->rx_dma(up);
+		}
 	}
 	serial8250_modem_status(up);
 	if ((!up->dma || up->dma->tx_err) && (status & UART_LSR_THRE) &&
@@ -17,6 +17,8 @@
 #include <linux/slab.h>
 #include <linux/sched/mm.h>
 #include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/ktime.h>
 #include <crypto/hash.h>
 #include "ctree.h"
 #include "disk-io.h"
@@ -851,6 +853,12 @@ void btrfs_init_workspace_manager(struct workspace_manager *wsm,
 	atomic_set(&wsm->total_ws, 0);
 	init_waitqueue_head(&wsm->ws_wait);
 
+	/*
+	 * Not fatal, without the per-cpu cache every workspace goes through
+	 * the shared idle list
+	 */
+	wsm->pcpu_ws = alloc_percpu(struct list_head *);
+
 	/*
 	 * Preallocate one workspace for each compression type so we can
 	 * guarantee forward progress in the worst case
@@ -869,6 +877,19 @@ void btrfs_init_workspace_manager(struct workspace_manager *wsm,
 void btrfs_cleanup_workspace_manager(struct workspace_manager *wsman)
 {
 	struct list_head *ws;
+	int cpu;
+
+	if (wsman->pcpu_ws) {
+		for_each_possible_cpu(cpu) {
+			ws = *per_cpu_ptr(wsman->pcpu_ws, cpu);
+			if (ws) {
+				wsman->ops->free_workspace(ws);
+				atomic_dec(&wsman->total_ws);
+			}
+		}
+		free_percpu(wsman->pcpu_ws);
+		wsman->pcpu_ws = NULL;
+	}
 
 	while (!list_empty(&wsman->idle_ws)) {
 		ws = wsman->idle_ws.next;
@@ -878,11 +899,60 @@ void btrfs_cleanup_workspace_manager(struct workspace_manager *wsman)
 	}
 }
 
+/*
+ * Take the idle workspace cached on this cpu, if any.  The slots are only
+ * ever accessed with xchg/cmpxchg, so a task that migrates in between
+ * just ends up using another cpu's slot.
+ */
+static struct list_head *get_pcpu_workspace(struct workspace_manager *wsm)
+{
+	if (!wsm->pcpu_ws)
+		return NULL;
+	return xchg(raw_cpu_ptr(wsm->pcpu_ws), NULL);
+}
+
+/*
+ * Called when the shared list is empty: workspaces parked on other cpus
+ * are idle too and must not make us wait or allocate.
+ */
+static struct list_head *steal_pcpu_workspace(struct workspace_manager *wsm)
+{
+	struct list_head *ws;
+	int cpu;
+
+	if (!wsm->pcpu_ws)
+		return NULL;
+
+	for_each_possible_cpu(cpu) {
+		ws = xchg(per_cpu_ptr(wsm->pcpu_ws, cpu), NULL);
+		if (ws)
+			return ws;
+	}
+	return NULL;
+}
+
+static bool have_pcpu_workspace(struct workspace_manager *wsm)
+{
+	int cpu;
+
+	if (!wsm->pcpu_ws)
+		return false;
+
+	for_each_possible_cpu(cpu)
+		if (READ_ONCE(*per_cpu_ptr(wsm->pcpu_ws, cpu)))
+			return true;
+	return false;
+}
+
 /*
  * This finds an available workspace or allocates a new one.
  * If it's not possible to allocate a new one, waits until there's one.
  * Preallocation makes a forward progress guarantees and we do not return
  * errors.
+ *
+ * The workspace last released on the local cpu is tried first, so that
+ * parallel compression does not bounce the shared lock and list between
+ * cpus.
  */
 struct list_head *btrfs_get_workspace(struct workspace_manager *wsm,
 				      unsigned int level)
@@ -902,6 +972,10 @@ struct list_head *btrfs_get_workspace(struct workspace_manager *wsm,
 	ws_wait	 = &wsm->ws_wait;
 	free_ws	 = &wsm->free_ws;
 
+	workspace = get_pcpu_workspace(wsm);
+	if (workspace)
+		return workspace;
+
 again:
 	spin_lock(ws_lock);
 	if (!list_empty(idle_ws)) {
@@ -912,12 +986,20 @@ struct list_head *btrfs_get_workspace(struct workspace_manager *wsm,
 		return workspace;
 
 	}
+	spin_unlock(ws_lock);
+
+	workspace = steal_pcpu_workspace(wsm);
+	if (workspace)
+		return workspace;
+
+	spin_lock(ws_lock);
 	if (atomic_read(total_ws) > cpus) {
 		DEFINE_WAIT(wait);
 
 		spin_unlock(ws_lock);
 		prepare_to_wait(ws_wait, &wait, TASK_UNINTERRUPTIBLE);
-		if (atomic_read(total_ws) > cpus && !*free_ws)
+		if (atomic_read(total_ws) > cpus && !*free_ws &&
+		    !have_pcpu_workspace(wsm))
 			schedule();
 		finish_wait(ws_wait, &wait);
 		goto again;
@@ -985,6 +1067,9 @@ void btrfs_put_workspace(struct workspace_manager *wsm, struct list_head *ws)
 	ws_wait	 = &wsm->ws_wait;
 	free_ws	 = &wsm->free_ws;
 
+	if (wsm->pcpu_ws && !cmpxchg(raw_cpu_ptr(wsm->pcpu_ws), NULL, ws))
+		goto wake;
+
 	spin_lock(ws_lock);
 	if (*free_ws <= num_online_cpus()) {
 		list_add(ws, idle_ws);
@@ -1005,6 +1090,38 @@ static void put_workspace(int type, struct list_head *ws)
 	return btrfs_compress_op[type]->put_workspace(ws);
 }
 
+static DEFINE_PER_CPU(struct btrfs_compress_stats [BTRFS_NR_WORKSPACE_MANAGERS],
+		      btrfs_compress_stats);
+
+void btrfs_compress_get_stats(int type, struct btrfs_compress_stats *stats)
+{
+	struct btrfs_compress_stats *pcpu;
+	int cpu;
+
+	memset(stats, 0, sizeof(*stats));
+	for_each_possible_cpu(cpu) {
+		pcpu = &per_cpu(btrfs_compress_stats, cpu)[type];
+		stats->compress_calls += pcpu->compress_calls;
+		stats->compress_bytes_in += pcpu->compress_bytes_in;
+		stats->compress_bytes_out += pcpu->compress_bytes_out;
+		stats->compress_ns += pcpu->compress_ns;
+		stats->decompress_calls += pcpu->decompress_calls;
+		stats->decompress_bytes_in += pcpu->decompress_bytes_in;
+		stats->decompress_bytes_out += pcpu->decompress_bytes_out;
+		stats->decompress_ns += pcpu->decompress_ns;
+	}
+}
+
+static void account_decompress(int type, u64 start_ns, unsigned long in,
+			       unsigned long out)
+{
+	this_cpu_inc(btrfs_compress_stats[type].decompress_calls);
+	this_cpu_add(btrfs_compress_stats[type].decompress_bytes_in, in);
+	this_cpu_add(btrfs_compress_stats[type].decompress_bytes_out, out);
+	this_cpu_add(btrfs_compress_stats[type].decompress_ns,
+		     ktime_get_ns() - start_ns);
+}
+
 /*
  * Given an address space and start and length, compress the bytes into @pages
  * that are allocated on demand.
@@ -1037,14 +1154,23 @@ int btrfs_compress_pages(unsigned int type_level, struct address_space *mapping,
 	int type = btrfs_compress_type(type_level);
 	int level = btrfs_compress_level(type_level);
 	struct list_head *workspace;
+	u64 start_ns;
 	int ret;
 
 	level = btrfs_compress_op[type]->set_level(level);
 	workspace = get_workspace(type, level);
+	start_ns = ktime_get_ns();
 	ret = btrfs_compress_op[type]->compress_pages(workspace, mapping,
 						      start, pages,
 						      out_pages,
 						      total_in, total_out);
+	this_cpu_inc(btrfs_compress_stats[type].compress_calls);
+	this_cpu_add(btrfs_compress_stats[type].compress_bytes_in, *total_in);
+	if (!ret)
+		this_cpu_add(btrfs_compress_stats[type].compress_bytes_out,
+			     *total_out);
+	this_cpu_add(btrfs_compress_stats[type].compress_ns,
+		     ktime_get_ns() - start_ns);
 	put_workspace(type, workspace);
 	return ret;
 }
@@ -1066,11 +1192,14 @@ int btrfs_compress_pages(unsigned int type_level, struct address_space *mapping,
 static int btrfs_decompress_bio(struct compressed_bio *cb)
 {
 	struct list_head *workspace;
+	u64 start_ns;
 	int ret;
 	int type = cb->compress_type;
 
 	workspace = get_workspace(type, 0);
+	start_ns = ktime_get_ns();
 	ret = btrfs_compress_op[type]->decompress_bio(workspace, cb);
+	account_decompress(type, start_ns, cb->compressed_len, cb->len);
 	put_workspace(type, workspace);
 
 	return ret;
@@ -1085,12 +1214,15 @@ int btrfs_decompress(int type, unsigned char *data_in, struct page *dest_page,
 		     unsigned long start_byte, size_t srclen, size_t destlen)
 {
 	struct list_head *workspace;
+	u64 start_ns;
 	int ret;
 
 	workspace = get_workspace(type, 0);
+	start_ns = ktime_get_ns();
 	ret = btrfs_compress_op[type]->decompress(workspace, data_in,
 						  dest_page, start_byte,
 						  srclen, destlen);
+	account_decompress(type, start_ns, srclen, destlen);
 	put_workspace(type, workspace);
 
 	return ret;
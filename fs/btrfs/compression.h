@@ -117,6 +117,8 @@ struct workspace_manager {
 	atomic_t total_ws;
 	/* Waiters for a free workspace */
 	wait_queue_head_t ws_wait;
+	/* One cached idle workspace per cpu, NULL if the allocation failed */
+	struct list_head * __percpu *pcpu_ws;
 };
 
 void btrfs_init_workspace_manager(struct workspace_manager *wsm,
@@ -172,6 +174,24 @@ extern const struct btrfs_compress_op btrfs_zlib_compress;
 extern const struct btrfs_compress_op btrfs_lzo_compress;
 extern const struct btrfs_compress_op btrfs_zstd_compress;
 
+/*
+ * Per algorithm counters, summed over all cpus.  Bytes in/out are the
+ * uncompressed/compressed sizes for compression and the other way around
+ * for decompression.
+ */
+struct btrfs_compress_stats {
+	u64 compress_calls;
+	u64 compress_bytes_in;
+	u64 compress_bytes_out;
+	u64 compress_ns;
+	u64 decompress_calls;
+	u64 decompress_bytes_in;
+	u64 decompress_bytes_out;
+	u64 decompress_ns;
+};
+
+void btrfs_compress_get_stats(int type, struct btrfs_compress_stats *stats);
+
 const char* btrfs_compress_type2str(enum btrfs_compression_type type);
 bool btrfs_compress_is_valid_type(const char *str, size_t len);
 
@@ -2165,6 +2165,22 @@ static void btrfs_init_qgroup(struct btrfs_fs_info *fs_info)
 	mutex_init(&fs_info->qgroup_rescan_lock);
 }
 
+/*
+ * Compressing delalloc ranges in async_cow_start() is cpu bound and every
+ * 512K chunk is independent, so unless the thread pool was sized with the
+ * thread_pool mount option let the delalloc workers use all online cpus
+ * rather than the default pool of at most 8 threads.
+ */
+u32 btrfs_delalloc_max_active(struct btrfs_fs_info *fs_info)
+{
+	u32 max_active = fs_info->thread_pool_size;
+
+	if (!btrfs_test_opt(fs_info, THREAD_POOL))
+		max_active = max_t(u32, max_active, num_online_cpus());
+
+	return max_active;
+}
+
 static int btrfs_init_workqueues(struct btrfs_fs_info *fs_info,
 		struct btrfs_fs_devices *fs_devices)
 {
@@ -2176,8 +2192,8 @@ static int btrfs_init_workqueues(struct btrfs_fs_info *fs_info,
 				      flags | WQ_HIGHPRI, max_active, 16);
 
 	fs_info->delalloc_workers =
-		btrfs_alloc_workqueue(fs_info, "delalloc",
-				      flags, max_active, 2);
+		btrfs_alloc_workqueue(fs_info, "delalloc", flags,
+				      btrfs_delalloc_max_active(fs_info), 2);
 
 	fs_info->flush_workers =
 		btrfs_alloc_workqueue(fs_info, "flush_delalloc",
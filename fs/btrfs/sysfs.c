@@ -17,6 +17,7 @@
 #include "sysfs.h"
 #include "volumes.h"
 #include "space-info.h"
+#include "compression.h"
 
 static inline struct btrfs_fs_info *to_fs_info(struct kobject *kobj);
 static inline struct btrfs_fs_devices *to_fs_devs(struct kobject *kobj);
@@ -247,6 +248,60 @@ static const struct attribute_group btrfs_static_feature_attr_group = {
 	.attrs = btrfs_supported_static_feature_attrs,
 };
 
+#define BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, _field)		\
+static ssize_t _alg##_##_field##_show(struct kobject *kobj,		\
+				      struct kobj_attribute *ka,	\
+				      char *buf)			\
+{									\
+	struct btrfs_compress_stats stats;				\
+									\
+	btrfs_compress_get_stats(_type, &stats);			\
+	return snprintf(buf, PAGE_SIZE, "%llu\n", stats._field);	\
+}									\
+BTRFS_ATTR(compression, _alg##_##_field, _alg##_##_field##_show)
+
+#define BTRFS_COMPRESSION_ATTRS(_alg, _type)				\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, compress_calls);	\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, compress_bytes_in);	\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, compress_bytes_out);	\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, compress_ns);		\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, decompress_calls);	\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, decompress_bytes_in);	\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, decompress_bytes_out);	\
+	BTRFS_COMPRESSION_STAT_ATTR(_alg, _type, decompress_ns)
+
+#define BTRFS_COMPRESSION_ATTR_PTRS(_alg)				\
+	BTRFS_ATTR_PTR(compression, _alg##_compress_calls),		\
+	BTRFS_ATTR_PTR(compression, _alg##_compress_bytes_in),		\
+	BTRFS_ATTR_PTR(compression, _alg##_compress_bytes_out),		\
+	BTRFS_ATTR_PTR(compression, _alg##_compress_ns),		\
+	BTRFS_ATTR_PTR(compression, _alg##_decompress_calls),		\
+	BTRFS_ATTR_PTR(compression, _alg##_decompress_bytes_in),	\
+	BTRFS_ATTR_PTR(compression, _alg##_decompress_bytes_out),	\
+	BTRFS_ATTR_PTR(compression, _alg##_decompress_ns)
+
+BTRFS_COMPRESSION_ATTRS(zlib, BTRFS_COMPRESS_ZLIB);
+BTRFS_COMPRESSION_ATTRS(lzo, BTRFS_COMPRESS_LZO);
+BTRFS_COMPRESSION_ATTRS(zstd, BTRFS_COMPRESS_ZSTD);
+
+static struct attribute *btrfs_compression_attrs[] = {
+	BTRFS_COMPRESSION_ATTR_PTRS(zlib),
+	BTRFS_COMPRESSION_ATTR_PTRS(lzo),
+	BTRFS_COMPRESSION_ATTR_PTRS(zstd),
+	NULL
+};
+
+/*
+ * Compression statistics of all filesystems in /sys/fs/btrfs/compression,
+ * one file per algorithm and counter, e.g. zstd_compress_bytes_in.  Each
+ * algorithm counts calls, bytes in, bytes out and nanoseconds spent, for
+ * compression and decompression.
+ */
+static const struct attribute_group btrfs_compression_attr_group = {
+	.name = "compression",
+	.attrs = btrfs_compression_attrs,
+};
+
 static ssize_t btrfs_show_u64(u64 *value_ptr, spinlock_t *lock, char *buf)
 {
 	u64 val;
@@ -950,9 +1005,16 @@ int __init btrfs_init_sysfs(void)
 				&btrfs_static_feature_attr_group);
 	if (ret)
 		goto out_remove_group;
+	ret = sysfs_create_group(&btrfs_kset->kobj,
+				 &btrfs_compression_attr_group);
+	if (ret)
+		goto out_unmerge_group;
 
 	return 0;
 
+out_unmerge_group:
+	sysfs_unmerge_group(&btrfs_kset->kobj,
+			    &btrfs_static_feature_attr_group);
 out_remove_group:
 	sysfs_remove_group(&btrfs_kset->kobj, &btrfs_feature_attr_group);
 out2:
@@ -964,6 +1026,7 @@ int __init btrfs_init_sysfs(void)
 
 void __cold btrfs_exit_sysfs(void)
 {
+	sysfs_remove_group(&btrfs_kset->kobj, &btrfs_compression_attr_group);
 	sysfs_unmerge_group(&btrfs_kset->kobj,
 			    &btrfs_static_feature_attr_group);
 	sysfs_remove_group(&btrfs_kset->kobj, &btrfs_feature_attr_group);
@@ -176,10 +176,10 @@ static unsigned int num_clusters_in_group(struct super_block *sb,
 }
 
 /* Initializes an uninitialized block bitmap */
-static int ext4_init_block_bitmap(struct super_block *sb,
-				   struct buffer_head *bh,
-				   ext4_group_t block_group,
-				   struct ext4_group_desc *gdp)
+int ext4_init_block_bitmap(struct super_block *sb,
+			   struct buffer_head *bh,
+			   ext4_group_t block_group,
+			   struct ext4_group_desc *gdp)
 {
 	unsigned int bit, bit_max;
 	struct ext4_sb_info *sbi = EXT4_SB(sb);
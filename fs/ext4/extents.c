@@ -5240,6 +5240,9 @@ ext4_ext_shift_extents(struct inode *inode, handle_t *handle,
 	struct ext4_extent *extent;
 	ext4_lblk_t stop, *iterator, ex_start, ex_end;
 
+	/* Fast commit replay only adds blocks, it cannot move them */
+	ext4_fc_mark_ineligible(handle, inode);
+
 	/* Let path point to the last extent */
 	path = ext4_find_extent(inode, EXT_MAX_BLOCKS - 1, NULL,
 				EXT4_EX_NOCACHE);
@@ -5594,6 +5597,7 @@ int ext4_insert_range(struct inode *inode, loff_t offset, loff_t len)
 		ret = PTR_ERR(handle);
 		goto out_mmap;
 	}
+	ext4_fc_mark_ineligible(handle, inode);
 
 	/* Expand file to avoid data loss if there is error while shifting */
 	inode->i_size += len;
@@ -5709,6 +5713,9 @@ ext4_swap_extents(handle_t *handle, struct inode *inode1,
 	BUG_ON(!inode_is_locked(inode1));
 	BUG_ON(!inode_is_locked(inode2));
 
+	ext4_fc_mark_ineligible(handle, inode1);
+	ext4_fc_mark_ineligible(handle, inode2);
+
 	*erp = ext4_es_remove_extent(inode1, lblk1, count);
 	if (unlikely(*erp))
 		return 0;
@@ -0,0 +1,611 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *  fs/ext4/fast_commit.c
+ *
+ * Ext4 fast commits.
+ *
+ * An fsync() of a regular file whose changes in the running transaction
+ * are simple enough does not commit the whole transaction.  Instead, the
+ * raw inode and the extents it maps are written to the fast commit area
+ * at the end of the journal, after the file data.  After a crash, jbd2
+ * replays the regular log and then hands the fast commit blocks of the
+ * first transaction missing from it to ext4_fc_replay(), which writes
+ * the inodes back and marks their blocks in use.
+ *
+ * Replay starts from the state of the last full commit, so a fast commit
+ * can only describe changes that make sense on top of it.  An inode is
+ * eligible when its extent tree fits in the inode and the transaction
+ * only grew it.  Anything else (freeing blocks, link count and orphan
+ * list changes, xattrs, resizing) marks the inode or the whole
+ * transaction ineligible before the change is made, and fsync falls back
+ * to a full commit.  The tracking state is reset whenever the transaction
+ * changes.
+ */
+#include <linux/blkdev.h>
+#include <linux/crc32.h>
+#include <linux/quotaops.h>
+#include <linux/writeback.h>
+#include "ext4.h"
+#include "ext4_jbd2.h"
+#include "ext4_extents.h"
+#include "fast_commit.h"
+
+static inline bool ext4_fc_tracking(struct super_block *sb, handle_t *handle)
+{
+	return ext4_handle_valid(handle) &&
+		test_opt2(sb, JOURNAL_FAST_COMMIT);
+}
+
+/* Called with s_fc_lock held */
+static void ext4_fc_reset_inode(struct ext4_inode_info *ei, tid_t tid)
+{
+	if (ei->i_fc_tid == tid)
+		return;
+	ei->i_fc_tid = tid;
+	ei->i_fc_lblk_start = 0;
+	ei->i_fc_lblk_len = 0;
+	ei->i_fc_ineligible = false;
+}
+
+/*
+ * Mark @inode as not fast committable in the running transaction.  Must
+ * be called before making the change that needs a full commit.
+ */
+void ext4_fc_mark_ineligible(handle_t *handle, struct inode *inode)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(inode->i_sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+
+	if (!ext4_fc_tracking(inode->i_sb, handle))
+		return;
+
+	spin_lock(&sbi->s_fc_lock);
+	ext4_fc_reset_inode(ei, handle->h_transaction->t_tid);
+	ei->i_fc_ineligible = true;
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+/*
+ * Same for changes that affect other inodes than the one they are made
+ * for, such as blocks freed for immediate reuse.
+ */
+void ext4_fc_mark_ineligible_sb(struct super_block *sb, handle_t *handle)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+
+	if (!ext4_fc_tracking(sb, handle))
+		return;
+
+	spin_lock(&sbi->s_fc_lock);
+	sbi->s_fc_ineligible_tid = handle->h_transaction->t_tid;
+	sbi->s_fc_ineligible = true;
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+/* The raw inode of @inode has been updated */
+void ext4_fc_track_inode(handle_t *handle, struct inode *inode)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(inode->i_sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+
+	if (!ext4_fc_tracking(inode->i_sb, handle))
+		return;
+
+	spin_lock(&sbi->s_fc_lock);
+	ext4_fc_reset_inode(ei, handle->h_transaction->t_tid);
+	ei->i_fc_dirty = true;
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+/*
+ * Blocks @lblk to @lblk + @len - 1 of @inode may have been allocated or
+ * converted.  Called with i_data_sem held for writing.
+ */
+void ext4_fc_track_range(handle_t *handle, struct inode *inode,
+			 ext4_lblk_t lblk, ext4_lblk_t len)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(inode->i_sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	ext4_lblk_t end;
+	bool ineligible;
+
+	if (!ext4_fc_tracking(inode->i_sb, handle) || !len)
+		return;
+
+	/* Only extents kept in the inode itself are logged */
+	ineligible = !ext4_test_inode_flag(inode, EXT4_INODE_EXTENTS) ||
+		     ext_depth(inode) > 0;
+
+	spin_lock(&sbi->s_fc_lock);
+	ext4_fc_reset_inode(ei, handle->h_transaction->t_tid);
+	if (ineligible)
+		ei->i_fc_ineligible = true;
+	if (!ei->i_fc_lblk_len) {
+		ei->i_fc_lblk_start = lblk;
+		ei->i_fc_lblk_len = len;
+	} else {
+		end = max(ei->i_fc_lblk_start + ei->i_fc_lblk_len, lblk + len);
+		ei->i_fc_lblk_start = min(ei->i_fc_lblk_start, lblk);
+		ei->i_fc_lblk_len = end - ei->i_fc_lblk_start;
+	}
+	ei->i_fc_dirty = true;
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+/* State of the fast commit being written */
+struct ext4_fc_writer {
+	journal_t *journal;
+	struct buffer_head *bh;		/* block being filled, locked */
+	int off;			/* bytes used in bh */
+	int nblocks;			/* blocks submitted */
+	u32 crc;
+};
+
+static void ext4_fc_submit_block(struct ext4_fc_writer *w)
+{
+	struct buffer_head *bh = w->bh;
+	int op_flags = REQ_SYNC;
+
+	/* The first block also orders the file data written before it */
+	if (w->journal->j_flags & JBD2_BARRIER) {
+		op_flags |= REQ_FUA;
+		if (!w->nblocks)
+			op_flags |= REQ_PREFLUSH;
+	}
+
+	clear_buffer_dirty(bh);
+	set_buffer_uptodate(bh);
+	get_bh(bh);
+	bh->b_end_io = end_buffer_write_sync;
+	submit_bh(REQ_OP_WRITE, op_flags, bh);
+	w->bh = NULL;
+	w->nblocks++;
+}
+
+/*
+ * Add a tag with @len bytes of value and return where the value goes,
+ * moving on to a new block if it does not fit in the current one.
+ */
+static void *ext4_fc_reserve(struct ext4_fc_writer *w, u16 tag, int len)
+{
+	int blocksize = w->journal->j_blocksize;
+	struct ext4_fc_tl tl;
+	void *dst;
+	int err;
+
+	if (w->bh && w->off + sizeof(tl) + len > blocksize) {
+		if (w->off < blocksize) {
+			tl.fc_tag = cpu_to_le16(EXT4_FC_TAG_PAD);
+			tl.fc_len = cpu_to_le16(blocksize - w->off - sizeof(tl));
+			memcpy(w->bh->b_data + w->off, &tl, sizeof(tl));
+		}
+		w->crc = crc32_le(w->crc, w->bh->b_data, blocksize);
+		ext4_fc_submit_block(w);
+	}
+
+	if (!w->bh) {
+		err = jbd2_fc_get_buf(w->journal, &w->bh);
+		if (err)
+			return ERR_PTR(err);
+		lock_buffer(w->bh);
+		memset(w->bh->b_data, 0, blocksize);
+		w->off = 0;
+	}
+
+	tl.fc_tag = cpu_to_le16(tag);
+	tl.fc_len = cpu_to_le16(len);
+	memcpy(w->bh->b_data + w->off, &tl, sizeof(tl));
+	dst = w->bh->b_data + w->off + sizeof(tl);
+	w->off += sizeof(tl) + len;
+	return dst;
+}
+
+/*
+ * Write back the data in the given byte range, as the commit code does
+ * for data=ordered.  No handle may be started here: a full commit is
+ * waiting for this fast commit to finish.
+ */
+static int ext4_fc_write_data(struct inode *inode, loff_t start, loff_t end)
+{
+	struct address_space *mapping = inode->i_mapping;
+	struct writeback_control wbc = {
+		.sync_mode = WB_SYNC_ALL,
+		.nr_to_write = mapping->nrpages * 2,
+		.range_start = start,
+		.range_end = end,
+	};
+	int ret, err;
+
+	ret = generic_writepages(mapping, &wbc);
+	err = filemap_fdatawait_range_keep_errors(mapping, start, end);
+	return ret ? ret : err;
+}
+
+/*
+ * Log @inode into the fast commit area.  Returns 0 once it is on disk, or
+ * if it has not changed since its last fast commit, and an error if a
+ * full commit is needed instead.
+ */
+static int ext4_fc_write_inode(journal_t *journal, tid_t tid,
+			       struct inode *inode)
+{
+	struct super_block *sb = inode->i_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	int inode_len = EXT4_INODE_SIZE(sb);
+	struct ext4_fc_writer w = { .journal = journal, .crc = ~0 };
+	struct ext4_extent_header *eh;
+	struct ext4_fc_add_range *fc_add;
+	struct ext4_fc_inode *fc_inode;
+	struct ext4_fc_tail *fc_tail;
+	struct ext4_extent *ex;
+	struct ext4_inode *raw;
+	struct ext4_iloc iloc;
+	ext4_lblk_t lblk_start, lblk_len;
+	bool dirty, eligible;
+	int i, ret;
+
+	if (!S_ISREG(inode->i_mode) ||
+	    !ext4_test_inode_flag(inode, EXT4_INODE_EXTENTS) ||
+	    ext4_has_inline_data(inode) || ext4_should_journal_data(inode) ||
+	    inode->i_ino < EXT4_FIRST_INO(sb) || sb_any_quota_loaded(sb) ||
+	    sizeof(struct ext4_fc_tl) + sizeof(*fc_inode) + inode_len >
+	    journal->j_blocksize)
+		return -EINVAL;
+
+	raw = kmalloc(inode_len, GFP_NOFS);
+	if (!raw)
+		return -ENOMEM;
+
+	/*
+	 * Clear the dirty flag before taking the snapshot: an update racing
+	 * with it sets the flag again and is picked up next time.  The
+	 * eligibility is checked after the snapshot, as it is marked before
+	 * the changes it is about.
+	 */
+	spin_lock(&sbi->s_fc_lock);
+	dirty = ei->i_fc_dirty;
+	ei->i_fc_dirty = false;
+	spin_unlock(&sbi->s_fc_lock);
+
+	down_read(&ei->i_data_sem);
+	ret = ext4_get_inode_loc(inode, &iloc);
+	if (!ret) {
+		spin_lock(&ei->i_raw_lock);
+		memcpy(raw, ext4_raw_inode(&iloc), inode_len);
+		spin_unlock(&ei->i_raw_lock);
+		brelse(iloc.bh);
+	}
+	up_read(&ei->i_data_sem);
+	if (ret)
+		goto out;
+
+	spin_lock(&sbi->s_fc_lock);
+	eligible = ei->i_fc_tid == tid && !ei->i_fc_ineligible &&
+		   !(sbi->s_fc_ineligible && sbi->s_fc_ineligible_tid == tid);
+	lblk_start = ei->i_fc_lblk_start;
+	lblk_len = ei->i_fc_lblk_len;
+	spin_unlock(&sbi->s_fc_lock);
+
+	ret = -EINVAL;
+	eh = (struct ext4_extent_header *)raw->i_block;
+	if (!eligible || eh->eh_magic != EXT4_EXT_MAGIC || eh->eh_depth ||
+	    le16_to_cpu(eh->eh_entries) > le16_to_cpu(eh->eh_max))
+		goto out;
+	ret = 0;
+	if (!dirty)
+		goto out;
+
+	if (lblk_len && ext4_should_order_data(inode)) {
+		ret = ext4_fc_write_data(inode,
+			(loff_t)lblk_start << inode->i_blkbits,
+			((loff_t)(lblk_start + lblk_len) << inode->i_blkbits) - 1);
+		if (ret)
+			goto out;
+	}
+
+	/* The flush of the first block does not reach an external journal */
+	if (journal->j_fs_dev != journal->j_dev &&
+	    (journal->j_flags & JBD2_BARRIER)) {
+		ret = blkdev_issue_flush(journal->j_fs_dev, GFP_NOFS, NULL);
+		if (ret)
+			goto out;
+	}
+
+	/*
+	 * Log every extent rather than just the tracked range: marking
+	 * blocks that are already in use again is harmless, and there are
+	 * at most four of them.
+	 */
+	ex = EXT_FIRST_EXTENT(eh);
+	for (i = 0; i < le16_to_cpu(eh->eh_entries); i++, ex++) {
+		fc_add = ext4_fc_reserve(&w, EXT4_FC_TAG_ADD_RANGE,
+					 sizeof(*fc_add));
+		if (IS_ERR(fc_add)) {
+			ret = PTR_ERR(fc_add);
+			goto out_bufs;
+		}
+		fc_add->fc_ino = cpu_to_le32(inode->i_ino);
+		memcpy(fc_add->fc_ex, ex, sizeof(fc_add->fc_ex));
+	}
+
+	fc_inode = ext4_fc_reserve(&w, EXT4_FC_TAG_INODE,
+				   sizeof(*fc_inode) + inode_len);
+	if (IS_ERR(fc_inode)) {
+		ret = PTR_ERR(fc_inode);
+		goto out_bufs;
+	}
+	fc_inode->fc_ino = cpu_to_le32(inode->i_ino);
+	memcpy(fc_inode->fc_raw_inode, raw, inode_len);
+
+	fc_tail = ext4_fc_reserve(&w, EXT4_FC_TAG_TAIL, sizeof(*fc_tail));
+	if (IS_ERR(fc_tail)) {
+		ret = PTR_ERR(fc_tail);
+		goto out_bufs;
+	}
+	fc_tail->fc_tid = cpu_to_le32(tid);
+	w.crc = crc32_le(w.crc, w.bh->b_data,
+			 (u8 *)&fc_tail->fc_crc - (u8 *)w.bh->b_data);
+	fc_tail->fc_crc = cpu_to_le32(w.crc);
+	ext4_fc_submit_block(&w);
+
+	ret = jbd2_fc_wait_bufs(journal, w.nblocks);
+	if (!ret)
+		goto out;
+
+out_bufs:
+	if (w.bh)
+		unlock_buffer(w.bh);
+	jbd2_fc_release_bufs(journal);
+out:
+	kfree(raw);
+	return ret;
+}
+
+/**
+ * ext4_fc_commit() - Make the changes to an inode durable.
+ * @journal: journal of the filesystem
+ * @commit_tid: transaction that holds the changes
+ * @inode: inode being synced
+ *
+ * Uses a fast commit if possible and commits @commit_tid otherwise.
+ */
+int ext4_fc_commit(journal_t *journal, tid_t commit_tid, struct inode *inode)
+{
+	int ret;
+
+	if (!test_opt2(inode->i_sb, JOURNAL_FAST_COMMIT))
+		return jbd2_complete_transaction(journal, commit_tid);
+
+	do {
+		ret = jbd2_fc_begin_commit(journal, commit_tid);
+	} while (ret == -EAGAIN);
+	if (ret == -EALREADY)
+		return 0;
+	if (ret)
+		return jbd2_complete_transaction(journal, commit_tid);
+
+	if (ext4_fc_write_inode(journal, commit_tid, inode))
+		return jbd2_fc_end_commit_fallback(journal);
+	return jbd2_fc_end_commit(journal);
+}
+
+static int ext4_fc_replay_scan(struct super_block *sb, struct buffer_head *bh,
+			       int off, tid_t expected_tid)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	u8 *start = (u8 *)bh->b_data, *end = start + bh->b_size, *cur;
+	struct ext4_fc_tail tail;
+	struct ext4_fc_tl tl;
+	int len;
+
+	if (off == 0) {
+		sbi->s_fc_replay_valid = 0;
+		sbi->s_fc_replay_crc = ~0;
+	}
+
+	for (cur = start; cur + sizeof(tl) <= end; cur += sizeof(tl) + len) {
+		memcpy(&tl, cur, sizeof(tl));
+		len = le16_to_cpu(tl.fc_len);
+		if (cur + sizeof(tl) + len > end)
+			return JBD2_FC_REPLAY_STOP;
+
+		switch (le16_to_cpu(tl.fc_tag)) {
+		case EXT4_FC_TAG_ADD_RANGE:
+			if (len != sizeof(struct ext4_fc_add_range))
+				return JBD2_FC_REPLAY_STOP;
+			break;
+		case EXT4_FC_TAG_INODE:
+			if (len != sizeof(struct ext4_fc_inode) +
+				   EXT4_INODE_SIZE(sb))
+				return JBD2_FC_REPLAY_STOP;
+			break;
+		case EXT4_FC_TAG_PAD:
+			break;
+		case EXT4_FC_TAG_TAIL:
+			if (len != sizeof(tail))
+				return JBD2_FC_REPLAY_STOP;
+			memcpy(&tail, cur + sizeof(tl), sizeof(tail));
+			sbi->s_fc_replay_crc = crc32_le(sbi->s_fc_replay_crc,
+				start, cur + sizeof(tl) +
+				offsetof(struct ext4_fc_tail, fc_crc) - start);
+			if (le32_to_cpu(tail.fc_tid) != expected_tid ||
+			    le32_to_cpu(tail.fc_crc) != sbi->s_fc_replay_crc)
+				return JBD2_FC_REPLAY_STOP;
+			sbi->s_fc_replay_valid = off + 1;
+			sbi->s_fc_replay_crc = ~0;
+			return JBD2_FC_REPLAY_CONTINUE;
+		default:
+			return JBD2_FC_REPLAY_STOP;
+		}
+	}
+
+	sbi->s_fc_replay_crc = crc32_le(sbi->s_fc_replay_crc, start,
+					bh->b_size);
+	return JBD2_FC_REPLAY_CONTINUE;
+}
+
+static int ext4_fc_replay_inode(struct super_block *sb,
+				struct ext4_fc_inode *fc_inode)
+{
+	unsigned long ino = le32_to_cpu(fc_inode->fc_ino);
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_group_desc *gdp;
+	struct buffer_head *bh;
+	unsigned long inode_offset;
+	ext4_fsblk_t block;
+
+	if (ino < EXT4_FIRST_INO(sb) ||
+	    ino > le32_to_cpu(sbi->s_es->s_inodes_count))
+		return -EFSCORRUPTED;
+
+	gdp = ext4_get_group_desc(sb, (ino - 1) / EXT4_INODES_PER_GROUP(sb),
+				  NULL);
+	if (!gdp)
+		return -EFSCORRUPTED;
+	inode_offset = (ino - 1) % EXT4_INODES_PER_GROUP(sb);
+	block = ext4_inode_table(sb, gdp) +
+		inode_offset / sbi->s_inodes_per_block;
+
+	bh = sb_bread(sb, block);
+	if (!bh)
+		return -EIO;
+	memcpy(bh->b_data + (inode_offset % sbi->s_inodes_per_block) *
+	       EXT4_INODE_SIZE(sb), fc_inode->fc_raw_inode,
+	       EXT4_INODE_SIZE(sb));
+	mark_buffer_dirty(bh);
+	brelse(bh);
+	return 0;
+}
+
+/*
+ * Mark @count blocks from @bit in @group in use.  The mballoc structures
+ * do not exist yet during recovery, so this works on the bitmap directly.
+ */
+static int ext4_fc_replay_mark_used(struct super_block *sb,
+				    ext4_group_t group, ext4_grpblk_t bit,
+				    unsigned int count)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct buffer_head *bh, *gd_bh;
+	struct ext4_group_desc *gdp;
+	unsigned int cluster;
+	int err;
+
+	gdp = ext4_get_group_desc(sb, group, &gd_bh);
+	if (!gdp)
+		return -EFSCORRUPTED;
+
+	if (ext4_has_group_desc_csum(sb) &&
+	    (gdp->bg_flags & cpu_to_le16(EXT4_BG_BLOCK_UNINIT))) {
+		if (!ext4_group_desc_csum_verify(sb, group, gdp))
+			return -EFSBADCRC;
+		bh = sb_getblk(sb, ext4_block_bitmap(sb, gdp));
+		if (!bh)
+			return -ENOMEM;
+		lock_buffer(bh);
+		err = ext4_init_block_bitmap(sb, bh, group, gdp);
+		if (!err)
+			set_buffer_uptodate(bh);
+		unlock_buffer(bh);
+		if (err) {
+			brelse(bh);
+			return err;
+		}
+		gdp->bg_flags &= cpu_to_le16(~EXT4_BG_BLOCK_UNINIT);
+	} else {
+		bh = sb_bread(sb, ext4_block_bitmap(sb, gdp));
+		if (!bh)
+			return -EIO;
+	}
+
+	for (cluster = EXT4_B2C(sbi, bit);
+	     cluster <= EXT4_B2C(sbi, bit + count - 1); cluster++)
+		ext4_set_bit(cluster, bh->b_data);
+	ext4_free_group_clusters_set(sb, gdp,
+		ext4_count_free(bh->b_data, EXT4_CLUSTERS_PER_GROUP(sb) / 8));
+	ext4_block_bitmap_csum_set(sb, group, gdp, bh);
+	ext4_group_desc_csum_set(sb, group, gdp);
+	mark_buffer_dirty(bh);
+	mark_buffer_dirty(gd_bh);
+	brelse(bh);
+	return 0;
+}
+
+static int ext4_fc_replay_add_range(struct super_block *sb,
+				    struct ext4_fc_add_range *fc_add)
+{
+	struct ext4_extent *ex = (struct ext4_extent *)fc_add->fc_ex;
+	struct ext4_super_block *es = EXT4_SB(sb)->s_es;
+	ext4_fsblk_t pblk = ext4_ext_pblock(ex);
+	unsigned int len = ext4_ext_get_actual_len(ex);
+	ext4_group_t group;
+	ext4_grpblk_t bit;
+	unsigned int count;
+	int err;
+
+	if (!len || pblk < le32_to_cpu(es->s_first_data_block) ||
+	    pblk + len < pblk || pblk + len > ext4_blocks_count(es))
+		return -EFSCORRUPTED;
+
+	while (len) {
+		ext4_get_group_no_and_offset(sb, pblk, &group, &bit);
+		count = min_t(unsigned int, len,
+			      EXT4_BLOCKS_PER_GROUP(sb) - bit);
+		err = ext4_fc_replay_mark_used(sb, group, bit, count);
+		if (err)
+			return err;
+		pblk += count;
+		len -= count;
+	}
+	return 0;
+}
+
+static int ext4_fc_replay_block(struct super_block *sb,
+				struct buffer_head *bh, int off)
+{
+	u8 *start = (u8 *)bh->b_data, *end = start + bh->b_size, *cur;
+	struct ext4_fc_tl tl;
+	int len, err = 0;
+
+	for (cur = start; cur + sizeof(tl) <= end; cur += sizeof(tl) + len) {
+		memcpy(&tl, cur, sizeof(tl));
+		len = le16_to_cpu(tl.fc_len);
+
+		switch (le16_to_cpu(tl.fc_tag)) {
+		case EXT4_FC_TAG_ADD_RANGE:
+			err = ext4_fc_replay_add_range(sb,
+				(struct ext4_fc_add_range *)(cur + sizeof(tl)));
+			break;
+		case EXT4_FC_TAG_INODE:
+			err = ext4_fc_replay_inode(sb,
+				(struct ext4_fc_inode *)(cur + sizeof(tl)));
+			break;
+		case EXT4_FC_TAG_TAIL:
+			if (off + 1 == EXT4_SB(sb)->s_fc_replay_valid)
+				ext4_msg(sb, KERN_INFO, "recovered %d fast "
+					 "commit blocks", off + 1);
+			return JBD2_FC_REPLAY_CONTINUE;
+		}
+		if (err)
+			return err;
+	}
+	return JBD2_FC_REPLAY_CONTINUE;
+}
+
+/*
+ * jbd2 recovery callback.  The scan pass checks the tags and checksums
+ * and remembers how many blocks hold complete fast commits of
+ * @expected_tid; the replay pass applies them.
+ */
+int ext4_fc_replay(journal_t *journal, struct buffer_head *bh,
+		   enum passtype pass, int off, tid_t expected_tid)
+{
+	struct super_block *sb = journal->j_private;
+
+	if (pass == PASS_SCAN)
+		return ext4_fc_replay_scan(sb, bh, off, expected_tid);
+	if (off >= EXT4_SB(sb)->s_fc_replay_valid)
+		return JBD2_FC_REPLAY_STOP;
+	return ext4_fc_replay_block(sb, bh, off);
+}
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef __FAST_COMMIT_H__
+#define __FAST_COMMIT_H__
+
+/*
+ * On-disk format of the fast commit area.  Each block is a sequence of
+ * tag-length-value records, padded to the end of the block.  A commit is
+ * ended by a tail, which also ends its block; the tail's checksum covers
+ * every block of the commit up to the checksum itself.
+ */
+
+/* Fast commit tags */
+#define EXT4_FC_TAG_ADD_RANGE		0x0001
+#define EXT4_FC_TAG_INODE		0x0002
+#define EXT4_FC_TAG_PAD			0x0003
+#define EXT4_FC_TAG_TAIL		0x0004
+
+/* Fast commit on disk tag length structure */
+struct ext4_fc_tl {
+	__le16 fc_tag;
+	__le16 fc_len;
+};
+
+/* Value structure for tag EXT4_FC_TAG_ADD_RANGE */
+struct ext4_fc_add_range {
+	__le32 fc_ino;
+	__u8 fc_ex[12];			/* struct ext4_extent */
+};
+
+/* Value structure for tag EXT4_FC_TAG_INODE */
+struct ext4_fc_inode {
+	__le32 fc_ino;
+	__u8 fc_raw_inode[0];		/* EXT4_INODE_SIZE() bytes */
+};
+
+/* Value structure for tag EXT4_FC_TAG_TAIL */
+struct ext4_fc_tail {
+	__le32 fc_tid;
+	__le32 fc_crc;
+};
+
+#endif /* __FAST_COMMIT_H__ */
@@ -660,6 +660,7 @@ int ext4_map_blocks(handle_t *handle, struct inode *inode,
 			(flags & EXT4_GET_BLOCKS_DELALLOC_RESERVE))
 			ext4_da_update_reserve_space(inode, retval, 1);
 	}
+	ext4_fc_track_range(handle, inode, map->m_lblk, map->m_len);
 
 	if (retval > 0) {
 		unsigned int status;
@@ -5256,6 +5257,15 @@ static int ext4_do_update_inode(handle_t *handle,
 
 	spin_lock(&ei->i_raw_lock);
 
+	/*
+	 * Fast commit replay leaves directories, the orphan list and the
+	 * inode bitmaps alone, so changes to them need a full commit.
+	 */
+	if (ext4_test_inode_state(inode, EXT4_STATE_NEW) ||
+	    raw_inode->i_links_count != cpu_to_le16(inode->i_nlink) ||
+	    raw_inode->i_dtime != cpu_to_le32(ei->i_dtime))
+		ext4_fc_mark_ineligible(handle, inode);
+
 	/* For fields not tracked in the in-memory inode,
 	 * initialise them to zero for new inodes. */
 	if (ext4_test_inode_state(inode, EXT4_STATE_NEW))
@@ -5312,8 +5322,10 @@ static int ext4_do_update_inode(handle_t *handle,
 	if (ei->i_disksize > 0x7fffffffULL) {
 		if (!ext4_has_feature_large_file(sb) ||
 				EXT4_SB(sb)->s_es->s_rev_level ==
-		    cpu_to_le32(EXT4_GOOD_OLD_REV))
+		    cpu_to_le32(EXT4_GOOD_OLD_REV)) {
+			ext4_fc_mark_ineligible(handle, inode);
 			set_large_file = 1;
+		}
 	}
 	raw_inode->i_generation = cpu_to_le32(inode->i_generation);
 	if (S_ISCHR(inode->i_mode) || S_ISBLK(inode->i_mode)) {
@@ -5898,6 +5910,7 @@ int ext4_mark_iloc_dirty(handle_t *handle,
 
 	/* ext4_do_update_inode() does jbd2_journal_dirty_metadata */
 	err = ext4_do_update_inode(handle, inode, iloc);
+	ext4_fc_track_inode(handle, inode);
 	put_bh(iloc->bh);
 	return err;
 }
@@ -165,6 +165,8 @@ static long swap_inode_boot_loader(struct super_block *sb,
 		err = -EINVAL;
 		goto err_out;
 	}
+	ext4_fc_mark_ineligible(handle, inode);
+	ext4_fc_mark_ineligible(handle, inode_bl);
 
 	/* Protect extent tree against block allocations via delalloc */
 	ext4_double_down_write_data_sem(inode, inode_bl);
@@ -4726,6 +4726,9 @@ void ext4_free_blocks(handle_t *handle, struct inode *inode,
 			block = bh->b_blocknr;
 	}
 
+	/* Fast commit replay can only add blocks */
+	ext4_fc_mark_ineligible(handle, inode);
+
 	sbi = EXT4_SB(sb);
 	if (!(flags & EXT4_FREE_BLOCKS_VALIDATED) &&
 	    !ext4_data_block_valid(sbi, block, count)) {
@@ -4900,6 +4903,8 @@ void ext4_free_blocks(handle_t *handle, struct inode *inode,
 		} else
 			EXT4_MB_GRP_CLEAR_TRIMMED(e4b.bd_info);
 
+		/* The blocks may now be reused by any inode */
+		ext4_fc_mark_ineligible_sb(sb, handle);
 		ext4_lock_group(sb, block_group);
 		mb_clear_bits(bitmap_bh->b_data, bit, count_clusters);
 		mb_free_blocks(inode, &e4b, bit, count_clusters);
@@ -815,6 +815,240 @@ int jbd2_journal_bmap(journal_t *journal, unsigned long blocknr,
 	return err;
 }
 
+/*
+ * Fast commits.
+ *
+ * A fast commit logs a compact, filesystem defined description of the
+ * changes made by the running transaction into a dedicated area at the
+ * end of the journal, instead of writing out every modified metadata
+ * block.  jbd2 only owns the area and the serialisation against full
+ * commits: the client fs formats the blocks and replays them through
+ * j_fc_replay_callback during recovery.  The area is reset by every full
+ * commit, so it only ever describes changes made after the last
+ * transaction committed to the regular log.
+ */
+
+/**
+ * int jbd2_fc_begin_commit() - Start a fast commit.
+ * @journal: Journal to act on.
+ * @tid: Transaction the fast commit is for.
+ *
+ * Returns 0 if the caller may go ahead with the fast commit, -EALREADY if
+ * @tid has already been committed, -EAGAIN after waiting for another fast
+ * or full commit to finish (the caller should try again), and -EINVAL if
+ * fast commits cannot be used on this journal right now.
+ */
+int jbd2_fc_begin_commit(journal_t *journal, tid_t tid)
+{
+	DEFINE_WAIT(wait);
+
+	write_lock(&journal->j_state_lock);
+	if (!jbd2_has_feature_fast_commit(journal) || !journal->j_fc_wbuf ||
+	    is_journal_aborted(journal)) {
+		write_unlock(&journal->j_state_lock);
+		return -EINVAL;
+	}
+
+	if (tid_geq(journal->j_commit_sequence, tid)) {
+		write_unlock(&journal->j_state_lock);
+		return -EALREADY;
+	}
+
+	/*
+	 * An on-disk superblock marking the log empty makes recovery skip
+	 * the fast commit area as well.  The next full commit rewrites it.
+	 */
+	if (journal->j_flags & JBD2_FLUSHED) {
+		write_unlock(&journal->j_state_lock);
+		return -EINVAL;
+	}
+
+	if (journal->j_flags & (JBD2_FULL_COMMIT_ONGOING |
+				JBD2_FAST_COMMIT_ONGOING)) {
+		prepare_to_wait(&journal->j_fc_wait, &wait,
+				TASK_UNINTERRUPTIBLE);
+		write_unlock(&journal->j_state_lock);
+		schedule();
+		finish_wait(&journal->j_fc_wait, &wait);
+		return -EAGAIN;
+	}
+	journal->j_flags |= JBD2_FAST_COMMIT_ONGOING;
+	write_unlock(&journal->j_state_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_begin_commit);
+
+static int __jbd2_fc_end_commit(journal_t *journal, bool fallback)
+{
+	tid_t tid = 0;
+	int ret;
+
+	write_lock(&journal->j_state_lock);
+	journal->j_flags &= ~JBD2_FAST_COMMIT_ONGOING;
+	/*
+	 * Keep other fast commits out until the fallback commit is done;
+	 * the commit code clears the flag once the fast commit area has
+	 * been reset.  Without a running transaction there is nothing left
+	 * to fall back to.
+	 */
+	if (fallback && journal->j_running_transaction) {
+		tid = journal->j_running_transaction->t_tid;
+		journal->j_flags |= JBD2_FULL_COMMIT_ONGOING;
+	} else {
+		fallback = false;
+	}
+	write_unlock(&journal->j_state_lock);
+	wake_up(&journal->j_fc_wait);
+
+	spin_lock(&journal->j_history_lock);
+	if (fallback)
+		journal->j_stats.ts_fc_fallbacks++;
+	else
+		journal->j_stats.ts_fc_commits++;
+	spin_unlock(&journal->j_history_lock);
+
+	if (!fallback)
+		return 0;
+
+	ret = jbd2_complete_transaction(journal, tid);
+	/*
+	 * An aborted journal may never get to the end of a commit, which
+	 * is where the flag is normally cleared.  No fast commit can start
+	 * on it anyway, so just let the waiters go.
+	 */
+	if (ret || is_journal_aborted(journal)) {
+		write_lock(&journal->j_state_lock);
+		journal->j_flags &= ~JBD2_FULL_COMMIT_ONGOING;
+		write_unlock(&journal->j_state_lock);
+		wake_up(&journal->j_fc_wait);
+	}
+	return ret;
+}
+
+/**
+ * int jbd2_fc_end_commit() - Finish a fast commit.
+ * @journal: Journal to act on.
+ */
+int jbd2_fc_end_commit(journal_t *journal)
+{
+	return __jbd2_fc_end_commit(journal, false);
+}
+EXPORT_SYMBOL(jbd2_fc_end_commit);
+
+/**
+ * int jbd2_fc_end_commit_fallback() - Abandon a fast commit.
+ * @journal: Journal to act on.
+ *
+ * Ends the fast commit and commits the running transaction to the
+ * regular log instead, before any other fast commit can start.  Used when
+ * the changes cannot be described by a fast commit or it failed.
+ */
+int jbd2_fc_end_commit_fallback(journal_t *journal)
+{
+	return __jbd2_fc_end_commit(journal, true);
+}
+EXPORT_SYMBOL(jbd2_fc_end_commit_fallback);
+
+/**
+ * int jbd2_fc_get_buf() - Get the next block of the fast commit area.
+ * @journal: Journal to act on.
+ * @bh_out: Returns the buffer for the block.
+ *
+ * Must be called between jbd2_fc_begin_commit() and the matching end.
+ * The buffer is pinned until jbd2_fc_wait_bufs() or
+ * jbd2_fc_release_bufs() drops it.  Returns -ENOSPC once the area is
+ * full, in which case the caller should fall back to a full commit.
+ */
+int jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out)
+{
+	unsigned long long pblock;
+	unsigned long blocknr;
+	struct buffer_head *bh;
+	int fc_off;
+	int ret;
+
+	*bh_out = NULL;
+
+	if (journal->j_fc_first + journal->j_fc_off >= journal->j_fc_last)
+		return -ENOSPC;
+
+	fc_off = journal->j_fc_off;
+	blocknr = journal->j_fc_first + fc_off;
+
+	ret = jbd2_journal_bmap(journal, blocknr, &pblock);
+	if (ret)
+		return ret;
+
+	bh = __getblk(journal->j_dev, pblock, journal->j_blocksize);
+	if (!bh)
+		return -ENOMEM;
+
+	journal->j_fc_wbuf[fc_off] = bh;
+	journal->j_fc_off++;
+
+	spin_lock(&journal->j_history_lock);
+	journal->j_stats.ts_fc_blocks++;
+	spin_unlock(&journal->j_history_lock);
+
+	*bh_out = bh;
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_get_buf);
+
+/**
+ * int jbd2_fc_wait_bufs() - Wait for fast commit blocks to be written.
+ * @journal: Journal to act on.
+ * @num_blks: Number of most recently allocated blocks to wait for.
+ *
+ * Waits in reverse order so that we are unlikely to be woken before all
+ * of the I/O has completed.
+ */
+int jbd2_fc_wait_bufs(journal_t *journal, int num_blks)
+{
+	struct buffer_head *bh;
+	int i, fc_off = journal->j_fc_off;
+	int err = 0;
+
+	if (num_blks > fc_off)
+		num_blks = fc_off;
+
+	for (i = fc_off - 1; i >= fc_off - num_blks; i--) {
+		bh = journal->j_fc_wbuf[i];
+		if (!bh)
+			continue;
+		wait_on_buffer(bh);
+		if (unlikely(!buffer_uptodate(bh)))
+			err = -EIO;
+		put_bh(bh);
+		journal->j_fc_wbuf[i] = NULL;
+	}
+
+	return err;
+}
+EXPORT_SYMBOL(jbd2_fc_wait_bufs);
+
+/**
+ * int jbd2_fc_release_bufs() - Drop fast commit buffers without waiting.
+ * @journal: Journal to act on.
+ */
+int jbd2_fc_release_bufs(journal_t *journal)
+{
+	struct buffer_head *bh;
+	int i;
+
+	for (i = journal->j_fc_off - 1; i >= 0; i--) {
+		bh = journal->j_fc_wbuf[i];
+		if (!bh)
+			break;
+		put_bh(bh);
+		journal->j_fc_wbuf[i] = NULL;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_release_bufs);
+
 /*
  * We play buffer_head aliasing tricks to write data/metadata blocks to
  * the journal without copying their contents, but for journal
@@ -1020,6 +1254,12 @@ static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 	    s->stats->run.rs_blocks / s->stats->ts_tid);
 	seq_printf(seq, "  %lu logged blocks per transaction\n",
 	    s->stats->run.rs_blocks_logged / s->stats->ts_tid);
+	if (!jbd2_has_feature_fast_commit(s->journal))
+		return 0;
+	seq_printf(seq, "%lu fast commits (%lu fell back to a full commit), "
+		   "%lu fast commit blocks\n",
+		   s->stats->ts_fc_commits, s->stats->ts_fc_fallbacks,
+		   s->stats->ts_fc_blocks);
 	return 0;
 }
 
@@ -1128,6 +1368,7 @@ static journal_t *journal_init_common(struct block_device *bdev,
 	init_waitqueue_head(&journal->j_wait_commit);
 	init_waitqueue_head(&journal->j_wait_updates);
 	init_waitqueue_head(&journal->j_wait_reserved);
+	init_waitqueue_head(&journal->j_fc_wait);
 	mutex_init(&journal->j_barrier);
 	mutex_init(&journal->j_checkpoint_mutex);
 	spin_lock_init(&journal->j_revoke_lock);
@@ -1289,6 +1530,8 @@ static int journal_reset(journal_t *journal)
 
 	first = be32_to_cpu(sb->s_first);
 	last = be32_to_cpu(sb->s_maxlen);
+	if (jbd2_has_feature_fast_commit(journal))
+		last = journal->j_fc_first;
 	if (first + JBD2_MIN_JOURNAL_BLOCKS > last + 1) {
 		printk(KERN_ERR "JBD2: Journal too short (blocks %llu-%llu).\n",
 		       first, last);
@@ -1307,7 +1550,8 @@ static int journal_reset(journal_t *journal)
 	journal->j_commit_sequence = journal->j_transaction_sequence - 1;
 	journal->j_commit_request = journal->j_commit_sequence;
 
-	journal->j_max_transaction_buffers = journal->j_maxlen / 4;
+	journal->j_max_transaction_buffers =
+		(journal->j_maxlen - journal->j_fc_wbufsize) / 4;
 
 	/*
 	 * As a special case, if the on-disk copy is already marked as needing
@@ -1607,6 +1851,90 @@ static int journal_get_superblock(journal_t *journal)
 	return err;
 }
 
+/*
+ * The fast commit area occupies the last blocks of the journal.  The
+ * regular log wraps at j_fc_first, so this has to be set up before the
+ * log is scanned for recovery.
+ */
+static int journal_init_fc_area(journal_t *journal)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+	unsigned long num_fc_blks = jbd2_journal_get_num_fc_blks(sb);
+
+	if (num_fc_blks >= journal->j_maxlen - be32_to_cpu(sb->s_first)) {
+		printk(KERN_ERR "JBD2: journal too short for %lu fast commit "
+		       "blocks\n", num_fc_blks);
+		return -EINVAL;
+	}
+
+	if (!journal->j_fc_wbuf) {
+		journal->j_fc_wbuf = kmalloc_array(num_fc_blks,
+					sizeof(struct buffer_head *),
+					GFP_KERNEL);
+		if (!journal->j_fc_wbuf)
+			return -ENOMEM;
+		journal->j_fc_wbufsize = num_fc_blks;
+	}
+
+	journal->j_fc_last = journal->j_maxlen;
+	journal->j_fc_first = journal->j_fc_last - journal->j_fc_wbufsize;
+	journal->j_fc_off = 0;
+
+	return 0;
+}
+
+/*
+ * Turning fast commits on shrinks the regular log, which is only safe
+ * while nothing lives in it: either before the journal is loaded or
+ * before the first transaction of this mount is committed.
+ */
+static int journal_enable_fast_commit(journal_t *journal)
+{
+	int err;
+
+	err = journal_init_fc_area(journal);
+	if (err || !(journal->j_flags & JBD2_LOADED))
+		return err;
+
+	write_lock(&journal->j_state_lock);
+	if (journal->j_running_transaction ||
+	    journal->j_committing_transaction ||
+	    journal->j_checkpoint_transactions ||
+	    journal->j_head != journal->j_tail ||
+	    journal->j_head >= journal->j_fc_first) {
+		err = -EBUSY;
+	} else {
+		journal->j_last = journal->j_fc_first;
+		journal->j_free = journal->j_last - journal->j_first;
+		journal->j_max_transaction_buffers =
+			(journal->j_maxlen - journal->j_fc_wbufsize) / 4;
+		/*
+		 * Recovery only knows about the area once the feature bit
+		 * is on disk.  Hold fast commits off until the next full
+		 * commit has written the superblock.
+		 */
+		journal->j_flags |= JBD2_FLUSHED;
+	}
+	write_unlock(&journal->j_state_lock);
+
+	return err;
+}
+
+/*
+ * The fast commit area holds data that only the client fs knows how to
+ * replay, so the feature is known only once the client has registered a
+ * replay callback.  Without one, a journal with fast commits is refused
+ * rather than recovered with the area skipped.
+ */
+static u32 jbd2_known_incompat_features(journal_t *journal)
+{
+	u32 known = JBD2_KNOWN_INCOMPAT_FEATURES;
+
+	if (journal->j_fc_replay_callback)
+		known |= JBD2_FEATURE_INCOMPAT_FAST_COMMIT;
+	return known;
+}
+
 /*
  * Load the on-disk journal superblock and read the key fields into the
  * journal_t.
@@ -1629,6 +1957,13 @@ static int load_superblock(journal_t *journal)
 	journal->j_last = be32_to_cpu(sb->s_maxlen);
 	journal->j_errno = be32_to_cpu(sb->s_errno);
 
+	if (jbd2_has_feature_fast_commit(journal)) {
+		err = journal_init_fc_area(journal);
+		if (err)
+			return err;
+		journal->j_last = journal->j_fc_first;
+	}
+
 	return 0;
 }
 
@@ -1658,7 +1993,7 @@ int jbd2_journal_load(journal_t *journal)
 		if ((sb->s_feature_ro_compat &
 		     ~cpu_to_be32(JBD2_KNOWN_ROCOMPAT_FEATURES)) ||
 		    (sb->s_feature_incompat &
-		     ~cpu_to_be32(JBD2_KNOWN_INCOMPAT_FEATURES))) {
+		     ~cpu_to_be32(jbd2_known_incompat_features(journal)))) {
 			printk(KERN_WARNING
 				"JBD2: Unrecognised features on journal\n");
 			return -EINVAL;
@@ -1768,6 +2103,7 @@ int jbd2_journal_destroy(journal_t *journal)
 		jbd2_journal_destroy_revoke(journal);
 	if (journal->j_chksum_driver)
 		crypto_free_shash(journal->j_chksum_driver);
+	kfree(journal->j_fc_wbuf);
 	kfree(journal->j_wbuf);
 	kfree(journal);
 
@@ -1836,7 +2172,7 @@ int jbd2_journal_check_available_features (journal_t *journal, unsigned long com
 
 	if ((compat   & JBD2_KNOWN_COMPAT_FEATURES) == compat &&
 	    (ro       & JBD2_KNOWN_ROCOMPAT_FEATURES) == ro &&
-	    (incompat & JBD2_KNOWN_INCOMPAT_FEATURES) == incompat)
+	    (incompat & jbd2_known_incompat_features(journal)) == incompat)
 		return 1;
 
 	return 0;
@@ -1899,6 +2235,12 @@ int jbd2_journal_set_features (journal_t *journal, unsigned long compat,
 						   sizeof(sb->s_uuid));
 	}
 
+	if (INCOMPAT_FEATURE_ON(JBD2_FEATURE_INCOMPAT_FAST_COMMIT) &&
+	    journal_enable_fast_commit(journal)) {
+		printk(KERN_ERR "JBD2: Cannot enable fast commits.\n");
+		return 0;
+	}
+
 	lock_buffer(journal->j_sb_buffer);
 
 	/* If enabling v3 checksums, update superblock */
@@ -35,7 +35,6 @@ struct recovery_info
 	int		nr_revoke_hits;
 };
 
-enum passtype {PASS_SCAN, PASS_REVOKE, PASS_REPLAY};
 static int do_one_pass(journal_t *journal,
 				struct recovery_info *info, enum passtype pass);
 static int scan_revoke_records(journal_t *, struct buffer_head *,
@@ -413,6 +412,54 @@ static int jbd2_block_tag_csum_verify(journal_t *j, journal_block_tag_t *tag,
 		return tag->t_checksum == cpu_to_be16(csum32);
 }
 
+/*
+ * Hand the fast commit area to the client fs, one block at a time.  The
+ * fs decides which blocks belong to the transaction following the last
+ * one found in the log and stops the walk at the first one that does not.
+ */
+static int fc_do_one_pass(journal_t *journal,
+			  struct recovery_info *info, enum passtype pass)
+{
+	unsigned int expected_commit_id = info->end_transaction;
+	unsigned long next_fc_block;
+	struct buffer_head *bh;
+	int err = 0;
+
+	/*
+	 * Skipping recovery only scans, and is fine without the client;
+	 * actually replaying without it would silently drop the area.
+	 */
+	if (!journal->j_fc_replay_callback) {
+		if (pass == PASS_SCAN)
+			return 0;
+		printk(KERN_ERR "JBD2: journal has fast commits but no "
+		       "way to replay them\n");
+		return -EOPNOTSUPP;
+	}
+
+	for (next_fc_block = journal->j_fc_first;
+	     next_fc_block < journal->j_fc_last; next_fc_block++) {
+		jbd_debug(3, "Fast commit replay: next block %lu\n",
+			  next_fc_block);
+		err = jread(&bh, journal, next_fc_block);
+		if (err)
+			break;
+
+		err = journal->j_fc_replay_callback(journal, bh, pass,
+					next_fc_block - journal->j_fc_first,
+					expected_commit_id);
+		brelse(bh);
+		if (err < 0 || err == JBD2_FC_REPLAY_STOP)
+			break;
+		err = 0;
+	}
+
+	if (err)
+		jbd_debug(3, "Fast commit replay failed, err = %d\n", err);
+
+	return err;
+}
+
 static int do_one_pass(journal_t *journal,
 			struct recovery_info *info, enum passtype pass)
 {
@@ -799,6 +846,13 @@ static int do_one_pass(journal_t *journal,
 				success = -EIO;
 		}
 	}
+
+	if (jbd2_has_feature_fast_commit(journal) && pass != PASS_REVOKE) {
+		err = fc_do_one_pass(journal, info, pass);
+		if (err && !success)
+			success = err;
+	}
+
 	if (block_error && success == 0)
 		success = -EIO;
 	return success;
@@ -689,6 +689,7 @@ static int nfs_init_server(struct nfs_server *server,
 		server->rsize = nfs_block_size(data->rsize, NULL);
 	if (data->wsize)
 		server->wsize = nfs_block_size(data->wsize, NULL);
+	server->rasize = data->rasize;
 
 	server->acregmin = data->acregmin * HZ;
 	server->acregmax = data->acregmax * HZ;
@@ -828,6 +829,7 @@ void nfs_server_copy_userdata(struct nfs_server *target, struct nfs_server *sour
 	target->flags = source->flags;
 	target->rsize = source->rsize;
 	target->wsize = source->wsize;
+	target->rasize = source->rasize;
 	target->acregmin = source->acregmin;
 	target->acregmax = source->acregmax;
 	target->acdirmin = source->acdirmin;
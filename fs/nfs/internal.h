@@ -24,6 +24,23 @@ struct nfs_string;
  */
 #define NFS_MAX_READAHEAD	(RPC_DEF_SLOT_TABLE - 1)
 
+/* Upper bound for the "rasize=" mount option */
+#define NFS_MAX_RASIZE		(1U << 30)
+
+/*
+ * Readahead window of a mount, which bounds the number of bytes each open
+ * file keeps in flight.  "rasize=" overrides the default of
+ * NFS_MAX_READAHEAD READs of rsize each, e.g. to keep a high latency link
+ * busy; it is never smaller than one READ.
+ */
+static inline unsigned long nfs_readahead_pages(struct nfs_server *server)
+{
+	if (server->rasize)
+		return max_t(unsigned long, server->rpages,
+			     DIV_ROUND_UP(server->rasize, PAGE_SIZE));
+	return server->rpages * NFS_MAX_READAHEAD;
+}
+
 static inline void nfs_attr_check_mountpoint(struct super_block *parent, struct nfs_fattr *fattr)
 {
 	if (!nfs_fsid_equal(&NFS_SB(parent)->fsid, &fattr->fsid))
@@ -93,6 +110,7 @@ struct nfs_client_initdata {
 struct nfs_parsed_mount_data {
 	int			flags;
 	unsigned int		rsize, wsize;
+	unsigned int		rasize;
 	unsigned int		timeo, retrans;
 	unsigned int		acregmin, acregmax,
 				acdirmin, acdirmax;
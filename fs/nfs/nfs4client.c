@@ -1092,6 +1092,7 @@ static int nfs4_init_server(struct nfs_server *server,
 		server->rsize = nfs_block_size(data->rsize, NULL);
 	if (data->wsize)
 		server->wsize = nfs_block_size(data->wsize, NULL);
+	server->rasize = data->rasize;
 
 	server->acregmin = data->acregmin * HZ;
 	server->acregmax = data->acregmax * HZ;
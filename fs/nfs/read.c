@@ -91,6 +91,23 @@ void nfs_pageio_reset_read_mds(struct nfs_pageio_descriptor *pgio)
 }
 EXPORT_SYMBOL_GPL(nfs_pageio_reset_read_mds);
 
+/*
+ * Count the readahead pages with a READ outstanding, for the readahead line
+ * in /proc/self/mountstats.  Only ->readpages() pages are accounted, when
+ * their request is created, and released when the page is unlocked, once
+ * per page group.
+ */
+static void nfs_read_inflight_inc(struct inode *inode, struct nfs_page *req)
+{
+	struct nfs_server *server = NFS_SERVER(inode);
+	long inflight = atomic_long_inc_return(&server->read_inflight);
+
+	set_bit(PG_READAHEAD, &req->wb_flags);
+
+	if (inflight > atomic_long_read(&server->read_inflight_max))
+		atomic_long_set(&server->read_inflight_max, inflight);
+}
+
 static void nfs_readpage_release(struct nfs_page *req)
 {
 	struct inode *inode = d_inode(nfs_req_openctx(req)->dentry);
@@ -104,6 +121,8 @@ static void nfs_readpage_release(struct nfs_page *req)
 			nfs_readpage_to_fscache(inode, req->wb_page, 0);
 
 		unlock_page(req->wb_page);
+		if (test_bit(PG_READAHEAD, &req->wb_head->wb_flags))
+			atomic_long_dec(&NFS_SERVER(inode)->read_inflight);
 	}
 	nfs_release_request(req);
 }
@@ -367,6 +386,7 @@ readpage_async_filler(void *data, struct page *page)
 	new = nfs_create_request(desc->ctx, page, 0, len);
 	if (IS_ERR(new))
 		goto out_error;
+	nfs_read_inflight_inc(page_file_mapping(page)->host, new);
 
 	if (len < PAGE_SIZE)
 		zero_user_segment(page, len, PAGE_SIZE);
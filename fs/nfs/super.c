@@ -96,7 +96,7 @@ enum {
 
 	/* Mount options that take integer arguments */
 	Opt_port,
-	Opt_rsize, Opt_wsize, Opt_bsize,
+	Opt_rsize, Opt_wsize, Opt_bsize, Opt_rasize,
 	Opt_timeo, Opt_retrans,
 	Opt_acregmin, Opt_acregmax,
 	Opt_acdirmin, Opt_acdirmax,
@@ -160,6 +160,7 @@ static const match_table_t nfs_mount_option_tokens = {
 	{ Opt_port, "port=%s" },
 	{ Opt_rsize, "rsize=%s" },
 	{ Opt_wsize, "wsize=%s" },
+	{ Opt_rasize, "rasize=%s" },
 	{ Opt_bsize, "bsize=%s" },
 	{ Opt_timeo, "timeo=%s" },
 	{ Opt_retrans, "retrans=%s" },
@@ -653,6 +654,8 @@ static void nfs_show_mount_options(struct seq_file *m, struct nfs_server *nfss,
 	nfs_show_nfs_version(m, version, clp->cl_minorversion);
 	seq_printf(m, ",rsize=%u", nfss->rsize);
 	seq_printf(m, ",wsize=%u", nfss->wsize);
+	if (nfss->rasize != 0)
+		seq_printf(m, ",rasize=%u", nfss->rasize);
 	if (nfss->bsize != 0)
 		seq_printf(m, ",bsize=%u", nfss->bsize);
 	seq_printf(m, ",namlen=%u", nfss->namelen);
@@ -903,6 +906,10 @@ int nfs_show_stats(struct seq_file *m, struct dentry *root)
 			seq_printf(m, "%Lu ", totals.fscache[i]);
 	}
 #endif
+	seq_printf(m, "\n\treadahead:\t%lu %lu %lu",
+		   root->d_sb->s_bdi->ra_pages << PAGE_SHIFT,
+		   atomic_long_read(&nfss->read_inflight) << PAGE_SHIFT,
+		   atomic_long_read(&nfss->read_inflight_max) << PAGE_SHIFT);
 	seq_putc(m, '\n');
 
 	rpc_clnt_show_stats(m, nfss->client);
@@ -1370,6 +1377,12 @@ static int nfs_parse_mount_options(char *raw,
 				goto out_invalid_value;
 			mnt->wsize = option;
 			break;
+		case Opt_rasize:
+			if (nfs_get_option_ul(args, &option) ||
+			    option > NFS_MAX_RASIZE)
+				goto out_invalid_value;
+			mnt->rasize = option;
+			break;
 		case Opt_bsize:
 			if (nfs_get_option_ul(args, &option))
 				goto out_invalid_value;
@@ -2251,6 +2264,7 @@ nfs_compare_remount_data(struct nfs_server *nfss,
 	if ((data->flags ^ nfss->flags) & NFS_REMOUNT_CMP_FLAGMASK ||
 	    data->rsize != nfss->rsize ||
 	    data->wsize != nfss->wsize ||
+	    data->rasize != nfss->rasize ||
 	    data->version != nfss->nfs_client->rpc_ops->version ||
 	    data->minorversion != nfss->nfs_client->cl_minorversion ||
 	    data->retrans != nfss->client->cl_timeout->to_retries ||
@@ -2301,6 +2315,7 @@ nfs_remount(struct super_block *sb, int *flags, char *raw_data)
 	data->flags = nfss->flags;
 	data->rsize = nfss->rsize;
 	data->wsize = nfss->wsize;
+	data->rasize = nfss->rasize;
 	data->retrans = nfss->client->cl_timeout->to_retries;
 	data->selected_flavor = nfss->client->cl_auth->au_flavor;
 	data->acregmin = nfss->acregmin / HZ;
@@ -2431,6 +2446,8 @@ static int nfs_compare_mount_options(const struct super_block *s, const struct n
 		goto Ebusy;
 	if (a->rsize != b->rsize)
 		goto Ebusy;
+	if (a->rasize != b->rasize)
+		goto Ebusy;
 	if (a->acregmin != b->acregmin)
 		goto Ebusy;
 	if (a->acregmax != b->acregmax)
@@ -2669,7 +2686,7 @@ struct dentry *nfs_fs_mount_common(struct nfs_server *server,
 			mntroot = ERR_PTR(error);
 			goto error_splat_super;
 		}
-		s->s_bdi->ra_pages = server->rpages * NFS_MAX_READAHEAD;
+		s->s_bdi->ra_pages = nfs_readahead_pages(server);
 		server->super = s;
 	}
 
@@ -21,9 +21,14 @@
 #include <linux/pstore_ram.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
+#include <linux/irq_work.h>
+#include <linux/workqueue.h>
 
 #define RAMOOPS_KERNMSG_HDR "===="
 #define MIN_MEM_SIZE 4096UL
+#define RAMOOPS_CONSOLE_BUF_SIZE PAGE_SIZE
+/* longest console line kept for deduplication */
+#define RAMOOPS_CONSOLE_LINE_MAX 256
 
 static ulong record_size = MIN_MEM_SIZE;
 module_param(record_size, ulong, 0400);
@@ -34,6 +39,24 @@ static ulong ramoops_console_size = MIN_MEM_SIZE;
 module_param_named(console_size, ramoops_console_size, ulong, 0400);
 MODULE_PARM_DESC(console_size, "size of kernel console log");
 
+static unsigned int ramoops_console_flush_ms;
+module_param_named(console_flush_ms, ramoops_console_flush_ms, uint, 0400);
+MODULE_PARM_DESC(console_flush_ms,
+		"if non-zero, batch console output and flush it to the console "
+		"log this many milliseconds later (default 0, write "
+		"synchronously)");
+
+static unsigned int ramoops_console_ratelimit;
+module_param_named(console_ratelimit, ramoops_console_ratelimit, uint, 0600);
+MODULE_PARM_DESC(console_ratelimit,
+		"maximum console bytes logged per second, the excess is "
+		"dropped (default 0, unlimited)");
+
+static bool ramoops_console_dedup;
+module_param_named(console_dedup, ramoops_console_dedup, bool, 0600);
+MODULE_PARM_DESC(console_dedup,
+		"collapse repeated console lines into a count (default 0)");
+
 static ulong ramoops_ftrace_size = MIN_MEM_SIZE;
 module_param_named(ftrace_size, ramoops_ftrace_size, ulong, 0400);
 MODULE_PARM_DESC(ftrace_size, "size of ftrace log");
@@ -92,6 +115,20 @@ struct ramoops_context {
 	unsigned int max_ftrace_cnt;
 	unsigned int ftrace_read_cnt;
 	unsigned int pmsg_read_cnt;
+	/* Console batching, rate limiting and deduplication */
+	raw_spinlock_t console_lock;
+	char *console_buf;
+	size_t console_len;
+	unsigned long console_delay;
+	struct irq_work console_irq_work;
+	struct delayed_work console_work;
+	unsigned long console_rl_begin;
+	size_t console_rl_bytes;
+	unsigned long console_suppressed;
+	char console_last[RAMOOPS_CONSOLE_LINE_MAX];
+	size_t console_last_len;
+	bool console_last_valid;
+	unsigned int console_repeats;
 	struct pstore_info pstore;
 };
 
@@ -344,6 +381,226 @@ static size_t ramoops_write_kmsg_hdr(struct persistent_ram_zone *prz,
 	return len;
 }
 
+/* Called with console_lock held. */
+static void notrace ramoops_console_flush_locked(struct ramoops_context *cxt)
+{
+	if (!cxt->console_len)
+		return;
+
+	persistent_ram_write(cxt->cprz, cxt->console_buf, cxt->console_len);
+	cxt->console_len = 0;
+}
+
+static void ramoops_console_flush(struct ramoops_context *cxt)
+{
+	unsigned long flags;
+
+	if (!cxt->console_buf)
+		return;
+
+	raw_spin_lock_irqsave(&cxt->console_lock, flags);
+	ramoops_console_flush_locked(cxt);
+	raw_spin_unlock_irqrestore(&cxt->console_lock, flags);
+}
+
+static void ramoops_console_workfn(struct work_struct *work)
+{
+	struct ramoops_context *cxt =
+		container_of(to_delayed_work(work), struct ramoops_context,
+			     console_work);
+
+	ramoops_console_flush(cxt);
+}
+
+/*
+ * Console output may come from any context, including with the workqueue
+ * locks held, so the flush is kicked off through an irq_work.
+ */
+static void ramoops_console_irq_workfn(struct irq_work *work)
+{
+	struct ramoops_context *cxt =
+		container_of(work, struct ramoops_context, console_irq_work);
+
+	schedule_delayed_work(&cxt->console_work, cxt->console_delay);
+}
+
+/*
+ * Append to the staging buffer, or write straight into the console zone
+ * when batching is disabled.  Called with console_lock held.
+ */
+static void notrace ramoops_console_store(struct ramoops_context *cxt,
+					  const char *s, size_t c)
+{
+	if (!cxt->console_buf) {
+		persistent_ram_write(cxt->cprz, s, c);
+		return;
+	}
+
+	if (cxt->console_len + c > RAMOOPS_CONSOLE_BUF_SIZE) {
+		ramoops_console_flush_locked(cxt);
+		if (c > RAMOOPS_CONSOLE_BUF_SIZE) {
+			persistent_ram_write(cxt->cprz, s, c);
+			return;
+		}
+	}
+
+	if (!cxt->console_len)
+		irq_work_queue(&cxt->console_irq_work);
+	memcpy(cxt->console_buf + cxt->console_len, s, c);
+	cxt->console_len += c;
+}
+
+static __printf(2, 3)
+void ramoops_console_note(struct ramoops_context *cxt, const char *fmt, ...)
+{
+	char buf[64];
+	va_list args;
+	size_t len;
+
+	va_start(args, fmt);
+	len = vscnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	ramoops_console_store(cxt, buf, len);
+}
+
+/*
+ * Note how often the last line was repeated, if it was.  Called with
+ * console_lock held.
+ */
+static void ramoops_console_end_repeats(struct ramoops_context *cxt)
+{
+	if (!cxt->console_repeats)
+		return;
+
+	ramoops_console_note(cxt, "(last line repeated %u times)\n",
+			     cxt->console_repeats);
+	cxt->console_repeats = 0;
+	/* have the next copy of the line show up in full again */
+	cxt->console_last_valid = false;
+}
+
+/*
+ * Return true if this console line only repeats the previous one.  The
+ * printk timestamp is skipped, as it differs even between identical
+ * messages.  Lines longer than RAMOOPS_CONSOLE_LINE_MAX are never taken as
+ * repeats.  Called with console_lock held.
+ */
+static bool ramoops_console_repeated(struct ramoops_context *cxt,
+				     const char *s, size_t c)
+{
+	const char *end;
+
+	if (c && s[0] == '[') {
+		end = memchr(s, ']', c);
+		if (end) {
+			c -= end + 1 - s;
+			s = end + 1;
+		}
+	}
+
+	if (cxt->console_last_valid && c == cxt->console_last_len &&
+	    !memcmp(s, cxt->console_last, c)) {
+		cxt->console_repeats++;
+		return true;
+	}
+
+	ramoops_console_end_repeats(cxt);
+	cxt->console_last_valid = c <= sizeof(cxt->console_last);
+	if (cxt->console_last_valid) {
+		memcpy(cxt->console_last, s, c);
+		cxt->console_last_len = c;
+	}
+
+	return false;
+}
+
+/*
+ * Write back everything pending, including the count of repeats of the
+ * last line, ahead of a dump or on removal.  During a crash, don't wait
+ * for a CPU that may have died holding the lock.
+ */
+static void ramoops_console_sync(struct ramoops_context *cxt)
+{
+	unsigned long flags;
+
+	if (unlikely(oops_in_progress)) {
+		if (!raw_spin_trylock_irqsave(&cxt->console_lock, flags))
+			return;
+	} else {
+		raw_spin_lock_irqsave(&cxt->console_lock, flags);
+	}
+	ramoops_console_end_repeats(cxt);
+	ramoops_console_flush_locked(cxt);
+	raw_spin_unlock_irqrestore(&cxt->console_lock, flags);
+}
+
+/*
+ * Return true if logging this many bytes would exceed the per-second
+ * budget.  The number of dropped bytes is noted once a new second starts.
+ * Called with console_lock held.
+ */
+static bool ramoops_console_ratelimited(struct ramoops_context *cxt,
+					size_t c)
+{
+	unsigned int limit = READ_ONCE(ramoops_console_ratelimit);
+
+	if (!limit)
+		return false;
+
+	if (time_after(jiffies, cxt->console_rl_begin + HZ)) {
+		if (cxt->console_suppressed) {
+			ramoops_console_note(cxt,
+				"(%lu console bytes suppressed)\n",
+				cxt->console_suppressed);
+			cxt->console_suppressed = 0;
+		}
+		cxt->console_rl_begin = jiffies;
+		cxt->console_rl_bytes = 0;
+	}
+
+	if (cxt->console_rl_bytes + c > limit) {
+		cxt->console_suppressed += c;
+		return true;
+	}
+	cxt->console_rl_bytes += c;
+
+	return false;
+}
+
+static void notrace ramoops_console_write(struct ramoops_context *cxt,
+					  const char *s, size_t c)
+{
+	unsigned long flags;
+
+	/*
+	 * Crash output is never dropped or delayed.  Don't wait for a CPU
+	 * that may have died holding the lock; the staged output is lost
+	 * then, but the crash itself still makes it.
+	 */
+	if (unlikely(oops_in_progress)) {
+		if (!raw_spin_trylock_irqsave(&cxt->console_lock, flags)) {
+			persistent_ram_write(cxt->cprz, s, c);
+			return;
+		}
+		ramoops_console_end_repeats(cxt);
+		ramoops_console_flush_locked(cxt);
+		persistent_ram_write(cxt->cprz, s, c);
+		raw_spin_unlock_irqrestore(&cxt->console_lock, flags);
+		return;
+	}
+
+	raw_spin_lock_irqsave(&cxt->console_lock, flags);
+	if (READ_ONCE(ramoops_console_dedup) &&
+	    ramoops_console_repeated(cxt, s, c))
+		goto out;
+	if (ramoops_console_ratelimited(cxt, c))
+		goto out;
+	ramoops_console_store(cxt, s, c);
+out:
+	raw_spin_unlock_irqrestore(&cxt->console_lock, flags);
+}
+
 static int notrace ramoops_pstore_write(struct pstore_record *record)
 {
 	struct ramoops_context *cxt = record->psi->data;
@@ -353,7 +610,7 @@ static int notrace ramoops_pstore_write(struct pstore_record *record)
 	if (record->type == PSTORE_TYPE_CONSOLE) {
 		if (!cxt->cprz)
 			return -ENOMEM;
-		persistent_ram_write(cxt->cprz, record->buf, record->size);
+		ramoops_console_write(cxt, record->buf, record->size);
 		return 0;
 	} else if (record->type == PSTORE_TYPE_FTRACE) {
 		int zonenum;
@@ -379,6 +636,13 @@ static int notrace ramoops_pstore_write(struct pstore_record *record)
 	if (record->type != PSTORE_TYPE_DMESG)
 		return -EINVAL;
 
+	/*
+	 * Write back batched output on any dump.  Dumps come with oopses and
+	 * panics, and on shutdown only with printk.always_kmsg_dump set.
+	 */
+	if (cxt->cprz)
+		ramoops_console_sync(cxt);
+
 	/*
 	 * Out of the various dmesg dump types, ramoops is currently designed
 	 * to only store crash logs, rather than storing general kernel logs.
@@ -837,10 +1101,25 @@ static int ramoops_probe(struct platform_device *pdev)
 		}
 	}
 
+	raw_spin_lock_init(&cxt->console_lock);
+	init_irq_work(&cxt->console_irq_work, ramoops_console_irq_workfn);
+	INIT_DELAYED_WORK(&cxt->console_work, ramoops_console_workfn);
+	if ((cxt->pstore.flags & PSTORE_FLAGS_CONSOLE) &&
+	    ramoops_console_flush_ms) {
+		cxt->console_delay = msecs_to_jiffies(ramoops_console_flush_ms);
+		cxt->console_buf = kmalloc(RAMOOPS_CONSOLE_BUF_SIZE,
+					   GFP_KERNEL);
+		if (!cxt->console_buf) {
+			pr_err("cannot allocate console staging buffer\n");
+			err = -ENOMEM;
+			goto fail_buf;
+		}
+	}
+
 	err = pstore_register(&cxt->pstore);
 	if (err) {
 		pr_err("registering with pstore failed\n");
-		goto fail_buf;
+		goto fail_console_buf;
 	}
 
 	/*
@@ -861,6 +1140,9 @@ static int ramoops_probe(struct platform_device *pdev)
 
 	return 0;
 
+fail_console_buf:
+	kfree(cxt->console_buf);
+	cxt->console_buf = NULL;
 fail_buf:
 	kfree(cxt->pstore.buf);
 fail_clear:
@@ -881,6 +1163,13 @@ static int ramoops_remove(struct platform_device *pdev)
 
 	pstore_unregister(&cxt->pstore);
 
+	irq_work_sync(&cxt->console_irq_work);
+	cancel_delayed_work_sync(&cxt->console_work);
+	if (cxt->cprz)
+		ramoops_console_sync(cxt);
+	kfree(cxt->console_buf);
+	cxt->console_buf = NULL;
+
 	kfree(cxt->pstore.buf);
 	cxt->pstore.bufsize = 0;
 
@@ -10,7 +10,8 @@
 
 /*
  * Blocks in Squashfs are compressed.  To avoid repeatedly decompressing
- * recently accessed data Squashfs uses two small metadata and fragment caches.
+ * recently accessed data Squashfs uses small metadata, fragment and data
+ * caches.  Their sizes can be set at mount time, see super.c.
  *
  * This file implements a generic cache implementation used for both caches,
  * plus functions layered ontop of the generic cache implementation to
@@ -80,19 +81,23 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 				continue;
 			}
 
+			cache->misses++;
+
 			/*
-			 * At least one unused cache entry.  A simple
-			 * round-robin strategy is used to choose the entry to
-			 * be evicted from the cache.
+			 * At least one unused cache entry.  Evict the least
+			 * recently used one, so that a block shared by many
+			 * small files (a fragment) survives a scan of other
+			 * blocks as long as it keeps being hit.
 			 */
-			i = cache->next_blk;
+			i = -1;
 			for (n = 0; n < cache->entries; n++) {
-				if (cache->entry[i].refcount == 0)
-					break;
-				i = (i + 1) % cache->entries;
+				if (cache->entry[n].refcount)
+					continue;
+				if (i < 0 || cache->entry[n].last_use <
+						cache->entry[i].last_use)
+					i = n;
 			}
 
-			cache->next_blk = (i + 1) % cache->entries;
 			entry = &cache->entry[i];
 
 			/*
@@ -101,6 +106,7 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 			 */
 			cache->unused--;
 			entry->block = block;
+			entry->last_use = ++cache->clock;
 			entry->refcount = 1;
 			entry->pending = 1;
 			entry->num_waiters = 0;
@@ -112,8 +118,11 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 
 			spin_lock(&cache->lock);
 
-			if (entry->length < 0)
+			/* Make a failed entry the first to be evicted */
+			if (entry->length < 0) {
 				entry->error = entry->length;
+				entry->last_use = 0;
+			}
 
 			entry->pending = 0;
 
@@ -141,6 +150,9 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 		if (entry->refcount == 0)
 			cache->unused--;
 		entry->refcount++;
+		cache->hits++;
+		if (!entry->error)
+			entry->last_use = ++cache->clock;
 
 		/*
 		 * If the entry is currently being filled in by another process
@@ -238,7 +250,9 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 	}
 
 	cache->curr_blk = 0;
-	cache->next_blk = 0;
+	cache->clock = 0;
+	cache->hits = 0;
+	cache->misses = 0;
 	cache->unused = entries;
 	cache->entries = entries;
 	cache->block_size = block_size;
@@ -10,17 +10,22 @@
  * squashfs_fs_sb.h
  */
 
+#include <linux/completion.h>
+#include <linux/kobject.h>
+
 #include "squashfs_fs.h"
 
 struct squashfs_cache {
 	char			*name;
 	int			entries;
 	int			curr_blk;
-	int			next_blk;
 	int			num_waiters;
 	int			unused;
 	int			block_size;
 	int			pages;
+	unsigned long		clock;
+	unsigned long		hits;
+	unsigned long		misses;
 	spinlock_t		lock;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache_entry *entry;
@@ -34,6 +39,7 @@ struct squashfs_cache_entry {
 	int			pending;
 	int			error;
 	int			num_waiters;
+	unsigned long		last_use;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache	*cache;
 	void			**data;
@@ -64,5 +70,10 @@ struct squashfs_sb_info {
 	unsigned int				inodes;
 	unsigned int				fragments;
 	int					xattr_ids;
+	int					metadata_cache_entries;
+	int					fragment_cache_entries;
+	int					data_cache_entries;
+	struct kobject				kobj;
+	struct completion			kobj_unregister;
 };
 #endif
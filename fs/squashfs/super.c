@@ -25,6 +25,8 @@
 #include <linux/module.h>
 #include <linux/magic.h>
 #include <linux/xattr.h>
+#include <linux/parser.h>
+#include <linux/seq_file.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -35,6 +37,197 @@
 
 static struct file_system_type squashfs_fs_type;
 static const struct super_operations squashfs_super_ops;
+static struct kset *squashfs_kset;
+
+/*
+ * Upper bound for the number of entries in each cache.  Fragment and data
+ * cache entries are a filesystem block (up to 1 Mbyte) each.
+ */
+#define SQUASHFS_MAX_CACHE_ENTRIES	64
+
+enum {
+	Opt_metadata_cache, Opt_fragment_cache, Opt_data_cache, Opt_err
+};
+
+static const match_table_t squashfs_tokens = {
+	{Opt_metadata_cache, "metadata_cache=%s"},
+	{Opt_fragment_cache, "fragment_cache=%s"},
+	{Opt_data_cache, "data_cache=%s"},
+	{Opt_err, NULL}
+};
+
+/*
+ * The metadata cache must hold at least SQUASHFS_CACHED_BLKS blocks, as
+ * the file index code reads up to that many blocks in one go (see
+ * calculate_skip() in file.c).  The data cache needs one entry per
+ * decompressor so readers never wait on each other for a free entry.
+ *
+ * Squashfs used to ignore its mount options altogether, so unknown ones
+ * are still ignored; only bad values of the cache options are rejected.
+ */
+static int squashfs_parse_options(struct squashfs_sb_info *msblk,
+	char *options)
+{
+	substring_t args[MAX_OPT_ARGS];
+	int token, option;
+	char *p;
+
+	msblk->metadata_cache_entries = SQUASHFS_CACHED_BLKS;
+	msblk->fragment_cache_entries = SQUASHFS_CACHED_FRAGMENTS;
+	msblk->data_cache_entries = squashfs_max_decompressors();
+
+	if (options == NULL)
+		return 0;
+
+	while ((p = strsep(&options, ",")) != NULL) {
+		if (!*p)
+			continue;
+
+		token = match_token(p, squashfs_tokens, args);
+		if (token == Opt_err)
+			continue;
+
+		if (match_int(&args[0], &option) || option < 1 ||
+				option > SQUASHFS_MAX_CACHE_ENTRIES) {
+			ERROR("Invalid value for mount option \"%s\"\n", p);
+			return -EINVAL;
+		}
+
+		switch (token) {
+		case Opt_metadata_cache:
+			msblk->metadata_cache_entries = max_t(int, option,
+				SQUASHFS_CACHED_BLKS);
+			break;
+		case Opt_fragment_cache:
+			msblk->fragment_cache_entries = option;
+			break;
+		case Opt_data_cache:
+			msblk->data_cache_entries = max(option,
+				squashfs_max_decompressors());
+			break;
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+ * Per filesystem cache statistics in /sys/fs/squashfs/<dev>/.
+ */
+enum {
+	attr_entries, attr_hits, attr_misses
+};
+
+struct squashfs_attr {
+	struct attribute attr;
+	size_t cache_offset;
+	int stat;
+};
+
+#define SQUASHFS_CACHE_ATTR(_name, _field, _stat)			\
+static struct squashfs_attr squashfs_attr_##_name##_##_stat = {		\
+	.attr = { .name = __stringify(_name##_##_stat), .mode = 0444 },	\
+	.cache_offset = offsetof(struct squashfs_sb_info, _field),	\
+	.stat = attr_##_stat,						\
+}
+
+#define SQUASHFS_CACHE_ATTRS(_name, _field)				\
+	SQUASHFS_CACHE_ATTR(_name, _field, entries);			\
+	SQUASHFS_CACHE_ATTR(_name, _field, hits);			\
+	SQUASHFS_CACHE_ATTR(_name, _field, misses)
+
+#define ATTR_LIST(_name)						\
+	&squashfs_attr_##_name##_entries.attr,				\
+	&squashfs_attr_##_name##_hits.attr,				\
+	&squashfs_attr_##_name##_misses.attr
+
+SQUASHFS_CACHE_ATTRS(metadata_cache, block_cache);
+SQUASHFS_CACHE_ATTRS(fragment_cache, fragment_cache);
+SQUASHFS_CACHE_ATTRS(data_cache, read_page);
+
+static struct attribute *squashfs_attrs[] = {
+	ATTR_LIST(metadata_cache),
+	ATTR_LIST(fragment_cache),
+	ATTR_LIST(data_cache),
+	NULL,
+};
+ATTRIBUTE_GROUPS(squashfs);
+
+static ssize_t squashfs_attr_show(struct kobject *kobj,
+	struct attribute *attr, char *buf)
+{
+	struct squashfs_sb_info *msblk = container_of(kobj,
+		struct squashfs_sb_info, kobj);
+	struct squashfs_attr *a = container_of(attr, struct squashfs_attr,
+		attr);
+	struct squashfs_cache *cache = *(struct squashfs_cache **)
+		((char *)msblk + a->cache_offset);
+	unsigned long val = 0;
+
+	/* There is no fragment cache if the filesystem has no fragments */
+	if (cache == NULL)
+		return sprintf(buf, "0\n");
+
+	spin_lock(&cache->lock);
+	switch (a->stat) {
+	case attr_entries:
+		val = cache->entries;
+		break;
+	case attr_hits:
+		val = cache->hits;
+		break;
+	case attr_misses:
+		val = cache->misses;
+		break;
+	}
+	spin_unlock(&cache->lock);
+
+	return sprintf(buf, "%lu\n", val);
+}
+
+static const struct sysfs_ops squashfs_attr_ops = {
+	.show	= squashfs_attr_show,
+};
+
+static void squashfs_sb_release(struct kobject *kobj)
+{
+	struct squashfs_sb_info *msblk = container_of(kobj,
+		struct squashfs_sb_info, kobj);
+
+	complete(&msblk->kobj_unregister);
+}
+
+static struct kobj_type squashfs_sb_ktype = {
+	.default_groups	= squashfs_groups,
+	.sysfs_ops	= &squashfs_attr_ops,
+	.release	= squashfs_sb_release,
+};
+
+static int squashfs_sysfs_register(struct super_block *sb)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	int err;
+
+	msblk->kobj.kset = squashfs_kset;
+	init_completion(&msblk->kobj_unregister);
+	err = kobject_init_and_add(&msblk->kobj, &squashfs_sb_ktype, NULL,
+		"%s", sb->s_id);
+	if (err) {
+		kobject_put(&msblk->kobj);
+		wait_for_completion(&msblk->kobj_unregister);
+	}
+
+	return err;
+}
+
+static void squashfs_sysfs_unregister(struct squashfs_sb_info *msblk)
+{
+	kobject_del(&msblk->kobj);
+	kobject_put(&msblk->kobj);
+	wait_for_completion(&msblk->kobj_unregister);
+}
+
 
 static const struct squashfs_decompressor *supported_squashfs_filesystem(short
 	major, short minor, short id)
@@ -88,6 +281,10 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 
 	mutex_init(&msblk->meta_index_mutex);
 
+	err = squashfs_parse_options(msblk, data);
+	if (err)
+		goto failed_mount;
+
 	/*
 	 * msblk->bytes_used is checked in squashfs_read_table to ensure reads
 	 * are not beyond filesystem end.  But as we're using
@@ -189,13 +386,13 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	err = -ENOMEM;
 
 	msblk->block_cache = squashfs_cache_init("metadata",
-			SQUASHFS_CACHED_BLKS, SQUASHFS_METADATA_SIZE);
+			msblk->metadata_cache_entries, SQUASHFS_METADATA_SIZE);
 	if (msblk->block_cache == NULL)
 		goto failed_mount;
 
 	/* Allocate read_page block */
 	msblk->read_page = squashfs_cache_init("data",
-		squashfs_max_decompressors(), msblk->block_size);
+		msblk->data_cache_entries, msblk->block_size);
 	if (msblk->read_page == NULL) {
 		ERROR("Failed to allocate read_page block\n");
 		goto failed_mount;
@@ -265,7 +462,7 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 		goto check_directory_table;
 
 	msblk->fragment_cache = squashfs_cache_init("fragment",
-		SQUASHFS_CACHED_FRAGMENTS, msblk->block_size);
+		msblk->fragment_cache_entries, msblk->block_size);
 	if (msblk->fragment_cache == NULL) {
 		err = -ENOMEM;
 		goto failed_mount;
@@ -310,9 +507,16 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	}
 	insert_inode_hash(root);
 
+	err = squashfs_sysfs_register(sb);
+	if (err) {
+		iput(root);
+		goto failed_mount;
+	}
+
 	sb->s_root = d_make_root(root);
 	if (sb->s_root == NULL) {
 		ERROR("Root inode create failed\n");
+		squashfs_sysfs_unregister(msblk);
 		err = -ENOMEM;
 		goto failed_mount;
 	}
@@ -358,6 +562,23 @@ static int squashfs_statfs(struct dentry *dentry, struct kstatfs *buf)
 }
 
 
+static int squashfs_show_options(struct seq_file *seq, struct dentry *root)
+{
+	struct squashfs_sb_info *msblk = root->d_sb->s_fs_info;
+
+	if (msblk->metadata_cache_entries != SQUASHFS_CACHED_BLKS)
+		seq_printf(seq, ",metadata_cache=%d",
+			msblk->metadata_cache_entries);
+	if (msblk->fragment_cache_entries != SQUASHFS_CACHED_FRAGMENTS)
+		seq_printf(seq, ",fragment_cache=%d",
+			msblk->fragment_cache_entries);
+	if (msblk->data_cache_entries != squashfs_max_decompressors())
+		seq_printf(seq, ",data_cache=%d", msblk->data_cache_entries);
+
+	return 0;
+}
+
+
 static int squashfs_remount(struct super_block *sb, int *flags, char *data)
 {
 	sync_filesystem(sb);
@@ -370,6 +591,7 @@ static void squashfs_put_super(struct super_block *sb)
 {
 	if (sb->s_fs_info) {
 		struct squashfs_sb_info *sbi = sb->s_fs_info;
+		squashfs_sysfs_unregister(sbi);
 		squashfs_cache_delete(sbi->block_cache);
 		squashfs_cache_delete(sbi->fragment_cache);
 		squashfs_cache_delete(sbi->read_page);
@@ -432,8 +654,15 @@ static int __init init_squashfs_fs(void)
 	if (err)
 		return err;
 
+	squashfs_kset = kset_create_and_add("squashfs", NULL, fs_kobj);
+	if (squashfs_kset == NULL) {
+		destroy_inodecache();
+		return -ENOMEM;
+	}
+
 	err = register_filesystem(&squashfs_fs_type);
 	if (err) {
+		kset_unregister(squashfs_kset);
 		destroy_inodecache();
 		return err;
 	}
@@ -447,6 +676,7 @@ static int __init init_squashfs_fs(void)
 static void __exit exit_squashfs_fs(void)
 {
 	unregister_filesystem(&squashfs_fs_type);
+	kset_unregister(squashfs_kset);
 	destroy_inodecache();
 }
 
@@ -478,6 +708,7 @@ static const struct super_operations squashfs_super_ops = {
 	.alloc_inode = squashfs_alloc_inode,
 	.free_inode = squashfs_free_inode,
 	.statfs = squashfs_statfs,
+	.show_options = squashfs_show_options,
 	.put_super = squashfs_put_super,
 	.remount_fs = squashfs_remount
 };
@@ -15,12 +15,10 @@
 
 struct iio_dma_buffer_queue;
 struct iio_dma_buffer_ops;
+struct iio_buffer_block;
+struct iio_buffer_block_alloc_req;
 struct device;
-
-struct iio_buffer_block {
-	u32 size;
-	u32 bytes_used;
-};
+struct dma_buf;
 
 /**
  * enum iio_block_state - State of a struct iio_dma_buffer_block
@@ -46,6 +44,9 @@ enum iio_block_state {
  * @vaddr: Virutal address of the blocks memory
  * @phys_addr: Physical address of the blocks memory
  * @queue: Parent DMA buffer queue
+ * @id: Index of the block in the queue's blocks array, if it is one of them
+ * @dmabuf: DMA-BUF exporting the block's memory, if it is one of the blocks
+ *   allocated for block based access
  * @kref: kref used to manage the lifetime of block
  * @state: Current state of the block
  */
@@ -62,6 +63,8 @@ struct iio_dma_buffer_block {
 	dma_addr_t phys_addr;
 	size_t size;
 	struct iio_dma_buffer_queue *queue;
+	unsigned int id;
+	struct dma_buf *dmabuf;
 
 	/* Must not be accessed outside the core. */
 	struct kref kref;
@@ -101,6 +104,9 @@ struct iio_dma_buffer_queue_fileio {
  * @outgoing: List of buffers on the outgoing queue
  * @active: Whether the buffer is currently active
  * @fileio: FileIO state
+ * @blocks: Blocks allocated for block based access, protected by @lock
+ * @num_blocks: Number of entries in @blocks, non-zero while the buffer is
+ *   in block mode
  */
 struct iio_dma_buffer_queue {
 	struct iio_buffer buffer;
@@ -115,6 +121,9 @@ struct iio_dma_buffer_queue {
 	bool active;
 
 	struct iio_dma_buffer_queue_fileio fileio;
+
+	struct iio_dma_buffer_block **blocks;
+	unsigned int num_blocks;
 };
 
 /**
@@ -143,6 +152,16 @@ int iio_dma_buffer_set_bytes_per_datum(struct iio_buffer *buffer, size_t bpd);
 int iio_dma_buffer_set_length(struct iio_buffer *buffer, unsigned int length);
 int iio_dma_buffer_request_update(struct iio_buffer *buffer);
 
+int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
+	struct iio_buffer_block_alloc_req *req);
+int iio_dma_buffer_free_blocks(struct iio_buffer *buffer);
+int iio_dma_buffer_export_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block);
+int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block);
+int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block);
+
 int iio_dma_buffer_init(struct iio_dma_buffer_queue *queue,
 	struct device *dma_dev, const struct iio_dma_buffer_ops *ops);
 void iio_dma_buffer_exit(struct iio_dma_buffer_queue *queue);
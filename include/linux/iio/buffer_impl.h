@@ -3,6 +3,7 @@
 #define _IIO_BUFFER_GENERIC_IMPL_H_
 #include <linux/sysfs.h>
 #include <linux/kref.h>
+#include <uapi/linux/iio/buffer.h>
 
 #ifdef CONFIG_IIO_BUFFER
 
@@ -32,6 +33,14 @@ struct iio_buffer;
  *                      device stops sampling. Calles are balanced with @enable.
  * @release:		called when the last reference to the buffer is dropped,
  *			should free all resources allocated by the buffer.
+ * @alloc_blocks:	allocate blocks for block based access, see
+ *			IIO_BUFFER_BLOCK_ALLOC_IOCTL. Only called while the
+ *			buffer is disabled.
+ * @free_blocks:	free the blocks, returning the buffer to read() access.
+ *			Only called while the buffer is disabled.
+ * @export_block:	get a DMA-BUF file descriptor for a block
+ * @enqueue_block:	hand a block to the hardware to be filled
+ * @dequeue_block:	take a filled block back, -EAGAIN if there is none
  * @modes:		Supported operating modes by this buffer type
  * @flags:		A bitmask combination of INDIO_BUFFER_FLAG_*
  *
@@ -60,6 +69,16 @@ struct iio_buffer_access_funcs {
 
 	void (*release)(struct iio_buffer *buffer);
 
+	int (*alloc_blocks)(struct iio_buffer *buffer,
+			    struct iio_buffer_block_alloc_req *req);
+	int (*free_blocks)(struct iio_buffer *buffer);
+	int (*export_block)(struct iio_buffer *buffer,
+			    struct iio_buffer_block *block);
+	int (*enqueue_block)(struct iio_buffer *buffer,
+			     struct iio_buffer_block *block);
+	int (*dequeue_block)(struct iio_buffer *buffer,
+			     struct iio_buffer_block *block);
+
 	unsigned int modes;
 	unsigned int flags;
 };
@@ -139,8 +139,22 @@ typedef void (*ctor_fn_t)(void);
 
 struct file_system_type;
 
+/*
+ * An initcall that is allowed to run in parallel with the rest of its
+ * level.  @after, if set, must have been scheduled before this one.
+ */
+struct async_initcall {
+	initcall_t func;
+	struct async_initcall *after;
+	unsigned long long cookie;
+};
+
+#define DECLARE_ASYNC_INITCALL(fn)					\
+	extern struct async_initcall __async_initcall_##fn
+
 /* Defined in init/main.c */
 extern int do_one_initcall(initcall_t fn);
+extern int async_initcall_schedule(struct async_initcall *call);
 extern char __initdata boot_command_line[];
 extern char *saved_command_line;
 extern unsigned int reset_devices;
@@ -233,6 +247,37 @@ extern bool initcall_debug;
 
 #define __initcall(fn) device_initcall(fn)
 
+/*
+ * Async initcalls are called from their level in link order like any
+ * other initcall, but only get queued there and then run on any CPU in
+ * parallel with the rest of the level.  The level does not finish before
+ * all of them have returned, so later levels can still rely on them.
+ *
+ * An async initcall that depends on another one declares it with the
+ * _after variant, and will not be started before its dependency has
+ * returned.  The dependency must be an async initcall that comes earlier,
+ * either in link order or by level; DECLARE_ASYNC_INITCALL() makes one
+ * from another file visible.  Synchronous initcalls in the same level
+ * must not depend on async ones.
+ */
+#define __define_async_initcall(fn, dep, id)				\
+	struct async_initcall __async_initcall_##fn __initdata = {	\
+		.func = fn,						\
+		.after = dep,						\
+	};								\
+	static int __init __async_initcall_sched_##fn(void)		\
+	{								\
+		return async_initcall_schedule(&__async_initcall_##fn);	\
+	}								\
+	__define_initcall(__async_initcall_sched_##fn, id)
+
+#define device_initcall_async(fn)	__define_async_initcall(fn, NULL, 6)
+#define device_initcall_async_after(fn, dep)				\
+	__define_async_initcall(fn, &__async_initcall_##dep, 6)
+#define late_initcall_async(fn)		__define_async_initcall(fn, NULL, 7)
+#define late_initcall_async_after(fn, dep)				\
+	__define_async_initcall(fn, &__async_initcall_##dep, 7)
+
 #define __exitcall(fn)						\
 	static exitcall_t __exitcall_##fn __exit_call = fn
 
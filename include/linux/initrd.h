@@ -1,5 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0 */
 
+#ifndef __LINUX_INITRD_H
+#define __LINUX_INITRD_H
+
 #define INITRD_MINOR 250 /* shouldn't collide with /dev/ram* too soon ... */
 
 /* 1 = load ramdisk, 0 = don't load */
@@ -26,5 +29,13 @@ extern unsigned long phys_initrd_size;
 
 extern unsigned int real_root_dev;
 
+#ifdef CONFIG_BLK_DEV_INITRD
+extern void wait_for_initramfs(void);
+#else
+static inline void wait_for_initramfs(void) {}
+#endif
+
 extern char __initramfs_start[];
 extern unsigned long __initramfs_size;
+
+#endif /* __LINUX_INITRD_H */
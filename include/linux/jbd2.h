@@ -67,6 +67,7 @@ extern void *jbd2_alloc(size_t size, gfp_t flags);
 extern void jbd2_free(void *ptr, size_t size);
 
 #define JBD2_MIN_JOURNAL_BLOCKS 1024
+#define JBD2_DEFAULT_FAST_COMMIT_BLOCKS 256
 
 #ifdef __KERNEL__
 
@@ -262,7 +263,10 @@ typedef struct journal_superblock_s
 /* 0x0050 */
 	__u8	s_checksum_type;	/* checksum type */
 	__u8	s_padding2[3];
-	__u32	s_padding[42];
+/* 0x0054 */
+	__be32	s_num_fc_blks;		/* Number of fast commit blocks */
+/* 0x0058 */
+	__u32	s_padding[41];
 	__be32	s_checksum;		/* crc32c(superblock) */
 
 /* 0x0100 */
@@ -288,6 +292,7 @@ typedef struct journal_superblock_s
 #define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT	0x00000004
 #define JBD2_FEATURE_INCOMPAT_CSUM_V2		0x00000008
 #define JBD2_FEATURE_INCOMPAT_CSUM_V3		0x00000010
+#define JBD2_FEATURE_INCOMPAT_FAST_COMMIT	0x00000020
 
 /* See "journal feature predicate functions" below */
 
@@ -299,6 +304,10 @@ typedef struct journal_superblock_s
 					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | \
 					JBD2_FEATURE_INCOMPAT_CSUM_V2 | \
 					JBD2_FEATURE_INCOMPAT_CSUM_V3)
+/*
+ * Fast commits are only supported on journals whose client can replay them,
+ * see jbd2_known_incompat_features().
+ */
 
 #ifdef __KERNEL__
 
@@ -741,6 +750,9 @@ struct transaction_stats_s {
 	unsigned long		ts_tid;
 	unsigned long		ts_requested;
 	struct transaction_run_stats_s run;
+	unsigned long		ts_fc_commits;
+	unsigned long		ts_fc_fallbacks;
+	unsigned long		ts_fc_blocks;
 };
 
 static inline unsigned long
@@ -754,6 +766,11 @@ jbd2_time_diff(unsigned long start, unsigned long end)
 
 #define JBD2_NR_BATCH	64
 
+enum passtype {PASS_SCAN, PASS_REVOKE, PASS_REPLAY};
+
+#define JBD2_FC_REPLAY_STOP	0
+#define JBD2_FC_REPLAY_CONTINUE	1
+
 /**
  * struct journal_s - The journal_s type is the concrete type associated with
  *     journal_t.
@@ -951,6 +968,48 @@ struct journal_s
 	 */
 	unsigned int		j_maxlen;
 
+	/**
+	 * @j_fc_first:
+	 *
+	 * The block number of the first fast commit block in the journal
+	 * [j_state_lock].
+	 */
+	unsigned long		j_fc_first;
+
+	/**
+	 * @j_fc_off:
+	 *
+	 * Number of fast commit blocks currently allocated.  Accessed only
+	 * while a fast commit is ongoing.
+	 */
+	unsigned long		j_fc_off;
+
+	/**
+	 * @j_fc_last:
+	 *
+	 * The block number one beyond the last fast commit block in the
+	 * journal [j_state_lock].
+	 */
+	unsigned long		j_fc_last;
+
+	/**
+	 * @j_fc_wbufsize: Size of the fast commit buffer array.
+	 */
+	int			j_fc_wbufsize;
+
+	/**
+	 * @j_fc_wbuf: Array of fast commit buffers written by the client fs.
+	 */
+	struct buffer_head	**j_fc_wbuf;
+
+	/**
+	 * @j_fc_wait:
+	 *
+	 * Wait queue to wait for an ongoing fast commit or full commit to
+	 * finish.
+	 */
+	wait_queue_head_t	j_fc_wait;
+
 	/**
 	 * @j_reserved_credits:
 	 *
@@ -1106,6 +1165,22 @@ struct journal_s
 	void			(*j_commit_callback)(journal_t *,
 						     transaction_t *);
 
+	/**
+	 * @j_fc_replay_callback:
+	 *
+	 * Called once per fast commit block during recovery, for both the
+	 * scan and the replay pass.  @off is the index of the block in the
+	 * fast commit area and @expected_tid the first transaction id not
+	 * found in the regular log.  Returns JBD2_FC_REPLAY_CONTINUE to be
+	 * called with the next block, JBD2_FC_REPLAY_STOP once the fast
+	 * commit area has been fully consumed, or a negative error code.
+	 */
+	int			(*j_fc_replay_callback)(journal_t *journal,
+							struct buffer_head *bh,
+							enum passtype pass,
+							int off,
+							tid_t expected_tid);
+
 	/*
 	 * Journal statistics
 	 */
@@ -1235,6 +1310,14 @@ JBD2_FEATURE_INCOMPAT_FUNCS(64bit,		64BIT)
 JBD2_FEATURE_INCOMPAT_FUNCS(async_commit,	ASYNC_COMMIT)
 JBD2_FEATURE_INCOMPAT_FUNCS(csum2,		CSUM_V2)
 JBD2_FEATURE_INCOMPAT_FUNCS(csum3,		CSUM_V3)
+JBD2_FEATURE_INCOMPAT_FUNCS(fast_commit,	FAST_COMMIT)
+
+static inline int jbd2_journal_get_num_fc_blks(journal_superblock_t *jsb)
+{
+	int num_fc_blocks = be32_to_cpu(jsb->s_num_fc_blks);
+
+	return num_fc_blocks ? num_fc_blocks : JBD2_DEFAULT_FAST_COMMIT_BLOCKS;
+}
 
 /*
  * Journal flag definitions
@@ -1249,6 +1332,8 @@ JBD2_FEATURE_INCOMPAT_FUNCS(csum3,		CSUM_V3)
 						 * data write error in ordered
 						 * mode */
 #define JBD2_REC_ERR	0x080	/* The errno in the sb has been recorded */
+#define JBD2_FAST_COMMIT_ONGOING	0x100	/* Fast commit is ongoing */
+#define JBD2_FULL_COMMIT_ONGOING	0x200	/* Full commit is ongoing */
 
 /*
  * Function declarations for the journaling transaction and buffer
@@ -1421,6 +1506,14 @@ extern int	   jbd2_journal_inode_ranged_wait(handle_t *handle,
 extern int	   jbd2_journal_begin_ordered_truncate(journal_t *journal,
 				struct jbd2_inode *inode, loff_t new_size);
 extern void	   jbd2_journal_init_jbd_inode(struct jbd2_inode *jinode, struct inode *inode);
+
+/* Fast commit related APIs */
+extern int	   jbd2_fc_begin_commit(journal_t *journal, tid_t tid);
+extern int	   jbd2_fc_end_commit(journal_t *journal);
+extern int	   jbd2_fc_end_commit_fallback(journal_t *journal);
+extern int	   jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out);
+extern int	   jbd2_fc_wait_bufs(journal_t *journal, int num_blks);
+extern int	   jbd2_fc_release_bufs(journal_t *journal);
 extern void	   jbd2_journal_release_jbd_inode(journal_t *journal, struct jbd2_inode *jinode);
 
 /*
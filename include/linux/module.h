@@ -123,6 +123,10 @@ extern void cleanup_module(void);
 #define device_initcall_sync(fn)	module_init(fn)
 #define late_initcall(fn)		module_init(fn)
 #define late_initcall_sync(fn)		module_init(fn)
+#define device_initcall_async(fn)	module_init(fn)
+#define device_initcall_async_after(fn, dep)	module_init(fn)
+#define late_initcall_async(fn)		module_init(fn)
+#define late_initcall_async_after(fn, dep)	module_init(fn)
 
 #define console_initcall(fn)		module_init(fn)
 
@@ -402,6 +406,9 @@ struct module {
 	const s32 *gpl_future_crcs;
 	unsigned int num_gpl_future_syms;
 
+	/* Hashed index of all the above, protected like the module list. */
+	struct module_symindex *symindex;
+
 	/* Exception table */
 	unsigned int num_exentries;
 	struct exception_table_entry *extable;
@@ -409,6 +416,11 @@ struct module {
 	/* Startup function. */
 	int (*init)(void);
 
+	/* Time spent in load_module(), resolving symbols and in init. */
+	unsigned int load_usecs;
+	unsigned int resolve_usecs;
+	unsigned int init_usecs;
+
 	/* Core layout: rbtree is accessed frequently, so keep together. */
 	struct module_layout core_layout __module_layout_align;
 	struct module_layout init_layout;
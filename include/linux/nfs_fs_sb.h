@@ -138,6 +138,8 @@ struct nfs_server {
 	struct rpc_clnt *	client_acl;	/* ACL RPC client handle */
 	struct nlm_host		*nlm_host;	/* NLM client handle */
 	struct nfs_iostats __percpu *io_stats;	/* I/O statistics */
+	atomic_long_t		read_inflight;	/* pages being read */
+	atomic_long_t		read_inflight_max;
 	atomic_long_t		writeback;	/* number of writeback pages */
 	int			flags;		/* various flags */
 
@@ -153,6 +155,8 @@ struct nfs_server {
 	unsigned int		caps;		/* server capabilities */
 	unsigned int		rsize;		/* read size */
 	unsigned int		rpages;		/* read size (in pages) */
+	unsigned int		rasize;		/* readahead window, 0 for
+						   the default */
 	unsigned int		wsize;		/* write size */
 	unsigned int		wpages;		/* write size (in pages) */
 	unsigned int		wtmult;		/* server disk block size */
@@ -36,6 +36,7 @@ enum {
 	PG_REMOVE,		/* page group sync bit in write path */
 	PG_CONTENDED1,		/* Is someone waiting for a lock? */
 	PG_CONTENDED2,		/* Is someone waiting for a lock? */
+	PG_READAHEAD,		/* counted in read_inflight */
 };
 
 struct nfs_inode;
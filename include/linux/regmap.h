@@ -39,6 +39,7 @@ enum regcache_type {
 	REGCACHE_RBTREE,
 	REGCACHE_COMPRESSED,
 	REGCACHE_FLAT,
+	REGCACHE_FLAT_S,
 };
 
 /**
@@ -22,6 +22,7 @@
 #include <linux/errno.h>
 #include <linux/jhash.h>
 #include <linux/list_nulls.h>
+#include <linux/prefetch.h>
 #include <linux/workqueue.h>
 #include <linux/rculist.h>
 #include <linux/bit_spinlock.h>
@@ -836,6 +837,91 @@ static inline int rhashtable_insert_fast(
 	return ret == NULL ? 0 : -EEXIST;
 }
 
+/**
+ * rhashtable_insert_fast_bulk - insert several objects into hash table
+ * @ht:		hash table
+ * @objs:	array of pointers to hash heads inside the objects
+ * @n:		number of entries in @objs
+ * @params:	hash table parameters
+ *
+ * Inserts the objects like calling rhashtable_insert_fast() on each would,
+ * but looks up the table and checks whether it needs to grow once for the
+ * whole batch, and prefetches the bucket of the next object while the
+ * current one is inserted.  Objects that cannot take the fast path, e.g.
+ * because a resize is in progress, are inserted one by one.
+ *
+ * It is safe to call this function from atomic context.
+ *
+ * Returns the number of objects inserted, which is less than @n if inserting
+ * objs[ret] failed, or the error if the very first insertion failed.
+ */
+static inline int rhashtable_insert_fast_bulk(
+	struct rhashtable *ht, struct rhash_head **objs, unsigned int n,
+	const struct rhashtable_params params)
+{
+	struct rhash_lock_head **bkt;
+	struct bucket_table *tbl;
+	struct rhash_head *head;
+	unsigned int i, hash, next_hash = 0;
+	int elasticity;
+	int err;
+
+	rcu_read_lock();
+
+	tbl = rht_dereference_rcu(ht->tbl, ht);
+	if (n)
+		next_hash = rht_head_hashfn(ht, tbl, objs[0], params);
+
+	for (i = 0; i < n; i++) {
+		hash = next_hash;
+		if (i + 1 < n) {
+			next_hash = rht_head_hashfn(ht, tbl, objs[i + 1],
+						    params);
+			if (!tbl->nest)
+				prefetchw(&tbl->buckets[next_hash]);
+		}
+
+		bkt = rht_bucket_insert(ht, tbl, hash);
+		if (!bkt)
+			break;
+		rht_lock(tbl, bkt);
+
+		if (unlikely(rcu_access_pointer(tbl->future_tbl)) ||
+		    unlikely(rht_grow_above_100(ht, tbl)) ||
+		    unlikely(rht_grow_above_max(ht, tbl))) {
+			rht_unlock(tbl, bkt);
+			break;
+		}
+
+		elasticity = RHT_ELASTICITY;
+		rht_for_each_from(head, rht_ptr(bkt, tbl, hash), tbl, hash)
+			elasticity--;
+		if (elasticity <= 0) {
+			rht_unlock(tbl, bkt);
+			break;
+		}
+
+		head = rht_ptr(bkt, tbl, hash);
+		RCU_INIT_POINTER(objs[i]->next, head);
+		atomic_inc(&ht->nelems);
+		rht_assign_unlock(tbl, bkt, objs[i]);
+	}
+
+	if (rht_grow_above_75(ht, tbl))
+		schedule_work(&ht->run_work);
+
+	rcu_read_unlock();
+
+	/* Leave the rest to the slow path, one at a time */
+	for (; i < n; i++) {
+		err = rhashtable_insert_fast(ht, objs[i], params);
+		if (err)
+			return i ?: err;
+	}
+
+	return n;
+}
+
 /**
  * rhltable_insert_key - insert object into hash list table
  * @hlt:	hash list table
@@ -25,10 +25,19 @@ struct seccomp_filter;
  *
  *          @filter must only be accessed from the context of current as there
  *          is no read locking.
+ * @cache_hits: system calls allowed by the filter's action cache without
+ *              running any filter.
+ * @cache_misses: system calls for which the filters had to be run.
+ *
+ *          The cache counters are only updated by current.
  */
 struct seccomp {
 	int mode;
 	struct seccomp_filter *filter;
+#if defined(CONFIG_SECCOMP_FILTER) && defined(SECCOMP_ARCH_NATIVE)
+	unsigned long cache_hits;
+	unsigned long cache_misses;
+#endif
 };
 
 #ifdef CONFIG_HAVE_ARCH_SECCOMP_FILTER
@@ -112,4 +121,13 @@ static inline long seccomp_get_metadata(struct task_struct *task,
 	return -EINVAL;
 }
 #endif /* CONFIG_SECCOMP_FILTER && CONFIG_CHECKPOINT_RESTORE */
+
+#if defined(CONFIG_SECCOMP_FILTER) && defined(SECCOMP_ARCH_NATIVE)
+struct seq_file;
+struct pid_namespace;
+struct pid;
+
+extern int proc_pid_seccomp_cache(struct seq_file *m, struct pid_namespace *ns,
+				  struct pid *pid, struct task_struct *task);
+#endif
 #endif /* _LINUX_SECCOMP_H */
@@ -349,6 +349,10 @@ void *xa_store(struct xarray *, unsigned long index, void *entry, gfp_t);
 void *xa_erase(struct xarray *, unsigned long index);
 void *xa_store_range(struct xarray *, unsigned long first, unsigned long last,
 			void *entry, gfp_t);
+int xa_store_bulk(struct xarray *, unsigned long index, void **entries,
+			unsigned int nr, gfp_t);
+unsigned long xa_erase_range(struct xarray *, unsigned long first,
+			unsigned long last);
 bool xa_get_mark(struct xarray *, unsigned long index, xa_mark_t);
 void xa_set_mark(struct xarray *, unsigned long index, xa_mark_t);
 void xa_clear_mark(struct xarray *, unsigned long index, xa_mark_t);
@@ -518,6 +522,10 @@ static inline bool xa_marked(const struct xarray *xa, xa_mark_t mark)
  */
 void *__xa_erase(struct xarray *, unsigned long index);
 void *__xa_store(struct xarray *, unsigned long index, void *entry, gfp_t);
+int __xa_store_bulk(struct xarray *, unsigned long index, void **entries,
+		unsigned int nr, gfp_t);
+unsigned long __xa_erase_range(struct xarray *, unsigned long first,
+		unsigned long last);
 void *__xa_cmpxchg(struct xarray *, unsigned long index, void *old,
 		void *entry, gfp_t);
 int __must_check __xa_insert(struct xarray *, unsigned long index,
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/* The industrial I/O - block based buffer access */
+#ifndef _UAPI_IIO_BUFFER_H_
+#define _UAPI_IIO_BUFFER_H_
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct iio_buffer_block_alloc_req - Request for allocating buffer blocks
+ * @type:	Reserved for future use, must be 0
+ * @size:	Size of each block in bytes
+ * @count:	Number of blocks to allocate; set to the number of blocks
+ *		actually allocated on return
+ * @id:		Set to the id of the first block on return, the others
+ *		follow consecutively
+ */
+struct iio_buffer_block_alloc_req {
+	__u32 type;
+	__u32 size;
+	__u32 count;
+	__u32 id;
+};
+
+/**
+ * struct iio_buffer_block - Descriptor of a single buffer block
+ * @id:		Id of the block
+ * @size:	Size of the block in bytes
+ * @bytes_used:	Number of bytes in the block that contain valid data, set
+ *		when the block is dequeued
+ * @fd:		DMA-BUF file descriptor of the block, set by
+ *		IIO_BUFFER_BLOCK_EXPORT_IOCTL
+ * @flags:	Reserved for future use, must be 0
+ * @reserved:	Reserved for future use, must be 0
+ */
+struct iio_buffer_block {
+	__u32 id;
+	__u32 size;
+	__u32 bytes_used;
+	__s32 fd;
+	__u32 flags;
+	__u32 reserved;
+};
+
+/*
+ * Block based access replaces read() on buffers that support it: userspace
+ * allocates a set of blocks, exports each as a DMA-BUF to mmap() it or to
+ * pass it on to another device, and then cycles them through the buffer
+ * with IIO_BUFFER_BLOCK_ENQUEUE_IOCTL and IIO_BUFFER_BLOCK_DEQUEUE_IOCTL.
+ * The hardware fills the blocks directly, no data is copied.  Blocks can
+ * only be allocated and freed while the buffer is disabled.
+ */
+#define IIO_BUFFER_BLOCK_ALLOC_IOCTL	_IOWR('i', 0xa0, struct iio_buffer_block_alloc_req)
+#define IIO_BUFFER_BLOCK_FREE_IOCTL	_IO('i', 0xa1)
+#define IIO_BUFFER_BLOCK_EXPORT_IOCTL	_IOWR('i', 0xa2, struct iio_buffer_block)
+#define IIO_BUFFER_BLOCK_ENQUEUE_IOCTL	_IOW('i', 0xa3, struct iio_buffer_block)
+#define IIO_BUFFER_BLOCK_DEQUEUE_IOCTL	_IOR('i', 0xa4, struct iio_buffer_block)
+
+#endif /* _UAPI_IIO_BUFFER_H_ */
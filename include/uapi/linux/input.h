@@ -119,6 +119,68 @@ struct input_keymap_entry {
 	__u8  scancode[32];
 };
 
+/**
+ * struct input_batch - used by EVIOCSBATCH ioctl
+ * @packets: number of complete packets to collect before waking readers,
+ *	0 or 1 wakes them on every packet
+ * @timeout_us: maximum time in microseconds a packet may wait for the
+ *	rest of the batch, 0 for no limit
+ */
+struct input_batch {
+	__u32 packets;
+	__u32 timeout_us;
+};
+
+/**
+ * struct input_client_stats - used by EVIOCGSTATS ioctl
+ * @events: events queued for the client
+ * @dropped: events discarded because the client did not keep up
+ * @overflows: number of times the client's queue overflowed
+ * @wakeups: number of times readers were woken for the client
+ */
+struct input_client_stats {
+	__u64 events;
+	__u64 dropped;
+	__u64 overflows;
+	__u64 wakeups;
+};
+
+/**
+ * struct input_ring_event - an event in an mmap'd evdev ring
+ *
+ * Unlike struct input_event the layout does not depend on the ABI.
+ */
+struct input_ring_event {
+	__u64 sec;
+	__u32 usec;
+	__u16 type;
+	__u16 code;
+	__s32 value;
+	__u32 reserved;
+};
+
+/**
+ * struct input_ring_header - control page of an mmap'd evdev ring
+ * @head: index of the next event the kernel will write, only advanced
+ *	past complete packets
+ * @tail: index of the next event userspace will consume, written by
+ *	userspace once it is done with the events before it
+ * @size: number of events in the ring, a power of two
+ * @offset: offset of the first struct input_ring_event from the start of
+ *	the mapping
+ * @dropped: events discarded because the ring was full
+ *
+ * Indexes run freely and wrap at 2^32; the slot of index i is
+ * i & (size - 1).
+ */
+struct input_ring_header {
+	__u32 head;
+	__u32 tail;
+	__u32 size;
+	__u32 offset;
+	__u64 dropped;
+};
+
 struct input_mask {
 	__u32 type;
 	__u32 codes_size;
@@ -238,6 +300,32 @@ struct input_mask {
 
 #define EVIOCSCLOCKID		_IOW('E', 0xa0, int)			/* Set clockid to be used for timestamps */
 
+/**
+ * EVIOCSBATCH - Set wakeup batching
+ *
+ * Readers of the file descriptor, including poll() and SIGIO, are only
+ * notified once the given number of packets is queued, or the timeout
+ * has passed since the first of them.  See struct input_batch.
+ *
+ * Batching does not delay events already in the queue; a read() returns
+ * whatever complete packets are available.
+ */
+#define EVIOCSBATCH		_IOW('E', 0xa1, struct input_batch)	/* Set wakeup batching */
+#define EVIOCGSTATS		_IOR('E', 0xa2, struct input_client_stats)	/* Get client statistics */
+
+/*
+ * Event rings
+ *
+ * Instead of read(), a client may mmap() its file descriptor at offset 0
+ * to receive events through a ring shared with the kernel.  The mapping
+ * starts with a struct input_ring_header, the events follow at
+ * header.offset.  Its length selects the ring size: the largest power of
+ * two number of events that fits after the header page.  Once mapped,
+ * events are only delivered to the ring and read() fails with EBUSY.
+ * Packets that do not fit are dropped whole, and the next packet is then
+ * preceded by a SYN_DROPPED event.
+ */
+
 /*
  * IDs.
  */
@@ -92,6 +92,9 @@
 #include <linux/cache.h>
 #include <linux/rodata_test.h>
 #include <linux/jump_label.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
 #include <linux/mem_encrypt.h>
 
 #include <asm/io.h>
@@ -926,18 +929,13 @@ static inline void do_trace_initcall_finish(initcall_t fn, int ret)
 }
 #endif /* !TRACEPOINTS_ENABLED */
 
-int __init_or_module do_one_initcall(initcall_t fn)
+static int __init_or_module __do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
 	char msgbuf[64];
 	int ret;
 
-	if (initcall_blacklisted(fn))
-		return -EPERM;
-
-	do_trace_initcall_start(fn);
 	ret = fn();
-	do_trace_initcall_finish(fn, ret);
 
 	msgbuf[0] = 0;
 
@@ -955,6 +953,20 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	return ret;
 }
 
+int __init_or_module do_one_initcall(initcall_t fn)
+{
+	int ret;
+
+	if (initcall_blacklisted(fn))
+		return -EPERM;
+
+	do_trace_initcall_start(fn);
+	ret = __do_one_initcall(fn);
+	do_trace_initcall_finish(fn, ret);
+
+	return ret;
+}
+
 
 extern initcall_entry_t __initcall_start[];
 extern initcall_entry_t __initcall0_start[];
@@ -980,7 +992,7 @@ static initcall_entry_t *initcall_levels[] __initdata = {
 };
 
 /* Keep these in sync with initcalls in include/linux/init.h */
-static const char *initcall_level_names[] __initdata = {
+static const char *initcall_level_names[] = {
 	"pure",
 	"core",
 	"postcore",
@@ -991,6 +1003,209 @@ static const char *initcall_level_names[] __initdata = {
 	"late",
 };
 
+static ktime_t initcall_level_start[ARRAY_SIZE(initcall_level_names)];
+static ktime_t initcall_level_end[ARRAY_SIZE(initcall_level_names)];
+
+#ifdef CONFIG_DEBUG_FS
+/*
+ * With initcall_debug, the start and end time of every boot initcall is
+ * kept so that /sys/kernel/debug/initcall_report can show where the boot
+ * time went once the system is up.
+ */
+struct initcall_record {
+	struct list_head list;
+	const char *name;
+	ktime_t start;
+	ktime_t end;
+	int level;
+	bool async;
+};
+
+static LIST_HEAD(initcall_records);
+static DEFINE_MUTEX(initcall_records_lock);
+static unsigned int initcall_nr_records;
+
+static void __init initcall_record(initcall_t fn, int level, ktime_t start,
+				   ktime_t end, bool async)
+{
+	struct initcall_record *rec;
+
+	if (!initcall_debug)
+		return;
+
+	rec = kmalloc(sizeof(*rec), GFP_KERNEL);
+	if (!rec)
+		return;
+	rec->name = kasprintf(GFP_KERNEL, "%ps", fn);
+	rec->start = start;
+	rec->end = end;
+	rec->level = level;
+	rec->async = async;
+
+	mutex_lock(&initcall_records_lock);
+	list_add_tail(&rec->list, &initcall_records);
+	initcall_nr_records++;
+	mutex_unlock(&initcall_records_lock);
+}
+
+static s64 initcall_record_usecs(const struct initcall_record *rec)
+{
+	return ktime_us_delta(rec->end, rec->start);
+}
+
+static int initcall_record_cmp(const void *a, const void *b)
+{
+	s64 ua = initcall_record_usecs(*(const struct initcall_record **)a);
+	s64 ub = initcall_record_usecs(*(const struct initcall_record **)b);
+
+	if (ua == ub)
+		return 0;
+	return ua > ub ? -1 : 1;
+}
+
+#define INITCALL_REPORT_SLOWEST	20
+
+/*
+ * For each level, the wall time it took and the initcall that finished
+ * last in it: that is the one the next level had to wait for and so the
+ * one on the critical path.  Followed by the slowest initcalls overall.
+ */
+static int initcall_report_show(struct seq_file *m, void *v)
+{
+	struct initcall_record *rec, **sorted;
+	unsigned int i, nr = 0;
+	s64 total = 0;
+	int level;
+
+	mutex_lock(&initcall_records_lock);
+	if (list_empty(&initcall_records)) {
+		seq_puts(m, "no data, boot with initcall_debug\n");
+		goto out;
+	}
+
+	seq_printf(m, "%-10s %10s %10s %10s  %s\n",
+		   "level", "wall_us", "serial_us", "async_us", "critical");
+	for (level = 0; level < ARRAY_SIZE(initcall_level_names); level++) {
+		struct initcall_record *last = NULL;
+		s64 wall, serial = 0, async = 0;
+
+		list_for_each_entry(rec, &initcall_records, list) {
+			if (rec->level != level)
+				continue;
+			if (rec->async)
+				async += initcall_record_usecs(rec);
+			else
+				serial += initcall_record_usecs(rec);
+			if (!last || ktime_after(rec->end, last->end))
+				last = rec;
+		}
+		wall = ktime_us_delta(initcall_level_end[level],
+				      initcall_level_start[level]);
+		total += wall;
+		seq_printf(m, "%-10s %10lld %10lld %10lld  %s%s\n",
+			   initcall_level_names[level], wall, serial, async,
+			   last ? last->name : "-",
+			   last && last->async ? " (async)" : "");
+	}
+	seq_printf(m, "%-10s %10lld\n\n", "total", total);
+
+	sorted = kmalloc_array(initcall_nr_records, sizeof(*sorted), GFP_KERNEL);
+	if (!sorted)
+		goto out;
+	list_for_each_entry(rec, &initcall_records, list)
+		sorted[nr++] = rec;
+	sort(sorted, nr, sizeof(*sorted), initcall_record_cmp, NULL);
+
+	seq_printf(m, "%10s %-10s %-6s %s\n", "usecs", "level", "mode", "initcall");
+	for (i = 0; i < min_t(unsigned int, nr, INITCALL_REPORT_SLOWEST); i++) {
+		rec = sorted[i];
+		seq_printf(m, "%10lld %-10s %-6s %s\n",
+			   initcall_record_usecs(rec),
+			   initcall_level_names[rec->level],
+			   rec->async ? "async" : "serial", rec->name);
+	}
+	kfree(sorted);
+out:
+	mutex_unlock(&initcall_records_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(initcall_report);
+
+static int __init initcall_report_init(void)
+{
+	debugfs_create_file("initcall_report", 0444, NULL, NULL,
+			    &initcall_report_fops);
+	return 0;
+}
+late_initcall(initcall_report_init);
+#else
+static inline void initcall_record(initcall_t fn, int level, ktime_t start,
+				   ktime_t end, bool async)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
+
+static ASYNC_DOMAIN_EXCLUSIVE(initcall_domain);
+static int initcall_current_level __initdata;
+static bool initcall_queued __initdata;
+
+static bool initcall_async __initdata = true;
+static int __init initcall_async_setup(char *str)
+{
+	strtobool(str, &initcall_async);
+	return 1;
+}
+__setup("initcall_async=", initcall_async_setup);
+
+static void __init do_async_initcall(void *data, async_cookie_t cookie)
+{
+	struct async_initcall *call = data;
+	ktime_t start, end;
+	int ret;
+
+	if (call->after)
+		async_synchronize_cookie_domain(call->after->cookie + 1,
+						&initcall_domain);
+
+	if (initcall_blacklisted(call->func))
+		return;
+
+	/*
+	 * The initcall tracepoints assume one initcall at a time, so time
+	 * the parallel ones here.
+	 */
+	start = ktime_get();
+	ret = __do_one_initcall(call->func);
+	end = ktime_get();
+
+	if (initcall_debug)
+		printk(KERN_DEBUG "async initcall %pS returned %d after %lld usecs\n",
+		       call->func, ret, ktime_us_delta(end, start));
+	initcall_record(call->func, initcall_current_level, start, end, true);
+}
+
+/**
+ * async_initcall_schedule - queue an initcall to run in parallel
+ * @call: the async initcall, as set up by device_initcall_async() & co.
+ *
+ * Called from the initcall level the async initcall belongs to.  With
+ * initcall_async=0 on the command line the initcall is run right away.
+ */
+int __init async_initcall_schedule(struct async_initcall *call)
+{
+	if (!initcall_async)
+		return initcall_blacklisted(call->func) ? -EPERM : call->func();
+
+	WARN(call->after && !call->after->cookie,
+	     "async initcall %pS queued before its dependency %pS\n",
+	     call->func, call->after->func);
+
+	call->cookie = async_schedule_domain(do_async_initcall, call,
+					     &initcall_domain);
+	initcall_queued = true;
+	return 0;
+}
+
 static void __init do_initcall_level(int level)
 {
 	initcall_entry_t *fn;
@@ -1003,8 +1218,19 @@ static void __init do_initcall_level(int level)
 		   NULL, &repair_env_string);
 
 	trace_initcall_level(initcall_level_names[level]);
-	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
+	initcall_current_level = level;
+	initcall_level_start[level] = ktime_get();
+	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++) {
+		ktime_t start = ktime_get();
+
 		do_one_initcall(initcall_from_entry(fn));
+		if (!initcall_queued)
+			initcall_record(initcall_from_entry(fn), level, start,
+					ktime_get(), false);
+		initcall_queued = false;
+	}
+	async_synchronize_full_domain(&initcall_domain);
+	initcall_level_end[level] = ktime_get();
 }
 
 static void __init do_initcalls(void)
@@ -1028,7 +1254,6 @@ static void __init do_basic_setup(void)
 	driver_init();
 	init_irq_proc();
 	do_ctors();
-	usermodehelper_enable();
 	do_initcalls();
 }
 
@@ -1191,6 +1416,9 @@ static noinline void __init kernel_init_freeable(void)
 
 	do_basic_setup();
 
+	/* The initramfs may still be unpacking in the background */
+	wait_for_initramfs();
+
 	/* Open the /dev/console on the rootfs, this should never fail */
 	if (ksys_open((const char __user *) "/dev/console", O_RDWR, 0) < 0)
 		pr_err("Warning: unable to open an initial console.\n");
@@ -47,6 +47,7 @@
 #include <linux/mutex.h>
 #include <linux/gfp.h>
 #include <linux/pid.h>
+#include <linux/hash.h>
 
 #include <linux/audit.h>
 
@@ -135,6 +136,9 @@ u32		audit_sig_sid = 0;
 */
 static atomic_t	audit_lost = ATOMIC_INIT(0);
 
+/* Total time, in jiffies, that callers have spent waiting on the backlog */
+static atomic_t	audit_backlog_wait_time_actual = ATOMIC_INIT(0);
+
 /* Hash for inode-based rules */
 struct list_head audit_inode_hash[AUDIT_INODE_BUCKETS];
 
@@ -147,6 +151,24 @@ static struct sk_buff_head audit_retry_queue;
 /* queue msgs waiting for new auditd connection */
 static struct sk_buff_head audit_hold_queue;
 
+/*
+ * Records are first staged on one of several shard queues, picked by the
+ * generating task, and kauditd moves them over to audit_queue in batches.
+ * This keeps the producers off a single shared lock; hashing on the task
+ * rather than the CPU keeps all the records of one event on the same queue,
+ * and so in order, even if the task migrates while emitting them.
+ */
+#define AUDIT_SHARD_BITS	4
+#define AUDIT_SHARDS		(1 << AUDIT_SHARD_BITS)
+
+struct audit_shard {
+	struct sk_buff_head queue;
+} ____cacheline_aligned_in_smp;
+
+static struct audit_shard audit_shards[AUDIT_SHARDS];
+/* number of records sitting on the shard queues */
+static atomic_t audit_shard_backlog = ATOMIC_INIT(0);
+
 /* queue servicing thread */
 static struct task_struct *kauditd_task;
 static DECLARE_WAIT_QUEUE_HEAD(kauditd_wait);
@@ -798,6 +820,48 @@ static void kauditd_send_multicast_skb(struct sk_buff *skb)
 	nlmsg_multicast(sock, copy, 0, AUDIT_NLGRP_READLOG, GFP_KERNEL);
 }
 
+/**
+ * audit_backlog - Return the number of records waiting to be sent
+ */
+static unsigned int audit_backlog(void)
+{
+	return atomic_read(&audit_shard_backlog) + skb_queue_len(&audit_queue);
+}
+
+/**
+ * kauditd_collect - Move the staged records to the main queue
+ *
+ * Description:
+ * Splice each non-empty shard queue over to the main queue, taking each
+ * shard lock once per batch rather than once per record.
+ */
+static void kauditd_collect(void)
+{
+	struct sk_buff_head batch;
+	unsigned long flags;
+	unsigned int total = 0;
+	int i;
+
+	__skb_queue_head_init(&batch);
+	for (i = 0; i < AUDIT_SHARDS; i++) {
+		struct sk_buff_head *queue = &audit_shards[i].queue;
+
+		if (!skb_queue_len(queue))
+			continue;
+		spin_lock_irqsave(&queue->lock, flags);
+		total += skb_queue_len(queue);
+		skb_queue_splice_tail_init(queue, &batch);
+		spin_unlock_irqrestore(&queue->lock, flags);
+	}
+	if (!total)
+		return;
+
+	spin_lock_irqsave(&audit_queue.lock, flags);
+	skb_queue_splice_tail_init(&batch, &audit_queue);
+	spin_unlock_irqrestore(&audit_queue.lock, flags);
+	atomic_sub(total, &audit_shard_backlog);
+}
+
 /**
  * kauditd_thread - Worker thread to send audit records to userspace
  * @dummy: unused
@@ -851,6 +915,7 @@ static int kauditd_thread(void *dummy)
 		 * unicast, dump failed record sends to the retry queue; if
 		 * sk == NULL due to previous failures we will just do the
 		 * multicast send and move the record to the hold queue */
+		kauditd_collect();
 		rc = kauditd_send_queue(sk, portid, &audit_queue, 1,
 					kauditd_send_multicast_skb,
 					(sk ?
@@ -872,8 +937,7 @@ static int kauditd_thread(void *dummy)
 		 *       regardless of if an auditd is connected, as we need to
 		 *       do the multicast send and rotate records from the
 		 *       main queue to the retry/hold queues */
-		wait_event_freezable(kauditd_wait,
-				     (skb_queue_len(&audit_queue) ? 1 : 0));
+		wait_event_freezable(kauditd_wait, (audit_backlog() ? 1 : 0));
 	}
 
 	return 0;
@@ -1200,9 +1264,10 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 		s.rate_limit		= audit_rate_limit;
 		s.backlog_limit		= audit_backlog_limit;
 		s.lost			= atomic_read(&audit_lost);
-		s.backlog		= skb_queue_len(&audit_queue);
+		s.backlog		= audit_backlog();
 		s.feature_bitmap	= AUDIT_FEATURE_BITMAP_ALL;
 		s.backlog_wait_time	= audit_backlog_wait_time;
+		s.backlog_wait_time_actual = atomic_read(&audit_backlog_wait_time_actual);
 		audit_send_reply(skb, seq, AUDIT_GET, 0, 0, &s, sizeof(s));
 		break;
 	}
@@ -1292,7 +1357,8 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 				return err;
 		}
 		if (s.mask & AUDIT_STATUS_BACKLOG_WAIT_TIME) {
-			if (sizeof(s) > (size_t)nlh->nlmsg_len)
+			if (offsetofend(struct audit_status, backlog_wait_time) >
+			    (size_t)nlh->nlmsg_len)
 				return -EINVAL;
 			if (s.backlog_wait_time > 10*AUDIT_BACKLOG_WAIT_TIME)
 				return -EINVAL;
@@ -1306,6 +1372,13 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 			audit_log_config_change("lost", 0, lost, 1);
 			return lost;
 		}
+		if (s.mask == AUDIT_STATUS_BACKLOG_WAIT_TIME_ACTUAL) {
+			u32 actual = atomic_xchg(&audit_backlog_wait_time_actual, 0);
+
+			audit_log_config_change("backlog_wait_time_actual", 0,
+						actual, 1);
+			return actual;
+		}
 		break;
 	}
 	case AUDIT_GET_FEATURE:
@@ -1584,6 +1657,8 @@ static int __init audit_init(void)
 	skb_queue_head_init(&audit_queue);
 	skb_queue_head_init(&audit_retry_queue);
 	skb_queue_head_init(&audit_hold_queue);
+	for (i = 0; i < AUDIT_SHARDS; i++)
+		skb_queue_head_init(&audit_shards[i].queue);
 
 	for (i = 0; i < AUDIT_INODE_BUCKETS; i++)
 		INIT_LIST_HEAD(&audit_inode_hash[i]);
@@ -1765,24 +1840,27 @@ struct audit_buffer *audit_log_start(struct audit_context *ctx, gfp_t gfp_mask,
 		long stime = audit_backlog_wait_time;
 
 		while (audit_backlog_limit &&
-		       (skb_queue_len(&audit_queue) > audit_backlog_limit)) {
+		       (audit_backlog() > audit_backlog_limit)) {
 			/* wake kauditd to try and flush the queue */
 			wake_up_interruptible(&kauditd_wait);
 
 			/* sleep if we are allowed and we haven't exhausted our
 			 * backlog wait limit */
 			if (gfpflags_allow_blocking(gfp_mask) && (stime > 0)) {
+				long rtime = stime;
 				DECLARE_WAITQUEUE(wait, current);
 
 				add_wait_queue_exclusive(&audit_backlog_wait,
 							 &wait);
 				set_current_state(TASK_UNINTERRUPTIBLE);
-				stime = schedule_timeout(stime);
+				stime = schedule_timeout(rtime);
+				atomic_add(rtime - stime,
+					   &audit_backlog_wait_time_actual);
 				remove_wait_queue(&audit_backlog_wait, &wait);
 			} else {
 				if (audit_rate_check() && printk_ratelimit())
-					pr_warn("audit_backlog=%d > audit_backlog_limit=%d\n",
-						skb_queue_len(&audit_queue),
+					pr_warn("audit_backlog=%u > audit_backlog_limit=%u\n",
+						audit_backlog(),
 						audit_backlog_limit);
 				audit_log_lost("backlog limit exceeded");
 				return NULL;
@@ -2292,9 +2370,9 @@ int audit_signal_info(int sig, struct task_struct *t)
  * @ab: the audit_buffer
  *
  * We can not do a netlink send inside an irq context because it blocks (last
- * arg, flags, is not set to MSG_DONTWAIT), so the audit buffer is placed on a
- * queue and a tasklet is scheduled to remove them from the queue outside the
- * irq context.  May be called in any context.
+ * arg, flags, is not set to MSG_DONTWAIT), so the audit buffer is placed on
+ * the current task's shard queue for kauditd to send outside the irq
+ * context.  May be called in any context.
  */
 void audit_log_end(struct audit_buffer *ab)
 {
@@ -2313,9 +2391,15 @@ void audit_log_end(struct audit_buffer *ab)
 		nlh = nlmsg_hdr(skb);
 		nlh->nlmsg_len = skb->len - NLMSG_HDRLEN;
 
-		/* queue the netlink packet and poke the kauditd thread */
-		skb_queue_tail(&audit_queue, skb);
-		wake_up_interruptible(&kauditd_wait);
+		/* queue the netlink packet and poke the kauditd thread; a
+		 * kauditd that is already awake will pick the record up on
+		 * its next pass, so skip the wakeup and its lock then */
+		skb_queue_tail(&audit_shards[hash_32(task_pid_nr(current),
+						     AUDIT_SHARD_BITS)].queue,
+			       skb);
+		atomic_inc(&audit_shard_backlog);
+		if (wq_has_sleeper(&kauditd_wait))
+			wake_up_interruptible(&kauditd_wait);
 	} else
 		audit_log_lost("rate limit exceeded");
 
@@ -1604,6 +1604,10 @@ static void copy_seccomp(struct task_struct *p)
 	/* Ref-count the new filter user, and assign it. */
 	get_seccomp_filter(current);
 	p->seccomp = current->seccomp;
+#if defined(CONFIG_SECCOMP_FILTER) && defined(SECCOMP_ARCH_NATIVE)
+	p->seccomp.cache_hits = 0;
+	p->seccomp.cache_misses = 0;
+#endif
 
 	/*
 	 * Explicitly enable no_new_privs here in case it got set
@@ -50,6 +50,8 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/hashtable.h>
+#include <linux/stringhash.h>
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <uapi/linux/module.h>
@@ -416,63 +418,78 @@ static bool each_symbol_in_section(const struct symsearch *arr,
 	return false;
 }
 
-/* Returns true as soon as fn returns true, otherwise false. */
-bool each_symbol_section(bool (*fn)(const struct symsearch *arr,
-				    struct module *owner,
-				    void *data),
-			 void *data)
+static const struct symsearch vmlinux_symsearch[] = {
+	{ __start___ksymtab, __stop___ksymtab, __start___kcrctab,
+	  NOT_GPL_ONLY, false },
+	{ __start___ksymtab_gpl, __stop___ksymtab_gpl,
+	  __start___kcrctab_gpl,
+	  GPL_ONLY, false },
+	{ __start___ksymtab_gpl_future, __stop___ksymtab_gpl_future,
+	  __start___kcrctab_gpl_future,
+	  WILL_BE_GPL_ONLY, false },
+#ifdef CONFIG_UNUSED_SYMBOLS
+	{ __start___ksymtab_unused, __stop___ksymtab_unused,
+	  __start___kcrctab_unused,
+	  NOT_GPL_ONLY, true },
+	{ __start___ksymtab_unused_gpl, __stop___ksymtab_unused_gpl,
+	  __start___kcrctab_unused_gpl,
+	  GPL_ONLY, true },
+#endif
+};
+
+#define MODULE_NR_SYMSEARCH	ARRAY_SIZE(vmlinux_symsearch)
+
+/* Fill in the MODULE_NR_SYMSEARCH exported symbol tables of @mod. */
+static void module_symsearch(const struct module *mod, struct symsearch *arr)
 {
-	struct module *mod;
-	static const struct symsearch arr[] = {
-		{ __start___ksymtab, __stop___ksymtab, __start___kcrctab,
+	const struct symsearch tables[] = {
+		{ mod->syms, mod->syms + mod->num_syms, mod->crcs,
 		  NOT_GPL_ONLY, false },
-		{ __start___ksymtab_gpl, __stop___ksymtab_gpl,
-		  __start___kcrctab_gpl,
+		{ mod->gpl_syms, mod->gpl_syms + mod->num_gpl_syms,
+		  mod->gpl_crcs,
 		  GPL_ONLY, false },
-		{ __start___ksymtab_gpl_future, __stop___ksymtab_gpl_future,
-		  __start___kcrctab_gpl_future,
+		{ mod->gpl_future_syms,
+		  mod->gpl_future_syms + mod->num_gpl_future_syms,
+		  mod->gpl_future_crcs,
 		  WILL_BE_GPL_ONLY, false },
 #ifdef CONFIG_UNUSED_SYMBOLS
-		{ __start___ksymtab_unused, __stop___ksymtab_unused,
-		  __start___kcrctab_unused,
+		{ mod->unused_syms,
+		  mod->unused_syms + mod->num_unused_syms,
+		  mod->unused_crcs,
 		  NOT_GPL_ONLY, true },
-		{ __start___ksymtab_unused_gpl, __stop___ksymtab_unused_gpl,
-		  __start___kcrctab_unused_gpl,
+		{ mod->unused_gpl_syms,
+		  mod->unused_gpl_syms + mod->num_unused_gpl_syms,
+		  mod->unused_gpl_crcs,
 		  GPL_ONLY, true },
 #endif
 	};
 
+	BUILD_BUG_ON(ARRAY_SIZE(tables) != MODULE_NR_SYMSEARCH);
+	memcpy(arr, tables, sizeof(tables));
+}
+
+/* Returns true as soon as fn returns true, otherwise false. */
+bool each_symbol_section(bool (*fn)(const struct symsearch *arr,
+				    struct module *owner,
+				    void *data),
+			 void *data)
+{
+	struct module *mod;
+
 	module_assert_mutex_or_preempt();
 
-	if (each_symbol_in_section(arr, ARRAY_SIZE(arr), NULL, fn, data))
+	if (each_symbol_in_section(vmlinux_symsearch,
+				   ARRAY_SIZE(vmlinux_symsearch), NULL,
+				   fn, data))
 		return true;
 
 	list_for_each_entry_rcu(mod, &modules, list) {
-		struct symsearch arr[] = {
-			{ mod->syms, mod->syms + mod->num_syms, mod->crcs,
-			  NOT_GPL_ONLY, false },
-			{ mod->gpl_syms, mod->gpl_syms + mod->num_gpl_syms,
-			  mod->gpl_crcs,
-			  GPL_ONLY, false },
-			{ mod->gpl_future_syms,
-			  mod->gpl_future_syms + mod->num_gpl_future_syms,
-			  mod->gpl_future_crcs,
-			  WILL_BE_GPL_ONLY, false },
-#ifdef CONFIG_UNUSED_SYMBOLS
-			{ mod->unused_syms,
-			  mod->unused_syms + mod->num_unused_syms,
-			  mod->unused_crcs,
-			  NOT_GPL_ONLY, true },
-			{ mod->unused_gpl_syms,
-			  mod->unused_gpl_syms + mod->num_unused_gpl_syms,
-			  mod->unused_gpl_crcs,
-			  GPL_ONLY, true },
-#endif
-		};
+		struct symsearch arr[MODULE_NR_SYMSEARCH];
 
 		if (mod->state == MODULE_STATE_UNFORMED)
 			continue;
 
+		module_symsearch(mod, arr);
 		if (each_symbol_in_section(arr, ARRAY_SIZE(arr), mod, fn, data))
 			return true;
 	}
@@ -569,6 +586,108 @@ static bool find_exported_symbol_in_section(const struct symsearch *syms,
 	return false;
 }
 
+/*
+ * The exported symbols of loaded modules are also kept in a hash table
+ * keyed by name, so that resolving a symbol does not have to bsearch the
+ * tables of every loaded module in turn.  A module's symbols are added
+ * when it leaves MODULE_STATE_UNFORMED and removed when it is taken off
+ * the module list.  Like the list, the table is changed under
+ * module_mutex and walked under module_mutex or with preempt disabled.
+ */
+#define MODULE_SYMTAB_BITS	10
+static DEFINE_HASHTABLE(module_symtab, MODULE_SYMTAB_BITS);
+
+struct module_symindex_entry {
+	struct hlist_node node;
+	struct module *owner;
+	const struct symsearch *syms;
+	unsigned int symnum;
+};
+
+struct module_symindex {
+	struct symsearch syms[MODULE_NR_SYMSEARCH];
+	unsigned int num_entries;
+	struct module_symindex_entry entries[];
+};
+
+static u32 module_symhash(const char *name)
+{
+	return full_name_hash(NULL, name, strlen(name));
+}
+
+static int module_symindex_add(struct module *mod)
+{
+	struct symsearch arr[MODULE_NR_SYMSEARCH];
+	struct module_symindex *idx;
+	unsigned int i, j, n = 0;
+
+	lockdep_assert_held(&module_mutex);
+
+	module_symsearch(mod, arr);
+	for (i = 0; i < ARRAY_SIZE(arr); i++)
+		n += arr[i].stop - arr[i].start;
+	if (!n)
+		return 0;
+
+	idx = kvmalloc(struct_size(idx, entries, n), GFP_KERNEL);
+	if (!idx)
+		return -ENOMEM;
+	memcpy(idx->syms, arr, sizeof(arr));
+	idx->num_entries = n;
+
+	n = 0;
+	for (i = 0; i < ARRAY_SIZE(idx->syms); i++) {
+		const struct symsearch *syms = &idx->syms[i];
+
+		for (j = 0; j < syms->stop - syms->start; j++, n++) {
+			struct module_symindex_entry *e = &idx->entries[n];
+
+			e->owner = mod;
+			e->syms = syms;
+			e->symnum = j;
+			hash_add_rcu(module_symtab, &e->node,
+				     module_symhash(kernel_symbol_name(&syms->start[j])));
+		}
+	}
+	mod->symindex = idx;
+	return 0;
+}
+
+/* The index must only be freed after an RCU grace period. */
+static void module_symindex_del(struct module *mod)
+{
+	unsigned int i;
+
+	lockdep_assert_held(&module_mutex);
+
+	if (!mod->symindex)
+		return;
+	for (i = 0; i < mod->symindex->num_entries; i++)
+		hash_del_rcu(&mod->symindex->entries[i].node);
+}
+
+static void module_symindex_free(struct module *mod)
+{
+	kvfree(mod->symindex);
+	mod->symindex = NULL;
+}
+
+static bool find_exported_symbol_in_modules(struct find_symbol_arg *fsa)
+{
+	struct module_symindex_entry *e;
+
+	hash_for_each_possible_rcu(module_symtab, e, node,
+				   module_symhash(fsa->name)) {
+		const struct kernel_symbol *sym = &e->syms->start[e->symnum];
+
+		if (strcmp(fsa->name, kernel_symbol_name(sym)))
+			continue;
+		if (check_exported_symbol(e->syms, e->owner, e->symnum, fsa))
+			return true;
+	}
+	return false;
+}
+
 /* Find an exported symbol and return it, along with, (optional) crc and
  * (optional) module which owns it.  Needs preempt disabled or module_mutex. */
 const struct kernel_symbol *find_symbol(const char *name,
@@ -583,7 +702,12 @@ const struct kernel_symbol *find_symbol(const char *name,
 	fsa.gplok = gplok;
 	fsa.warn = warn;
 
-	if (each_symbol_section(find_exported_symbol_in_section, &fsa)) {
+	module_assert_mutex_or_preempt();
+
+	if (each_symbol_in_section(vmlinux_symsearch,
+				   ARRAY_SIZE(vmlinux_symsearch), NULL,
+				   find_exported_symbol_in_section, &fsa) ||
+	    find_exported_symbol_in_modules(&fsa)) {
 		if (owner)
 			*owner = fsa.owner;
 		if (crc)
@@ -1245,6 +1369,33 @@ static ssize_t show_taint(struct module_attribute *mattr,
 static struct module_attribute modinfo_taint =
 	__ATTR(taint, 0444, show_taint, NULL);
 
+static ssize_t show_load_usecs(struct module_attribute *mattr,
+			       struct module_kobject *mk, char *buffer)
+{
+	return sprintf(buffer, "%u\n", mk->mod->load_usecs);
+}
+
+static struct module_attribute modinfo_load_usecs =
+	__ATTR(load_usecs, 0444, show_load_usecs, NULL);
+
+static ssize_t show_resolve_usecs(struct module_attribute *mattr,
+				  struct module_kobject *mk, char *buffer)
+{
+	return sprintf(buffer, "%u\n", mk->mod->resolve_usecs);
+}
+
+static struct module_attribute modinfo_resolve_usecs =
+	__ATTR(resolve_usecs, 0444, show_resolve_usecs, NULL);
+
+static ssize_t show_init_usecs(struct module_attribute *mattr,
+			       struct module_kobject *mk, char *buffer)
+{
+	return sprintf(buffer, "%u\n", mk->mod->init_usecs);
+}
+
+static struct module_attribute modinfo_init_usecs =
+	__ATTR(init_usecs, 0444, show_init_usecs, NULL);
+
 static struct module_attribute *modinfo_attrs[] = {
 	&module_uevent,
 	&modinfo_version,
@@ -1253,6 +1404,9 @@ static struct module_attribute *modinfo_attrs[] = {
 	&modinfo_coresize,
 	&modinfo_initsize,
 	&modinfo_taint,
+	&modinfo_load_usecs,
+	&modinfo_resolve_usecs,
+	&modinfo_init_usecs,
 #ifdef CONFIG_MODULE_UNLOAD
 	&modinfo_refcnt,
 #endif
@@ -2162,11 +2316,13 @@ static void free_module(struct module *mod)
 	/* Unlink carefully: kallsyms could be walking list. */
 	list_del_rcu(&mod->list);
 	mod_tree_remove(mod);
+	module_symindex_del(mod);
 	/* Remove this module from bug list, this uses list_del_rcu */
 	module_bug_cleanup(mod);
 	/* Wait for RCU-sched synchronizing before releasing mod->list and buglist. */
 	synchronize_rcu();
 	mutex_unlock(&module_mutex);
+	module_symindex_free(mod);
 
 	/* This may be empty, but that's OK */
 	module_arch_freeing_init(mod);
@@ -3486,8 +3642,12 @@ static noinline int do_init_module(struct module *mod)
 
 	do_mod_ctors(mod);
 	/* Start the module */
-	if (mod->init != NULL)
+	if (mod->init != NULL) {
+		ktime_t start = ktime_get();
+
 		ret = do_one_initcall(mod->init);
+		mod->init_usecs = ktime_us_delta(ktime_get(), start);
+	}
 	if (ret < 0) {
 		goto fail_free_freeinit;
 	}
@@ -3637,6 +3797,10 @@ static int complete_formation(struct module *mod, struct load_info *info)
 	if (err < 0)
 		goto out;
 
+	err = module_symindex_add(mod);
+	if (err < 0)
+		goto out;
+
 	/* This relies on module_mutex for list integrity. */
 	module_bug_finalize(info->hdr, info->sechdrs, mod);
 
@@ -3696,6 +3860,7 @@ static int load_module(struct load_info *info, const char __user *uargs,
 	struct module *mod;
 	long err = 0;
 	char *after_dashes;
+	ktime_t start = ktime_get(), resolve_start;
 
 	err = elf_header_check(info);
 	if (err)
@@ -3774,9 +3939,11 @@ static int load_module(struct load_info *info, const char __user *uargs,
 	setup_modinfo(mod, info);
 
 	/* Fix up syms, so that st_value is a pointer to location. */
+	resolve_start = ktime_get();
 	err = simplify_symbols(mod, info);
 	if (err < 0)
 		goto free_modinfo;
+	mod->resolve_usecs = ktime_us_delta(ktime_get(), resolve_start);
 
 	err = apply_relocations(mod, info);
 	if (err < 0)
@@ -3838,6 +4005,7 @@ static int load_module(struct load_info *info, const char __user *uargs,
 	/* Done! */
 	trace_module_load(mod);
 
+	mod->load_usecs = ktime_us_delta(ktime_get(), start);
 	return do_init_module(mod);
 
  sysfs_cleanup:
@@ -3870,10 +4038,12 @@ static int load_module(struct load_info *info, const char __user *uargs,
 	/* Unlink carefully: kallsyms could be walking list. */
 	list_del_rcu(&mod->list);
 	mod_tree_remove(mod);
+	module_symindex_del(mod);
 	wake_up_all(&module_wq);
 	/* Wait for RCU-sched synchronizing before releasing mod->list. */
 	synchronize_rcu();
 	mutex_unlock(&module_mutex);
+	module_symindex_free(mod);
  free_module:
 	/* Free lock-classes; relies on the preceding sync_rcu() */
 	lockdep_free_key_range(mod->core_layout.base, mod->core_layout.size);
@@ -41,6 +41,7 @@
 #include <linux/tracehook.h>
 #include <linux/uaccess.h>
 #include <linux/anon_inodes.h>
+#include <linux/seq_file.h>
 
 enum notify_state {
 	SECCOMP_NOTIFY_INIT,
@@ -114,6 +115,7 @@ struct notification {
  * @prog: the BPF program to evaluate
  * @notif: the struct that holds all notification related information
  * @notify_lock: A lock for all notification-related accesses.
+ * @cache: syscalls this filter and all of its ancestors always allow
  *
  * seccomp_filter objects are organized in a tree linked via the @prev
  * pointer.  For any task, it appears to be a singly-linked list starting
@@ -125,6 +127,28 @@ struct notification {
  * seccomp_filter objects should never be modified after being attached
  * to a task_struct (other than @usage).
  */
+#ifdef SECCOMP_ARCH_NATIVE
+/**
+ * struct action_cache - syscalls a filter chain allows unconditionally
+ *
+ * @allow_native: bit set for each native syscall number that the filter
+ *                and all of its ancestors allow whatever the arguments are
+ * @allow_compat: the same for compat syscalls
+ *
+ * Computed once when the filter is attached by emulating the filter for
+ * every syscall number; syscalls with their bit set skip running the
+ * filters entirely.
+ */
+struct action_cache {
+	DECLARE_BITMAP(allow_native, SECCOMP_ARCH_NATIVE_NR);
+#ifdef SECCOMP_ARCH_COMPAT
+	DECLARE_BITMAP(allow_compat, SECCOMP_ARCH_COMPAT_NR);
+#endif
+};
+#else
+struct action_cache { };
+#endif /* SECCOMP_ARCH_NATIVE */
+
 struct seccomp_filter {
 	refcount_t usage;
 	bool log;
@@ -132,6 +156,7 @@ struct seccomp_filter {
 	struct bpf_prog *prog;
 	struct notification *notif;
 	struct mutex notify_lock;
+	struct action_cache cache;
 };
 
 /* Limit any path through the tree to 256KB worth of instructions. */
@@ -241,6 +266,60 @@ static int seccomp_check_filter(struct sock_filter *filter, unsigned int flen)
 	return 0;
 }
 
+#ifdef SECCOMP_ARCH_NATIVE
+static inline bool seccomp_cache_check_allow_bitmap(const void *bitmap,
+						    size_t bitmap_size,
+						    int syscall_nr)
+{
+	if (unlikely(syscall_nr < 0 || syscall_nr >= bitmap_size))
+		return false;
+	syscall_nr = array_index_nospec(syscall_nr, bitmap_size);
+
+	return test_bit(syscall_nr, bitmap);
+}
+
+/**
+ * seccomp_cache_check_allow - lookup seccomp cache
+ * @sfilter: The seccomp filter
+ * @sd: The seccomp data to lookup the cache with
+ *
+ * Returns true if the seccomp_data is cached and allowed.
+ */
+static inline bool seccomp_cache_check_allow(const struct seccomp_filter *sfilter,
+					     const struct seccomp_data *sd)
+{
+	const struct action_cache *cache = &sfilter->cache;
+
+	if (likely(sd->arch == SECCOMP_ARCH_NATIVE))
+		return seccomp_cache_check_allow_bitmap(cache->allow_native,
+							SECCOMP_ARCH_NATIVE_NR,
+							sd->nr);
+#ifdef SECCOMP_ARCH_COMPAT
+	if (likely(sd->arch == SECCOMP_ARCH_COMPAT))
+		return seccomp_cache_check_allow_bitmap(cache->allow_compat,
+							SECCOMP_ARCH_COMPAT_NR,
+							sd->nr);
+#endif
+	return false;
+}
+
+static inline void seccomp_cache_account(bool hit)
+{
+	if (hit)
+		current->seccomp.cache_hits++;
+	else
+		current->seccomp.cache_misses++;
+}
+#else
+static inline bool seccomp_cache_check_allow(const struct seccomp_filter *sfilter,
+					     const struct seccomp_data *sd)
+{
+	return false;
+}
+
+static inline void seccomp_cache_account(bool hit) { }
+#endif /* SECCOMP_ARCH_NATIVE */
+
 /**
  * seccomp_run_filters - evaluates all seccomp filters against @sd
  * @sd: optional seccomp data to be passed to filters
@@ -263,6 +342,12 @@ static u32 seccomp_run_filters(const struct seccomp_data *sd,
 	if (WARN_ON(f == NULL))
 		return SECCOMP_RET_KILL_PROCESS;
 
+	if (seccomp_cache_check_allow(f, sd)) {
+		seccomp_cache_account(true);
+		return SECCOMP_RET_ALLOW;
+	}
+	seccomp_cache_account(false);
+
 	/*
 	 * All filters in the list are evaluated and the lowest BPF return
 	 * value always takes priority (ignoring the DATA).
@@ -431,7 +516,13 @@ static struct seccomp_filter *seccomp_prepare_filter(struct sock_fprog *fprog)
 {
 	struct seccomp_filter *sfilter;
 	int ret;
-	const bool save_orig = IS_ENABLED(CONFIG_CHECKPOINT_RESTORE);
+	/* The action cache is computed from the original classic filter */
+	const bool save_orig =
+#if defined(CONFIG_CHECKPOINT_RESTORE) || defined(SECCOMP_ARCH_NATIVE)
+		true;
+#else
+		false;
+#endif
 
 	if (fprog->len == 0 || fprog->len > BPF_MAXINSNS)
 		return ERR_PTR(-EINVAL);
@@ -495,6 +586,151 @@ seccomp_prepare_user_filter(const char __user *user_filter)
 	return filter;
 }
 
+#ifdef SECCOMP_ARCH_NATIVE
+/**
+ * seccomp_is_const_allow - check if filter is constant allow with given data
+ * @fprog: The BPF programs
+ * @sd: The seccomp data to check against, only syscall number and arch
+ *      number are considered constant.
+ *
+ * Emulates the classic filter, giving up as soon as it looks at anything
+ * but the syscall number and the arch, which are constant for a given
+ * bitmap bit.  Only the instructions seen in filters generated by the
+ * common libraries are handled; anything else is conservatively treated
+ * as depending on the arguments.
+ *
+ * Returns true if the filter returns SECCOMP_RET_ALLOW for @sd no matter
+ * what the arguments, instruction pointer, or any other data are.
+ */
+static bool seccomp_is_const_allow(struct sock_fprog_kern *fprog,
+				   struct seccomp_data *sd)
+{
+	unsigned int reg_value = 0;
+	unsigned int pc;
+	bool op_res;
+
+	if (WARN_ON_ONCE(!fprog))
+		return false;
+
+	for (pc = 0; pc < fprog->len; pc++) {
+		struct sock_filter *insn = &fprog->filter[pc];
+		u16 code = insn->code;
+		u32 k = insn->k;
+
+		switch (code) {
+		case BPF_LD | BPF_W | BPF_ABS:
+			switch (k) {
+			case offsetof(struct seccomp_data, nr):
+				reg_value = sd->nr;
+				break;
+			case offsetof(struct seccomp_data, arch):
+				reg_value = sd->arch;
+				break;
+			default:
+				/* Arguments and instruction pointer vary. */
+				return false;
+			}
+			break;
+		case BPF_RET | BPF_K:
+			/* Reached a return with constant values only. */
+			return ACTION_ONLY(k) == SECCOMP_RET_ALLOW;
+		case BPF_JMP | BPF_JA:
+			pc += insn->k;
+			break;
+		case BPF_JMP | BPF_JEQ | BPF_K:
+		case BPF_JMP | BPF_JGE | BPF_K:
+		case BPF_JMP | BPF_JGT | BPF_K:
+		case BPF_JMP | BPF_JSET | BPF_K:
+			switch (BPF_OP(code)) {
+			case BPF_JEQ:
+				op_res = reg_value == k;
+				break;
+			case BPF_JGE:
+				op_res = reg_value >= k;
+				break;
+			case BPF_JGT:
+				op_res = reg_value > k;
+				break;
+			case BPF_JSET:
+				op_res = !!(reg_value & k);
+				break;
+			default:
+				/* Only the ops above can get here. */
+				return false;
+			}
+
+			pc += op_res ? insn->jt : insn->jf;
+			break;
+		case BPF_ALU | BPF_AND | BPF_K:
+			reg_value &= k;
+			break;
+		default:
+			/* Not worth emulating; assume it depends on the data. */
+			return false;
+		}
+	}
+
+	/* bpf_check_classic() guarantees every path ends in a return. */
+	WARN_ON(1);
+	return false;
+}
+
+static void seccomp_cache_prepare_bitmap(struct seccomp_filter *sfilter,
+					 unsigned long *bitmap,
+					 const unsigned long *bitmap_prev,
+					 size_t bitmap_size, int arch)
+{
+	struct sock_fprog_kern *fprog = sfilter->prog->orig_prog;
+	struct seccomp_data sd;
+	int nr;
+
+	/* A syscall can only be cached if every ancestor allows it too. */
+	if (bitmap_prev)
+		bitmap_copy(bitmap, bitmap_prev, bitmap_size);
+	else
+		bitmap_fill(bitmap, bitmap_size);
+
+	for (nr = 0; nr < bitmap_size; nr++) {
+		if (!test_bit(nr, bitmap))
+			continue;
+
+		sd.nr = nr;
+		sd.arch = arch;
+		if (!seccomp_is_const_allow(fprog, &sd))
+			__clear_bit(nr, bitmap);
+	}
+}
+
+/**
+ * seccomp_cache_prepare - emulate the filter to find cacheable syscalls
+ * @sfilter: The seccomp filter
+ *
+ * @sfilter->prev must already be set.
+ */
+static void seccomp_cache_prepare(struct seccomp_filter *sfilter)
+{
+	struct action_cache *cache = &sfilter->cache;
+	const struct action_cache *cache_prev =
+		sfilter->prev ? &sfilter->prev->cache : NULL;
+
+	seccomp_cache_prepare_bitmap(sfilter, cache->allow_native,
+				     cache_prev ? cache_prev->allow_native : NULL,
+				     SECCOMP_ARCH_NATIVE_NR,
+				     SECCOMP_ARCH_NATIVE);
+
+#ifdef SECCOMP_ARCH_COMPAT
+	seccomp_cache_prepare_bitmap(sfilter, cache->allow_compat,
+				     cache_prev ? cache_prev->allow_compat : NULL,
+				     SECCOMP_ARCH_COMPAT_NR,
+				     SECCOMP_ARCH_COMPAT);
+#endif /* SECCOMP_ARCH_COMPAT */
+}
+#else
+static inline void seccomp_cache_prepare(struct seccomp_filter *sfilter)
+{
+}
+#endif /* SECCOMP_ARCH_NATIVE */
+
 /**
  * seccomp_attach_filter: validate and attach filter
  * @flags:  flags to change filter behavior
@@ -540,6 +776,7 @@ static long seccomp_attach_filter(unsigned int flags,
 	 * task reference.
 	 */
 	filter->prev = current->seccomp.filter;
+	seccomp_cache_prepare(filter);
 	current->seccomp.filter = filter;
 
 	/* Now that the new filter is in place, synchronize to all threads. */
@@ -611,6 +848,60 @@ static void seccomp_send_sigsys(int syscall, int reason)
 	seccomp_init_siginfo(&info, syscall, reason);
 	force_sig_info(&info);
 }
+
+#ifdef SECCOMP_ARCH_NATIVE
+static void proc_pid_seccomp_cache_arch(struct seq_file *m, const char *name,
+					const unsigned long *bitmap,
+					size_t bitmap_size)
+{
+	seq_printf(m, "%s allowed %u/%zu\n", name,
+		   bitmap_weight(bitmap, bitmap_size), bitmap_size);
+}
+
+/*
+ * /proc/<pid>/seccomp_cache - how well the action cache of a task works:
+ * the number of syscalls allowed straight from the cache and of those
+ * that ran the filters, and how many syscalls of each arch are cached.
+ */
+int proc_pid_seccomp_cache(struct seq_file *m, struct pid_namespace *ns,
+			   struct pid *pid, struct task_struct *task)
+{
+	struct seccomp_filter *f;
+	unsigned long flags;
+
+	/* The allowed syscalls reveal what the filter permits; root only. */
+	if (!file_ns_capable(m->file, &init_user_ns, CAP_SYS_ADMIN))
+		return -EACCES;
+
+	if (!lock_task_sighand(task, &flags))
+		return -ESRCH;
+
+	f = task->seccomp.filter;
+	if (!f) {
+		unlock_task_sighand(task, &flags);
+		return 0;
+	}
+
+	/* Prevent the filter from being freed while we print it. */
+	__get_seccomp_filter(f);
+	unlock_task_sighand(task, &flags);
+
+	seq_printf(m, "hits %lu\nmisses %lu\n",
+		   READ_ONCE(task->seccomp.cache_hits),
+		   READ_ONCE(task->seccomp.cache_misses));
+	proc_pid_seccomp_cache_arch(m, SECCOMP_ARCH_NATIVE_NAME,
+				    f->cache.allow_native,
+				    SECCOMP_ARCH_NATIVE_NR);
+#ifdef SECCOMP_ARCH_COMPAT
+	proc_pid_seccomp_cache_arch(m, SECCOMP_ARCH_COMPAT_NAME,
+				    f->cache.allow_compat,
+				    SECCOMP_ARCH_COMPAT_NR);
+#endif
+
+	__put_seccomp_filter(f);
+	return 0;
+}
+#endif /* SECCOMP_ARCH_NATIVE */
 #endif	/* CONFIG_SECCOMP_FILTER */
 
 /* For use with seccomp_actions_logged */
@@ -19,6 +19,7 @@
 #include <linux/mount.h>
 #include <linux/kernel.h>
 #include <linux/init.h>
+#include <linux/initrd.h>
 #include <linux/resource.h>
 #include <linux/notifier.h>
 #include <linux/suspend.h>
@@ -568,6 +569,12 @@ int call_usermodehelper_exec(struct subprocess_info *sub_info, int wait)
 	if (strlen(sub_info->path) == 0)
 		goto out;
 
+	/*
+	 * The helper binary may live in the initramfs, which is unpacked
+	 * asynchronously; make sure it is all there before we exec.
+	 */
+	wait_for_initramfs();
+
 	/*
 	 * Set the completion pointer only if there is a waiter.
 	 * This makes it possible to use umh_complete to free
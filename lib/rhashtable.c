@@ -25,10 +25,19 @@
 #include <linux/rhashtable.h>
 #include <linux/err.h>
 #include <linux/export.h>
+#include <linux/cpumask.h>
+#include <linux/workqueue.h>
 
 #define HASH_DEFAULT_SIZE	64UL
 #define HASH_MIN_SIZE		4U
 
+/*
+ * Large tables are rehashed by several workers, each moving a contiguous
+ * range of at least REHASH_PARALLEL_MIN buckets.
+ */
+#define REHASH_PARALLEL_MIN	(1U << 14)
+#define REHASH_MAX_WORKERS	16U
+
 union nested_table {
 	union nested_table __rcu *table;
 	struct rhash_lock_head *bucket;
@@ -213,10 +222,10 @@ static struct bucket_table *rhashtable_last_table(struct rhashtable *ht,
 }
 
 static int rhashtable_rehash_one(struct rhashtable *ht,
+				 struct bucket_table *old_tbl,
 				 struct rhash_lock_head **bkt,
 				 unsigned int old_hash)
 {
-	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
 	struct bucket_table *new_tbl = rhashtable_last_table(ht, old_tbl);
 	int err = -EAGAIN;
 	struct rhash_head *head, *next, *entry;
@@ -263,9 +272,9 @@ static int rhashtable_rehash_one(struct rhashtable *ht,
 }
 
 static int rhashtable_rehash_chain(struct rhashtable *ht,
-				    unsigned int old_hash)
+				   struct bucket_table *old_tbl,
+				   unsigned int old_hash)
 {
-	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
 	struct rhash_lock_head **bkt = rht_bucket_var(old_tbl, old_hash);
 	int err;
 
@@ -273,7 +282,7 @@ static int rhashtable_rehash_chain(struct rhashtable *ht,
 		return 0;
 	rht_lock(old_tbl, bkt);
 
-	while (!(err = rhashtable_rehash_one(ht, bkt, old_hash)))
+	while (!(err = rhashtable_rehash_one(ht, old_tbl, bkt, old_hash)))
 		;
 
 	if (err == -ENOENT)
@@ -283,6 +292,95 @@ static int rhashtable_rehash_chain(struct rhashtable *ht,
 	return err;
 }
 
+static int rhashtable_rehash_range(struct rhashtable *ht,
+				   struct bucket_table *old_tbl,
+				   unsigned int start, unsigned int end)
+{
+	unsigned int old_hash;
+	int err = 0;
+
+	for (old_hash = start; old_hash < end; old_hash++) {
+		/*
+		 * Helpers do not hold ht->mutex, the RCU read lock keeps
+		 * the future tables they move entries to alive.
+		 */
+		rcu_read_lock();
+		err = rhashtable_rehash_chain(ht, old_tbl, old_hash);
+		rcu_read_unlock();
+		if (err)
+			break;
+		cond_resched();
+	}
+
+	return err;
+}
+
+struct rhashtable_rehash_work {
+	struct work_struct work;
+	struct rhashtable *ht;
+	struct bucket_table *old_tbl;
+	unsigned int start;
+	unsigned int end;
+	int err;
+};
+
+static void rhashtable_rehash_worker(struct work_struct *work)
+{
+	struct rhashtable_rehash_work *rw =
+		container_of(work, struct rhashtable_rehash_work, work);
+
+	rw->err = rhashtable_rehash_range(rw->ht, rw->old_tbl,
+					  rw->start, rw->end);
+}
+
+/*
+ * Move all chains of @old_tbl, splitting large tables over several workers.
+ * Chains are independent: each worker holds at most one old bucket lock and
+ * nests one new bucket lock inside it, just like a single worker would, so
+ * workers only contend where their entries land in the same new bucket.
+ */
+static int rhashtable_rehash_buckets(struct rhashtable *ht,
+				     struct bucket_table *old_tbl)
+{
+	unsigned int size = old_tbl->size;
+	struct rhashtable_rehash_work *rw;
+	unsigned int nr, chunk, i;
+	int err;
+
+	nr = min3(num_online_cpus(), REHASH_MAX_WORKERS,
+		  size / REHASH_PARALLEL_MIN);
+	if (nr < 2)
+		goto serial;
+
+	rw = kcalloc(nr, sizeof(*rw), GFP_KERNEL | __GFP_NOWARN);
+	if (!rw)
+		goto serial;
+
+	chunk = DIV_ROUND_UP(size, nr);
+	for (i = 0; i < nr; i++) {
+		rw[i].ht = ht;
+		rw[i].old_tbl = old_tbl;
+		rw[i].start = i * chunk;
+		rw[i].end = min(size, (i + 1) * chunk);
+		INIT_WORK(&rw[i].work, rhashtable_rehash_worker);
+		/* The first range is done by this worker itself */
+		if (i)
+			queue_work(system_unbound_wq, &rw[i].work);
+	}
+
+	err = rhashtable_rehash_range(ht, old_tbl, rw[0].start, rw[0].end);
+	for (i = 1; i < nr; i++) {
+		flush_work(&rw[i].work);
+		err = err ?: rw[i].err;
+	}
+	kfree(rw);
+
+	return err;
+
+serial:
+	return rhashtable_rehash_range(ht, old_tbl, 0, size);
+}
+
 static int rhashtable_rehash_attach(struct rhashtable *ht,
 				    struct bucket_table *old_tbl,
 				    struct bucket_table *new_tbl)
@@ -305,19 +403,15 @@ static int rhashtable_rehash_table(struct rhashtable *ht)
 	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
 	struct bucket_table *new_tbl;
 	struct rhashtable_walker *walker;
-	unsigned int old_hash;
 	int err;
 
 	new_tbl = rht_dereference(old_tbl->future_tbl, ht);
 	if (!new_tbl)
 		return 0;
 
-	for (old_hash = 0; old_hash < old_tbl->size; old_hash++) {
-		err = rhashtable_rehash_chain(ht, old_hash);
-		if (err)
-			return err;
-		cond_resched();
-	}
+	err = rhashtable_rehash_buckets(ht, old_tbl);
+	if (err)
+		return err;
 
 	/* Publish the new table pointer. */
 	rcu_assign_pointer(ht->tbl, new_tbl);
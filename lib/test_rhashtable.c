@@ -54,6 +54,10 @@ static bool enomem_retry = false;
 module_param(enomem_retry, bool, 0);
 MODULE_PARM_DESC(enomem_retry, "Retry insert even if -ENOMEM was returned (default: off)");
 
+static int bulk = 64;
+module_param(bulk, int, 0);
+MODULE_PARM_DESC(bulk, "Batch size for the bulk insert test, 0 to skip it (default: 64)");
+
 struct test_obj_val {
 	int	id;
 	int	tid;
@@ -266,6 +270,88 @@ static s64 __init test_rhashtable(struct rhashtable *ht, struct test_obj *array,
 static struct rhashtable ht;
 static struct rhltable rhlt;
 
+/*
+ * Insert the same keys as test_rhashtable() in batches of @bulk and compare
+ * the time taken, including the rehashes of the growing table, with one by
+ * one insertion.
+ */
+static int __init test_rhashtable_bulk(struct test_obj *array,
+				       unsigned int entries)
+{
+	struct rhash_head **batch;
+	s64 start, single, bulked;
+	unsigned int i, j, n;
+	int err = 0;
+
+	batch = kmalloc_array(bulk, sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return -ENOMEM;
+
+	pr_info("test %d inserts, one by one and in batches of %d\n",
+		entries, bulk);
+
+	/* test_rhashtable_max() leaves a max_size too small for this test */
+	test_rht_params.max_size = max_size ? : roundup_pow_of_two(entries);
+
+	memset(array, 0, entries * sizeof(struct test_obj));
+	err = rhashtable_init(&ht, &test_rht_params);
+	if (err)
+		goto out;
+
+	start = ktime_get_ns();
+	for (i = 0; i < entries; i++) {
+		array[i].value.id = i * 2;
+		err = rhashtable_insert_fast(&ht, &array[i].node,
+					     test_rht_params);
+		if (err)
+			break;
+	}
+	single = ktime_get_ns() - start;
+	rhashtable_destroy(&ht);
+	if (err)
+		goto out;
+
+	memset(array, 0, entries * sizeof(struct test_obj));
+	err = rhashtable_init(&ht, &test_rht_params);
+	if (err)
+		goto out;
+
+	start = ktime_get_ns();
+	for (i = 0; i < entries; i += n) {
+		n = min_t(unsigned int, bulk, entries - i);
+		for (j = 0; j < n; j++) {
+			array[i + j].value.id = (i + j) * 2;
+			batch[j] = &array[i + j].node;
+		}
+
+		err = rhashtable_insert_fast_bulk(&ht, batch, n,
+						  test_rht_params);
+		if (err != n) {
+			pr_warn("Test failed: bulk insert at %u returned %d\n",
+				i, err);
+			err = err < 0 ? err : -EINVAL;
+			break;
+		}
+		err = 0;
+		cond_resched();
+	}
+	bulked = ktime_get_ns() - start;
+
+	if (!err) {
+		test_bucket_stats(&ht, entries);
+		rcu_read_lock();
+		err = test_rht_lookup(&ht, array, entries);
+		rcu_read_unlock();
+	}
+	rhashtable_destroy(&ht);
+
+	pr_info("  one by one: %lld ns, bulk: %lld ns\n", single, bulked);
+
+out:
+	kfree(batch);
+	return err;
+}
+
 static int __init test_rhltable(unsigned int entries)
 {
 	struct test_obj_rhl *rhl_test_objects;
@@ -745,6 +831,9 @@ static int __init test_rht_init(void)
 	pr_info("test if its possible to exceed max_size %d: %s\n",
 			test_rht_params.max_size, test_rhashtable_max(objs, entries) == 0 ?
 			"no, ok" : "YES, failed");
+
+	if (bulk > 0 && test_rhashtable_bulk(objs, entries))
+		pr_warn("Test failed: bulk insert\n");
 	vfree(objs);
 
 	do_div(total_time, runs);
@@ -7,6 +7,9 @@
 
 #include <linux/xarray.h>
 #include <linux/module.h>
+#ifdef __KERNEL__
+#include <linux/ktime.h>
+#endif
 
 static unsigned int tests_run;
 static unsigned int tests_passed;
@@ -1375,6 +1378,99 @@ static noinline void check_store_range(struct xarray *xa)
 	}
 }
 
+static noinline void __check_store_bulk(struct xarray *xa, void **entries,
+		unsigned long start, unsigned int nr)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		entries[i] = xa_mk_index(start + i);
+
+	XA_BUG_ON(xa, xa_store_bulk(xa, start, entries, nr, GFP_KERNEL) != nr);
+	for (i = 0; i < nr; i++)
+		XA_BUG_ON(xa, xa_load(xa, start + i) != xa_mk_index(start + i));
+	if (start)
+		XA_BUG_ON(xa, xa_load(xa, start - 1) != NULL);
+	XA_BUG_ON(xa, xa_load(xa, start + nr) != NULL);
+
+	/* Storing over present entries replaces them */
+	for (i = 0; i < nr; i++)
+		entries[i] = xa_mk_index(start + i + 1);
+	XA_BUG_ON(xa, xa_store_bulk(xa, start, entries, nr, GFP_KERNEL) != nr);
+	XA_BUG_ON(xa, xa_load(xa, start) != xa_mk_index(start + 1));
+
+	/* Leave holes for xa_erase_range() to skip */
+	for (i = 1; i < nr; i += 2)
+		xa_erase(xa, start + i);
+	XA_BUG_ON(xa, xa_erase_range(xa, start, start + nr - 1) !=
+			(nr + 1) / 2);
+	XA_BUG_ON(xa, !xa_empty(xa));
+}
+
+static noinline void check_store_bulk(struct xarray *xa)
+{
+	static const unsigned int nrs[] = { 1, 2, 63, 64, 65, 300 };
+	static const unsigned long starts[] = { 0, 1, 60, 4095, 123456,
+						(1UL << 24) - 3 };
+	unsigned int i, j;
+	void **entries;
+
+	entries = kmalloc(300 * sizeof(*entries), GFP_KERNEL);
+	XA_BUG_ON(xa, !entries);
+	if (!entries)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(starts); i++)
+		for (j = 0; j < ARRAY_SIZE(nrs); j++)
+			__check_store_bulk(xa, entries, starts[i], nrs[j]);
+
+	XA_BUG_ON(xa, xa_store_bulk(xa, 5, entries, 0, GFP_KERNEL) != 0);
+	XA_BUG_ON(xa, xa_erase_range(xa, 0, ULONG_MAX) != 0);
+
+	kfree(entries);
+}
+
+#ifdef __KERNEL__
+/* Compare filling and emptying an array one index and a batch at a time */
+static noinline void bench_store_bulk(struct xarray *xa)
+{
+	const unsigned int batch = 64, total = 1 << 16;
+	u64 t0, t1, t2, t3, t4;
+	unsigned int i, j;
+	void **entries;
+
+	entries = kmalloc(batch * sizeof(*entries), GFP_KERNEL);
+	if (!entries)
+		return;
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < total; i++)
+		xa_store_index(xa, i, GFP_KERNEL);
+	t1 = ktime_get_ns();
+	for (i = 0; i < total; i++)
+		xa_erase(xa, i);
+	t2 = ktime_get_ns();
+	XA_BUG_ON(xa, !xa_empty(xa));
+
+	for (i = 0; i < total; i += batch) {
+		for (j = 0; j < batch; j++)
+			entries[j] = xa_mk_index(i + j);
+		xa_store_bulk(xa, i, entries, batch, GFP_KERNEL);
+	}
+	t3 = ktime_get_ns();
+	xa_erase_range(xa, 0, total - 1);
+	t4 = ktime_get_ns();
+	XA_BUG_ON(xa, !xa_empty(xa));
+
+	printk("XArray: %u entries: store %llu ns, bulk store %llu ns, "
+			"erase %llu ns, erase range %llu ns\n", total,
+			t1 - t0, t3 - t2, t2 - t1, t4 - t3);
+	kfree(entries);
+}
+#else
+static void bench_store_bulk(struct xarray *xa) { }
+#endif
+
 static void check_align_1(struct xarray *xa, char *name)
 {
 	int i;
@@ -1577,6 +1673,7 @@ static int xarray_checks(void)
 	check_move(&array);
 	check_create_range(&array);
 	check_store_range(&array);
+	check_store_bulk(&array);
 	check_store_iter(&array);
 	check_align(&xa0);
 
@@ -1584,6 +1681,8 @@ static int xarray_checks(void)
 	check_workingset(&array, 64);
 	check_workingset(&array, 4096);
 
+	bench_store_bulk(&array);
+
 	printk("XArray: %u of %u tests passed\n", tests_passed, tests_run);
 	return (tests_run == tests_passed) ? 0 : -EINVAL;
 }
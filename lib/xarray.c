@@ -1415,6 +1415,155 @@ void *xa_store(struct xarray *xa, unsigned long index, void *entry, gfp_t gfp)
 }
 EXPORT_SYMBOL(xa_store);
 
+/**
+ * __xa_store_bulk() - Store entries at consecutive indices.
+ * @xa: XArray.
+ * @index: Index of the first entry.
+ * @entries: Entries to store.
+ * @nr: Number of entries.
+ * @gfp: Memory allocation flags.
+ *
+ * Stores @entries[i] at @index + i.  Unlike calling __xa_store() @nr
+ * times, this only walks down from the root for the first entry and
+ * then moves along with xas_next(), which stays in the same node for
+ * up to XA_CHUNK_SIZE entries.
+ *
+ * You must already be holding the xa_lock when calling this function.
+ * It will drop the lock if needed to allocate memory, and then reacquire
+ * it afterwards.
+ *
+ * Context: Any context.  Expects xa_lock to be held on entry.  May
+ * release and reacquire xa_lock if @gfp flags permit.
+ * Return: The number of entries stored.  If that is less than @nr,
+ * storing the next one failed; the error is returned instead if the
+ * very first store failed.
+ */
+int __xa_store_bulk(struct xarray *xa, unsigned long index, void **entries,
+		unsigned int nr, gfp_t gfp)
+{
+	XA_STATE(xas, xa, index);
+	unsigned int i = 0;
+	void *entry;
+
+	if (!nr)
+		return 0;
+	if (WARN_ON_ONCE(index + nr - 1 < index))
+		return -EINVAL;
+
+	do {
+		while (i < nr) {
+			entry = entries[i];
+			if (WARN_ON_ONCE(xa_is_advanced(entry))) {
+				xas_set_err(&xas, -EINVAL);
+				break;
+			}
+			if (xa_track_free(xa) && !entry)
+				entry = XA_ZERO_ENTRY;
+
+			xas_store(&xas, entry);
+			if (xa_track_free(xa))
+				xas_clear_mark(&xas, XA_FREE_MARK);
+			if (xas_error(&xas))
+				break;
+
+			if (++i < nr)
+				xas_next(&xas);
+		}
+	} while (__xas_nomem(&xas, gfp));
+
+	if (i)
+		return i;
+	return xas_error(&xas);
+}
+EXPORT_SYMBOL(__xa_store_bulk);
+
+/**
+ * xa_store_bulk() - Store entries at consecutive indices.
+ * @xa: XArray.
+ * @index: Index of the first entry.
+ * @entries: Entries to store.
+ * @nr: Number of entries.
+ * @gfp: Memory allocation flags.
+ *
+ * Stores @entries[i] at @index + i with one acquisition of the xa_lock,
+ * see __xa_store_bulk().  The marks of the indices are unaffected
+ * unless the entry stored there is %NULL.
+ *
+ * Context: Any context.  Takes and releases the xa_lock.
+ * May sleep if the @gfp flags permit.
+ * Return: The number of entries stored, or a negative errno if not even
+ * the first could be stored.
+ */
+int xa_store_bulk(struct xarray *xa, unsigned long index, void **entries,
+		unsigned int nr, gfp_t gfp)
+{
+	int ret;
+
+	xa_lock(xa);
+	ret = __xa_store_bulk(xa, index, entries, nr, gfp);
+	xa_unlock(xa);
+
+	return ret;
+}
+EXPORT_SYMBOL(xa_store_bulk);
+
+/**
+ * __xa_erase_range() - Erase all entries in a range of indices.
+ * @xa: XArray.
+ * @first: First index to erase.
+ * @last: Last index to erase (inclusive).
+ *
+ * Walks the present entries from @first to @last with one cursor, so
+ * nodes that are empty for part of the range are skipped over and each
+ * node is only descended into once.  A multi-index entry overlapping the
+ * range is erased entirely.
+ *
+ * Context: Any context.  Expects xa_lock to be held on entry.
+ * Return: The number of entries erased.
+ */
+unsigned long __xa_erase_range(struct xarray *xa, unsigned long first,
+		unsigned long last)
+{
+	XA_STATE(xas, xa, first);
+	unsigned long count = 0;
+	void *entry;
+
+	xas_for_each(&xas, entry, last) {
+		xas_store(&xas, NULL);
+		if (xa_track_free(xa))
+			xas_set_mark(&xas, XA_FREE_MARK);
+		count++;
+	}
+
+	return count;
+}
+EXPORT_SYMBOL(__xa_erase_range);
+
+/**
+ * xa_erase_range() - Erase all entries in a range of indices.
+ * @xa: XArray.
+ * @first: First index to erase.
+ * @last: Last index to erase (inclusive).
+ *
+ * Like calling xa_erase() on every index in the range, but only takes the
+ * xa_lock once and does not visit empty indices.
+ *
+ * Context: Any context.  Takes and releases the xa_lock.
+ * Return: The number of entries erased.
+ */
+unsigned long xa_erase_range(struct xarray *xa, unsigned long first,
+		unsigned long last)
+{
+	unsigned long count;
+
+	xa_lock(xa);
+	count = __xa_erase_range(xa, first, last);
+	xa_unlock(xa);
+
+	return count;
+}
+EXPORT_SYMBOL(xa_erase_range);
+
 /**
  * __xa_cmpxchg() - Store this entry in the XArray.
  * @xa: XArray.
@@ -953,6 +953,108 @@ int add_to_page_cache_lru(struct page *page, struct address_space *mapping,
 }
 EXPORT_SYMBOL_GPL(add_to_page_cache_lru);
 
+/**
+ * add_to_page_cache_lru_batch - add several pages to the pagecache and LRU
+ * @mapping:	the pages' address_space
+ * @pages:	the pages to add, with ->index set and in ascending order
+ * @nr:		number of pages, at most PAGEVEC_SIZE
+ * @gfp_mask:	page allocation mode
+ *
+ * Like add_to_page_cache_lru() on each of @pages in turn, but takes the
+ * i_pages lock once for the whole batch, and stores runs of consecutive
+ * indices by moving the XArray cursor to the next slot rather than walking
+ * down from the root for every page.  Stops at the first page that cannot
+ * be added.
+ *
+ * Return: the number of pages added, counting from the start of @pages.
+ * Those are locked and on the LRU, as after add_to_page_cache_lru(); the
+ * rest are left as they were.
+ */
+unsigned int add_to_page_cache_lru_batch(struct address_space *mapping,
+		struct page **pages, unsigned int nr, gfp_t gfp_mask)
+{
+	XA_STATE(xas, &mapping->i_pages, 0);
+	struct mem_cgroup *memcg[PAGEVEC_SIZE];
+	void *shadow[PAGEVEC_SIZE];
+	unsigned int i, charged, added = 0;
+	bool cursor;
+
+	if (WARN_ON_ONCE(nr > PAGEVEC_SIZE))
+		nr = PAGEVEC_SIZE;
+	mapping_set_update(&xas, mapping);
+
+	for (charged = 0; charged < nr; charged++) {
+		struct page *page = pages[charged];
+
+		VM_BUG_ON_PAGE(PageSwapBacked(page), page);
+		VM_BUG_ON_PAGE(PageHuge(page), page);
+
+		if (mem_cgroup_try_charge(page, current->mm, gfp_mask,
+					  &memcg[charged], false))
+			break;
+
+		__SetPageLocked(page);
+		get_page(page);
+		page->mapping = mapping;
+		shadow[charged] = NULL;
+	}
+
+	do {
+		xas_lock_irq(&xas);
+		/* The cursor's node may be gone once the lock was dropped */
+		cursor = false;
+		for (; added < charged; added++) {
+			struct page *page = pages[added];
+			void *old;
+
+			if (cursor && xas.xa_index + 1 == page->index)
+				xas_next(&xas);
+			else
+				xas_set(&xas, page->index);
+
+			old = xas_load(&xas);
+			if (old && !xa_is_value(old))
+				xas_set_err(&xas, -EEXIST);
+			xas_store(&xas, page);
+			if (xas_error(&xas))
+				break;
+
+			if (xa_is_value(old)) {
+				mapping->nrexceptional--;
+				shadow[added] = old;
+			}
+			mapping->nrpages++;
+			__inc_node_page_state(page, NR_FILE_PAGES);
+			cursor = true;
+		}
+		xas_unlock_irq(&xas);
+	} while (xas_nomem(&xas, gfp_mask & GFP_RECLAIM_MASK));
+
+	for (i = 0; i < added; i++) {
+		struct page *page = pages[i];
+
+		mem_cgroup_commit_charge(page, memcg[i], false, false);
+		trace_mm_filemap_add_to_page_cache(page);
+
+		/* See add_to_page_cache_lru() */
+		WARN_ON_ONCE(PageActive(page));
+		if (!(gfp_mask & __GFP_WRITE) && shadow[i])
+			workingset_refault(page, shadow[i]);
+		lru_cache_add(page);
+	}
+
+	for (; i < charged; i++) {
+		struct page *page = pages[i];
+
+		page->mapping = NULL;
+		mem_cgroup_cancel_charge(page, memcg[i], false);
+		__ClearPageLocked(page);
+		put_page(page);
+	}
+
+	return added;
+}
+
 #ifdef CONFIG_NUMA
 struct page *__page_cache_alloc(gfp_t gfp)
 {
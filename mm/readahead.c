@@ -129,12 +129,34 @@ static int read_pages(struct address_space *mapping, struct file *filp,
 		goto out;
 	}
 
-	for (page_idx = 0; page_idx < nr_pages; page_idx++) {
-		struct page *page = lru_to_page(pages);
-		list_del(&page->lru);
-		if (!add_to_page_cache_lru(page, mapping, page->index, gfp))
-			mapping->a_ops->readpage(filp, page);
-		put_page(page);
+	page_idx = 0;
+	while (page_idx < nr_pages) {
+		struct pagevec pvec;
+		unsigned int i, added;
+
+		/* Insert the pages a pagevec at a time, then read them */
+		pagevec_init(&pvec);
+		while (page_idx < nr_pages && pagevec_space(&pvec)) {
+			struct page *page = lru_to_page(pages);
+
+			list_del(&page->lru);
+			pagevec_add(&pvec, page);
+			page_idx++;
+		}
+
+		i = 0;
+		while (i < pagevec_count(&pvec)) {
+			added = add_to_page_cache_lru_batch(mapping,
+					pvec.pages + i,
+					pagevec_count(&pvec) - i, gfp);
+			for (; added; added--, i++)
+				mapping->a_ops->readpage(filp, pvec.pages[i]);
+			/* Skip the page that could not be added, if any */
+			i++;
+		}
+
+		for (i = 0; i < pagevec_count(&pvec); i++)
+			put_page(pvec.pages[i]);
 	}
 	ret = 0;
 
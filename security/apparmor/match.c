@@ -12,15 +12,139 @@
 #include <linux/kernel.h>
 #include <linux/mm.h>
 #include <linux/slab.h>
+#include <linux/string.h>
 #include <linux/vmalloc.h>
 #include <linux/err.h>
 #include <linux/kref.h>
+#include <linux/jhash.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
 
+#include "include/apparmor.h"
 #include "include/lib.h"
 #include "include/match.h"
+#include "include/policy.h"
 
 #define base_idx(X) ((X) & 0xffffff)
 
+/*
+ * Path prefix cache
+ *
+ * Most path lookups share their leading directories (/usr/lib/, /proc/,
+ * /etc/...) and walking them through the dfa byte by byte is the bulk of
+ * the matching cost.  aa_dfa_match() remembers, per cpu, the state the
+ * dfa reached at the end of the directory part of a path, keyed by the
+ * dfa, the start state and the directory string itself, so the next path
+ * in the same directory only has to match its last component.
+ *
+ * Entries are only touched with preemption disabled; a match from
+ * interrupt context that lands on an entry being filled just misses, the
+ * same as a writer finding the entry busy (odd @seq).  A dfa that is
+ * freed bumps aa_dfa_gen so entries keyed by its address never match a
+ * later dfa allocated at the same address.
+ */
+#define PREFIX_CACHE_SLOTS	32
+#define PREFIX_CACHE_MIN	4
+#define PREFIX_CACHE_MAX	64
+
+struct prefix_cache_entry {
+	unsigned int seq;
+	unsigned int len;
+	u32 hash;
+	unsigned int start;
+	unsigned int state;
+	unsigned long gen;
+	struct aa_dfa *dfa;
+	char prefix[PREFIX_CACHE_MAX];
+};
+
+struct prefix_cache {
+	struct prefix_cache_entry entries[PREFIX_CACHE_SLOTS];
+	unsigned long hits;
+	unsigned long misses;
+};
+
+static DEFINE_PER_CPU(struct prefix_cache, aa_prefix_cache);
+static atomic_long_t aa_dfa_gen = ATOMIC_LONG_INIT(0);
+
+static bool prefix_cache_lookup(struct aa_dfa *dfa, unsigned int start,
+				const char *str, unsigned int len, u32 hash,
+				unsigned int *state)
+{
+	struct prefix_cache *pc = get_cpu_ptr(&aa_prefix_cache);
+	struct prefix_cache_entry *e = &pc->entries[hash % PREFIX_CACHE_SLOTS];
+	unsigned int seq = READ_ONCE(e->seq);
+	bool hit = false;
+
+	if (!(seq & 1)) {
+		barrier();
+		hit = e->dfa == dfa && e->start == start && e->hash == hash &&
+		      e->len == len && e->gen == atomic_long_read(&aa_dfa_gen) &&
+		      !memcmp(e->prefix, str, len);
+		*state = e->state;
+		barrier();
+		if (READ_ONCE(e->seq) != seq)
+			hit = false;
+	}
+	if (hit)
+		this_cpu_inc(aa_prefix_cache.hits);
+	else
+		this_cpu_inc(aa_prefix_cache.misses);
+	put_cpu_ptr(&aa_prefix_cache);
+
+	return hit;
+}
+
+static void prefix_cache_fill(struct aa_dfa *dfa, unsigned int start,
+			      const char *str, unsigned int len, u32 hash,
+			      unsigned int state)
+{
+	struct prefix_cache *pc = get_cpu_ptr(&aa_prefix_cache);
+	struct prefix_cache_entry *e = &pc->entries[hash % PREFIX_CACHE_SLOTS];
+
+	/* interrupted a fill of this entry on this cpu, leave it be */
+	if (e->seq & 1)
+		goto out;
+
+	WRITE_ONCE(e->seq, e->seq + 1);
+	barrier();
+	e->dfa = dfa;
+	e->start = start;
+	e->hash = hash;
+	e->len = len;
+	e->gen = atomic_long_read(&aa_dfa_gen);
+	e->state = state;
+	memcpy(e->prefix, str, len);
+	barrier();
+	WRITE_ONCE(e->seq, e->seq + 1);
+out:
+	put_cpu_ptr(&aa_prefix_cache);
+}
+
+/* expose the cache hit rate as a read only apparmor parameter */
+static int param_get_prefix_cache(char *buffer, const struct kernel_param *kp)
+{
+	unsigned long hits = 0, misses = 0;
+	int cpu;
+
+	if (!apparmor_enabled)
+		return -EINVAL;
+	if (apparmor_initialized && !policy_view_capable(NULL))
+		return -EPERM;
+
+	for_each_possible_cpu(cpu) {
+		hits += per_cpu(aa_prefix_cache, cpu).hits;
+		misses += per_cpu(aa_prefix_cache, cpu).misses;
+	}
+
+	return sprintf(buffer, "hits %lu misses %lu", hits, misses);
+}
+
+static const struct kernel_param_ops param_ops_prefix_cache = {
+	.get = param_get_prefix_cache
+};
+module_param_cb(dfa_prefix_cache, &param_ops_prefix_cache, NULL, S_IRUSR);
+
 static char nulldfa_src[] = {
 	#include "nulldfa.in"
 };
@@ -248,6 +372,10 @@ static void dfa_free(struct aa_dfa *dfa)
 	if (dfa) {
 		int i;
 
+		/* stale prefix cache entries must not match a reused address */
+		atomic_long_inc(&aa_dfa_gen);
+		smp_mb__after_atomic();
+
 		for (i = 0; i < ARRAY_SIZE(dfa->tables); i++) {
 			kvfree(dfa->tables[i]);
 			dfa->tables[i] = NULL;
@@ -425,20 +553,8 @@ unsigned int aa_dfa_match_len(struct aa_dfa *dfa, unsigned int start,
 	return state;
 }
 
-/**
- * aa_dfa_match - traverse @dfa to find state @str stops at
- * @dfa: the dfa to match @str against  (NOT NULL)
- * @start: the state of the dfa to start matching in
- * @str: the null terminated string of bytes to match against the dfa (NOT NULL)
- *
- * aa_dfa_match will match @str against the dfa and return the state it
- * finished matching in. The final state can be used to look up the accepting
- * label, or as the start state of a continuing match.
- *
- * Returns: final state reached after input is consumed
- */
-unsigned int aa_dfa_match(struct aa_dfa *dfa, unsigned int start,
-			  const char *str)
+static unsigned int dfa_match(struct aa_dfa *dfa, unsigned int start,
+			      const char *str)
 {
 	u16 *def = DEFAULT_TABLE(dfa);
 	u32 *base = BASE_TABLE(dfa);
@@ -466,6 +582,45 @@ unsigned int aa_dfa_match(struct aa_dfa *dfa, unsigned int start,
 	return state;
 }
 
+/**
+ * aa_dfa_match - traverse @dfa to find state @str stops at
+ * @dfa: the dfa to match @str against  (NOT NULL)
+ * @start: the state of the dfa to start matching in
+ * @str: the null terminated string of bytes to match against the dfa (NOT NULL)
+ *
+ * aa_dfa_match will match @str against the dfa and return the state it
+ * finished matching in. The final state can be used to look up the accepting
+ * label, or as the start state of a continuing match.
+ *
+ * For absolute paths the state reached after the directory part is taken
+ * from, or added to, the path prefix cache.
+ *
+ * Returns: final state reached after input is consumed
+ */
+unsigned int aa_dfa_match(struct aa_dfa *dfa, unsigned int start,
+			  const char *str)
+{
+	unsigned int len, state;
+	const char *last;
+	u32 hash;
+
+	if (start == 0 || str[0] != '/')
+		return dfa_match(dfa, start, str);
+
+	last = strrchr(str, '/');
+	len = last - str + 1;
+	if (len < PREFIX_CACHE_MIN || len > PREFIX_CACHE_MAX)
+		return dfa_match(dfa, start, str);
+
+	hash = jhash(str, len, start);
+	if (!prefix_cache_lookup(dfa, start, str, len, hash, &state)) {
+		state = aa_dfa_match_len(dfa, start, str, len);
+		prefix_cache_fill(dfa, start, str, len, hash, state);
+	}
+
+	return dfa_match(dfa, state, str + len);
+}
+
 /**
  * aa_dfa_next - step one character to the next state in the dfa
  * @dfa: the dfa to traverse (NOT NULL)
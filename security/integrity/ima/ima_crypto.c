@@ -15,6 +15,7 @@
 #include <linux/kernel.h>
 #include <linux/moduleparam.h>
 #include <linux/ratelimit.h>
+#include <linux/fadvise.h>
 #include <linux/file.h>
 #include <linux/crypto.h>
 #include <linux/scatterlist.h>
@@ -33,14 +34,27 @@ MODULE_PARM_DESC(ahash_minsize, "Minimum file size for ahash use");
 static int ima_maxorder;
 static unsigned int ima_bufsize = PAGE_SIZE;
 
-static int param_set_bufsize(const char *val, const struct kernel_param *kp)
+/* default is 64KiB, reading a page at a time spends more time in read() */
+#define IMA_READ_DEF_ORDER	(PAGE_SHIFT < 16 ? 16 - PAGE_SHIFT : 0)
+static int ima_read_maxorder = IMA_READ_DEF_ORDER;
+static unsigned int ima_read_bufsize = PAGE_SIZE << IMA_READ_DEF_ORDER;
+
+static int ima_parse_bufsize(const char *val, int *order)
 {
 	unsigned long long size;
-	int order;
 
 	size = memparse(val, NULL);
-	order = get_order(size);
-	if (order >= MAX_ORDER)
+	*order = get_order(size);
+	if (*order >= MAX_ORDER)
+		return -EINVAL;
+	return 0;
+}
+
+static int param_set_bufsize(const char *val, const struct kernel_param *kp)
+{
+	int order;
+
+	if (ima_parse_bufsize(val, &order))
 		return -EINVAL;
 	ima_maxorder = order;
 	ima_bufsize = PAGE_SIZE << order;
@@ -56,6 +70,32 @@ static const struct kernel_param_ops param_ops_bufsize = {
 module_param_named(ahash_bufsize, ima_bufsize, bufsize, 0644);
 MODULE_PARM_DESC(ahash_bufsize, "Maximum ahash buffer size");
 
+static int param_set_read_bufsize(const char *val,
+				  const struct kernel_param *kp)
+{
+	int order;
+
+	if (ima_parse_bufsize(val, &order))
+		return -EINVAL;
+	ima_read_maxorder = order;
+	ima_read_bufsize = PAGE_SIZE << order;
+	return 0;
+}
+
+static const struct kernel_param_ops param_ops_read_bufsize = {
+	.set = param_set_read_bufsize,
+	.get = param_get_uint,
+};
+#define param_check_read_bufsize(name, p) __param_check(name, p, unsigned int)
+
+module_param_named(read_bufsize, ima_read_bufsize, read_bufsize, 0644);
+MODULE_PARM_DESC(read_bufsize, "Maximum shash read buffer size");
+
+/* number of read buffers worth of file data to keep in flight ahead */
+static unsigned int ima_readahead_bufs = 4;
+module_param_named(readahead_bufs, ima_readahead_bufs, uint, 0644);
+MODULE_PARM_DESC(readahead_bufs, "Read buffers to read ahead while hashing");
+
 static struct crypto_shash *ima_shash_tfm;
 static struct crypto_ahash *ima_ahash_tfm;
 
@@ -105,21 +145,21 @@ static void ima_free_tfm(struct crypto_shash *tfm)
  * @max_size:       Maximum amount of memory to allocate.
  * @allocated_size: Returned size of actual allocation.
  * @last_warn:      Should the min_size allocation warn or not.
+ * @order:          Largest allocation order to try.
  *
  * Tries to do opportunistic allocation for memory first trying to allocate
  * max_size amount of memory and then splitting that until zero order is
  * reached. Allocation is tried without generating allocation warnings unless
  * last_warn is set. Last_warn set affects only last allocation of zero order.
  *
- * By default, ima_maxorder is 0 and it is equivalent to kmalloc(GFP_KERNEL)
+ * With an order of 0 it is equivalent to kmalloc(GFP_KERNEL)
  *
  * Return pointer to allocated memory, or NULL on failure.
  */
 static void *ima_alloc_pages(loff_t max_size, size_t *allocated_size,
-			     int last_warn)
+			     int last_warn, int order)
 {
 	void *ptr;
-	int order = ima_maxorder;
 	gfp_t gfp_mask = __GFP_RECLAIM | __GFP_NOWARN | __GFP_NORETRY;
 
 	if (order)
@@ -201,11 +241,39 @@ static inline int ahash_wait(int err, struct crypto_wait *wait)
 	return err;
 }
 
+/**
+ * ima_readahead() - Start reading the file data following the next read.
+ * @file:     File being hashed.
+ * @offset:   Offset of the next read.
+ * @i_size:   Size of the file.
+ * @bufsize:  Size of the reads.
+ * @ra_end:   End of the range already read ahead, updated.
+ *
+ * Hashing a cold file otherwise waits for each chunk to be read in turn.
+ * Asking for ima.readahead_bufs buffers ahead lets the I/O for the rest
+ * of the file proceed while the current chunk is hashed.  Only called
+ * when half of the window has been consumed, to keep the calls few.
+ */
+static void ima_readahead(struct file *file, loff_t offset, loff_t i_size,
+			  size_t bufsize, loff_t *ra_end)
+{
+	loff_t window = (loff_t)bufsize * ima_readahead_bufs;
+	loff_t start, end;
+
+	if (!window || *ra_end >= i_size || offset + window / 2 < *ra_end)
+		return;
+
+	start = max(*ra_end, offset);
+	end = min(offset + window, i_size);
+	vfs_fadvise(file, start, end - start, POSIX_FADV_WILLNEED);
+	*ra_end = end;
+}
+
 static int ima_calc_file_hash_atfm(struct file *file,
 				   struct ima_digest_data *hash,
 				   struct crypto_ahash *tfm)
 {
-	loff_t i_size, offset;
+	loff_t i_size, offset, ra_end = 0;
 	char *rbuf[2] = { NULL, };
 	int rc, rbuf_len, active = 0, ahash_rc = 0;
 	struct ahash_request *req;
@@ -237,7 +305,7 @@ static int ima_calc_file_hash_atfm(struct file *file,
 	 * Try to allocate maximum size of memory.
 	 * Fail if even a single page cannot be allocated.
 	 */
-	rbuf[0] = ima_alloc_pages(i_size, &rbuf_size[0], 1);
+	rbuf[0] = ima_alloc_pages(i_size, &rbuf_size[0], 1, ima_maxorder);
 	if (!rbuf[0]) {
 		rc = -ENOMEM;
 		goto out1;
@@ -251,7 +319,7 @@ static int ima_calc_file_hash_atfm(struct file *file,
 		 * as baseline for possible allocation size.
 		 */
 		rbuf[1] = ima_alloc_pages(i_size - rbuf_size[0],
-					  &rbuf_size[1], 0);
+					  &rbuf_size[1], 0, ima_maxorder);
 	}
 
 	for (offset = 0; offset < i_size; offset += rbuf_len) {
@@ -266,6 +334,7 @@ static int ima_calc_file_hash_atfm(struct file *file,
 		}
 		/* read buffer */
 		rbuf_len = min_t(loff_t, i_size - offset, rbuf_size[active]);
+		ima_readahead(file, offset, i_size, rbuf_size[active], &ra_end);
 		rc = integrity_kernel_read(file, offset, rbuf[active],
 					   rbuf_len);
 		if (rc != rbuf_len)
@@ -324,7 +393,8 @@ static int ima_calc_file_hash_tfm(struct file *file,
 				  struct ima_digest_data *hash,
 				  struct crypto_shash *tfm)
 {
-	loff_t i_size, offset = 0;
+	loff_t i_size, offset = 0, ra_end = 0;
+	size_t rbuf_size;
 	char *rbuf;
 	int rc;
 	SHASH_DESC_ON_STACK(shash, tfm);
@@ -342,14 +412,15 @@ static int ima_calc_file_hash_tfm(struct file *file,
 	if (i_size == 0)
 		goto out;
 
-	rbuf = kzalloc(PAGE_SIZE, GFP_KERNEL);
+	rbuf = ima_alloc_pages(i_size, &rbuf_size, 1, ima_read_maxorder);
 	if (!rbuf)
 		return -ENOMEM;
 
 	while (offset < i_size) {
 		int rbuf_len;
 
-		rbuf_len = integrity_kernel_read(file, offset, rbuf, PAGE_SIZE);
+		ima_readahead(file, offset, i_size, rbuf_size, &ra_end);
+		rbuf_len = integrity_kernel_read(file, offset, rbuf, rbuf_size);
 		if (rbuf_len < 0) {
 			rc = rbuf_len;
 			break;
@@ -362,7 +433,7 @@ static int ima_calc_file_hash_tfm(struct file *file,
 		if (rc)
 			break;
 	}
-	kfree(rbuf);
+	ima_free_pages(rbuf, rbuf_size);
 out:
 	if (!rc)
 		rc = crypto_shash_final(shash, hash->digest);
@@ -20,6 +20,10 @@
 #include <linux/skbuff.h>
 #include <linux/percpu.h>
 #include <linux/list.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
 #include <net/sock.h>
 #include <linux/un.h>
 #include <net/af_unix.h>
@@ -31,14 +35,18 @@
 #include "avc_ss.h"
 #include "classmap.h"
 
-#define AVC_CACHE_SLOTS			512
-#define AVC_DEF_CACHE_THRESHOLD		512
+#define AVC_CACHE_MIN_SLOTS		512
+#define AVC_CACHE_MAX_SLOTS		(1 << 16)
+#define AVC_DEF_CACHE_THRESHOLD		2048
 #define AVC_CACHE_RECLAIM		16
+#define AVC_PCPU_SLOTS			16
 
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
 #define avc_cache_stats_incr(field)	this_cpu_inc(avc_cache_stats.field)
+#define avc_cache_stats_add(field, n)	this_cpu_add(avc_cache_stats.field, n)
 #else
 #define avc_cache_stats_incr(field)	do {} while (0)
+#define avc_cache_stats_add(field, n)	do {} while (0)
 #endif
 
 struct avc_entry {
@@ -51,7 +59,7 @@ struct avc_entry {
 
 struct avc_node {
 	struct avc_entry	ae;
-	struct hlist_node	list; /* anchored in avc_cache->slots[i] */
+	struct hlist_node	list; /* anchored in avc_slot->head */
 	struct rcu_head		rhead;
 };
 
@@ -65,14 +73,53 @@ struct avc_xperms_node {
 	struct list_head xpd_head; /* list head of extended_perms_decision */
 };
 
+struct avc_slot {
+	struct hlist_head	head; /* head for avc_node->list */
+	spinlock_t		lock; /* lock for writes */
+};
+
+/*
+ * The hash table is replaced as a whole when it is resized: the nodes in
+ * the old table are dropped rather than moved, the AVC is only a cache.
+ * Writers recheck avc_cache->table under the slot lock so they never add
+ * to a table that has already been emptied.
+ */
+struct avc_table {
+	unsigned int		size; /* power of two */
+	struct rcu_head		rhead;
+	struct avc_slot		slots[];
+};
+
 struct avc_cache {
-	struct hlist_head	slots[AVC_CACHE_SLOTS]; /* head for avc_node->list */
-	spinlock_t		slots_lock[AVC_CACHE_SLOTS]; /* lock for writes */
+	struct avc_table __rcu	*table;
+	struct mutex		resize_lock;
 	atomic_t		lru_hint;	/* LRU hint for reclaim scan */
 	atomic_t		active_nodes;
+	atomic64_t		gen;		/* bumped when a node goes away */
 	u32			latest_notif;	/* latest revocation notification */
 };
 
+/*
+ * Small direct-mapped per-CPU cache in front of the hash table, so that
+ * repeated checks of the same triple skip the hash chain walk.  An entry
+ * is only valid while avc_cache->gen still has the value it was filled
+ * with: every node removal bumps it before the node is freed by RCU, so a
+ * node found through a valid entry cannot have been freed yet.
+ */
+struct avc_pcpu_entry {
+	u32			ssid;
+	u32			tsid;
+	u16			tclass;
+	u64			gen;
+	struct avc_node		*node;
+};
+
+struct avc_pcpu_cache {
+	struct avc_pcpu_entry	entries[AVC_PCPU_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct avc_pcpu_cache, avc_pcpu_cache);
+
 struct avc_callback_node {
 	int (*callback) (u32 event);
 	u32 events;
@@ -81,6 +128,24 @@ struct avc_callback_node {
 
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
 DEFINE_PER_CPU(struct avc_cache_stats, avc_cache_stats) = { 0 };
+
+/*
+ * Lookups that had to go to the security server, by class.  Class values
+ * start at 1, secclass_map[] is indexed by the class value minus one.
+ */
+struct avc_class_stats {
+	unsigned int misses[ARRAY_SIZE(secclass_map) + 1];
+};
+
+static DEFINE_PER_CPU(struct avc_class_stats, avc_class_stats);
+
+static inline void avc_class_stats_miss(u16 tclass)
+{
+	if (tclass <= ARRAY_SIZE(secclass_map))
+		this_cpu_inc(avc_class_stats.misses[tclass]);
+}
+#else
+static inline void avc_class_stats_miss(u16 tclass) { }
 #endif
 
 struct selinux_avc {
@@ -90,17 +155,49 @@ struct selinux_avc {
 
 static struct selinux_avc selinux_avc;
 
+static unsigned int avc_table_size(unsigned int cache_threshold)
+{
+	cache_threshold = clamp_t(unsigned int, cache_threshold,
+				  AVC_CACHE_MIN_SLOTS, AVC_CACHE_MAX_SLOTS);
+	return roundup_pow_of_two(cache_threshold);
+}
+
+static struct avc_table *avc_table_alloc(unsigned int size)
+{
+	struct avc_table *tbl;
+	unsigned int i;
+
+	tbl = kvzalloc(struct_size(tbl, slots, size), GFP_KERNEL);
+	if (!tbl)
+		return NULL;
+
+	tbl->size = size;
+	for (i = 0; i < size; i++) {
+		INIT_HLIST_HEAD(&tbl->slots[i].head);
+		spin_lock_init(&tbl->slots[i].lock);
+	}
+
+	return tbl;
+}
+
+static void avc_table_free_rcu(struct rcu_head *rhead)
+{
+	kvfree(container_of(rhead, struct avc_table, rhead));
+}
+
 void selinux_avc_init(struct selinux_avc **avc)
 {
-	int i;
+	struct avc_table *tbl;
 
 	selinux_avc.avc_cache_threshold = AVC_DEF_CACHE_THRESHOLD;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
-		INIT_HLIST_HEAD(&selinux_avc.avc_cache.slots[i]);
-		spin_lock_init(&selinux_avc.avc_cache.slots_lock[i]);
-	}
+	tbl = avc_table_alloc(avc_table_size(AVC_DEF_CACHE_THRESHOLD));
+	if (!tbl)
+		panic("SELinux: unable to allocate the AVC\n");
+	RCU_INIT_POINTER(selinux_avc.avc_cache.table, tbl);
+	mutex_init(&selinux_avc.avc_cache.resize_lock);
 	atomic_set(&selinux_avc.avc_cache.active_nodes, 0);
 	atomic_set(&selinux_avc.avc_cache.lru_hint, 0);
+	atomic64_set(&selinux_avc.avc_cache.gen, 0);
 	*avc = &selinux_avc;
 }
 
@@ -109,10 +206,40 @@ unsigned int avc_get_cache_threshold(struct selinux_avc *avc)
 	return avc->avc_cache_threshold;
 }
 
-void avc_set_cache_threshold(struct selinux_avc *avc,
-			     unsigned int cache_threshold)
+static void avc_flush_table(struct selinux_avc *avc, struct avc_table *tbl);
+
+/**
+ * avc_set_cache_threshold - Set the number of entries the AVC may hold
+ * @avc: the AVC
+ * @cache_threshold: new number of entries
+ *
+ * The hash table is resized to keep its chains short at the new
+ * threshold, dropping all cached decisions if its size changes.
+ */
+int avc_set_cache_threshold(struct selinux_avc *avc,
+			    unsigned int cache_threshold)
 {
+	struct avc_cache *cache = &avc->avc_cache;
+	struct avc_table *old, *new;
+	unsigned int size = avc_table_size(cache_threshold);
+
+	mutex_lock(&cache->resize_lock);
+	old = rcu_dereference_protected(cache->table,
+					lockdep_is_held(&cache->resize_lock));
+	if (size != old->size) {
+		new = avc_table_alloc(size);
+		if (!new) {
+			mutex_unlock(&cache->resize_lock);
+			return -ENOMEM;
+		}
+		rcu_assign_pointer(cache->table, new);
+		avc_flush_table(avc, old);
+		call_rcu(&old->rhead, avc_table_free_rcu);
+	}
 	avc->avc_cache_threshold = cache_threshold;
+	mutex_unlock(&cache->resize_lock);
+
+	return 0;
 }
 
 static struct avc_callback_node *avc_callbacks;
@@ -121,9 +248,14 @@ static struct kmem_cache *avc_xperms_data_cachep;
 static struct kmem_cache *avc_xperms_decision_cachep;
 static struct kmem_cache *avc_xperms_cachep;
 
-static inline int avc_hash(u32 ssid, u32 tsid, u16 tclass)
+static inline u32 avc_hash(u32 ssid, u32 tsid, u16 tclass)
+{
+	return jhash_3words(ssid, tsid, tclass, 0);
+}
+
+static inline struct avc_slot *avc_hash_slot(struct avc_table *tbl, u32 hash)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	return &tbl->slots[hash & (tbl->size - 1)];
 }
 
 /**
@@ -149,16 +281,19 @@ void __init avc_init(void)
 
 int avc_get_hash_stats(struct selinux_avc *avc, char *page)
 {
-	int i, chain_len, max_chain_len, slots_used;
+	int i, chain_len, max_chain_len, slots_used, size;
+	struct avc_table *tbl;
 	struct avc_node *node;
 	struct hlist_head *head;
 
 	rcu_read_lock();
 
+	tbl = rcu_dereference(avc->avc_cache.table);
+	size = tbl->size;
 	slots_used = 0;
 	max_chain_len = 0;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
-		head = &avc->avc_cache.slots[i];
+	for (i = 0; i < size; i++) {
+		head = &tbl->slots[i].head;
 		if (!hlist_empty(head)) {
 			slots_used++;
 			chain_len = 0;
@@ -174,8 +309,29 @@ int avc_get_hash_stats(struct selinux_avc *avc, char *page)
 	return scnprintf(page, PAGE_SIZE, "entries: %d\nbuckets used: %d/%d\n"
 			 "longest chain: %d\n",
 			 atomic_read(&avc->avc_cache.active_nodes),
-			 slots_used, AVC_CACHE_SLOTS, max_chain_len);
+			 slots_used, size, max_chain_len);
+}
+
+#ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
+int avc_get_class_stats(struct selinux_avc *avc, char *page)
+{
+	unsigned int misses;
+	int len = 0;
+	int cpu;
+	u16 i;
+
+	for (i = 1; i <= ARRAY_SIZE(secclass_map); i++) {
+		misses = 0;
+		for_each_possible_cpu(cpu)
+			misses += per_cpu(avc_class_stats, cpu).misses[i];
+		if (misses)
+			len += scnprintf(page + len, PAGE_SIZE - len, "%s %u\n",
+					 secclass_map[i - 1].name, misses);
+	}
+
+	return len;
 }
+#endif
 
 /*
  * using a linked list for extended_perms_decision lookup because the list is
@@ -435,9 +591,20 @@ static void avc_node_free(struct rcu_head *rhead)
 	avc_cache_stats_incr(frees);
 }
 
+/*
+ * Invalidate the per-CPU caches before a node that may be referenced from
+ * them is handed to RCU.  Pairs with the barrier in avc_pcpu_fill().
+ */
+static inline void avc_cache_gen_bump(struct selinux_avc *avc)
+{
+	smp_mb__before_atomic();
+	atomic64_inc(&avc->avc_cache.gen);
+}
+
 static void avc_node_delete(struct selinux_avc *avc, struct avc_node *node)
 {
 	hlist_del_rcu(&node->list);
+	avc_cache_gen_bump(avc);
 	call_rcu(&node->rhead, avc_node_free);
 	atomic_dec(&avc->avc_cache.active_nodes);
 }
@@ -454,6 +621,7 @@ static void avc_node_replace(struct selinux_avc *avc,
 			     struct avc_node *new, struct avc_node *old)
 {
 	hlist_replace_rcu(&old->list, &new->list);
+	avc_cache_gen_bump(avc);
 	call_rcu(&old->rhead, avc_node_free);
 	atomic_dec(&avc->avc_cache.active_nodes);
 }
@@ -461,38 +629,43 @@ static void avc_node_replace(struct selinux_avc *avc,
 static inline int avc_reclaim_node(struct selinux_avc *avc)
 {
 	struct avc_node *node;
+	struct avc_table *tbl;
 	int hvalue, try, ecx;
 	unsigned long flags;
-	struct hlist_head *head;
-	spinlock_t *lock;
+	struct avc_slot *slot;
 
-	for (try = 0, ecx = 0; try < AVC_CACHE_SLOTS; try++) {
+	tbl = rcu_dereference(avc->avc_cache.table);
+	for (try = 0, ecx = 0; try < tbl->size; try++) {
 		hvalue = atomic_inc_return(&avc->avc_cache.lru_hint) &
-			(AVC_CACHE_SLOTS - 1);
-		head = &avc->avc_cache.slots[hvalue];
-		lock = &avc->avc_cache.slots_lock[hvalue];
+			(tbl->size - 1);
+		slot = &tbl->slots[hvalue];
 
-		if (!spin_trylock_irqsave(lock, flags))
+		if (!spin_trylock_irqsave(&slot->lock, flags))
 			continue;
 
 		rcu_read_lock();
-		hlist_for_each_entry(node, head, list) {
+		hlist_for_each_entry(node, &slot->head, list) {
 			avc_node_delete(avc, node);
 			avc_cache_stats_incr(reclaims);
 			ecx++;
 			if (ecx >= AVC_CACHE_RECLAIM) {
 				rcu_read_unlock();
-				spin_unlock_irqrestore(lock, flags);
+				spin_unlock_irqrestore(&slot->lock, flags);
 				goto out;
 			}
 		}
 		rcu_read_unlock();
-		spin_unlock_irqrestore(lock, flags);
+		spin_unlock_irqrestore(&slot->lock, flags);
 	}
 out:
+	avc_cache_stats_add(reclaim_scans, min(try + 1, (int)tbl->size));
 	return ecx;
 }
 
+/*
+ * Called with the RCU read lock held, which keeps the table that
+ * avc_reclaim_node() scans from being freed.
+ */
 static struct avc_node *avc_alloc_node(struct selinux_avc *avc)
 {
 	struct avc_node *node;
@@ -521,14 +694,13 @@ static void avc_node_populate(struct avc_node *node, u32 ssid, u32 tsid, u16 tcl
 }
 
 static inline struct avc_node *avc_search_node(struct selinux_avc *avc,
-					       u32 ssid, u32 tsid, u16 tclass)
+					       u32 ssid, u32 tsid, u16 tclass,
+					       u32 hash)
 {
 	struct avc_node *node, *ret = NULL;
-	int hvalue;
 	struct hlist_head *head;
 
-	hvalue = avc_hash(ssid, tsid, tclass);
-	head = &avc->avc_cache.slots[hvalue];
+	head = &avc_hash_slot(rcu_dereference(avc->avc_cache.table), hash)->head;
 	hlist_for_each_entry_rcu(node, head, list) {
 		if (ssid == node->ae.ssid &&
 		    tclass == node->ae.tclass &&
@@ -541,6 +713,53 @@ static inline struct avc_node *avc_search_node(struct selinux_avc *avc,
 	return ret;
 }
 
+/*
+ * The per-CPU entries are only touched with preemption disabled, but
+ * checks also run from softirq context and may interrupt a fill or a
+ * lookup on the same CPU.  A fill clears ->node first and sets it last;
+ * a lookup rereads ->node after checking the key, so it never pairs the
+ * node of one fill with the key or generation of another.
+ */
+static inline struct avc_node *avc_pcpu_lookup(struct selinux_avc *avc,
+					       u32 ssid, u32 tsid, u16 tclass,
+					       u32 hash)
+{
+	struct avc_pcpu_entry *e;
+	struct avc_node *node;
+
+	e = &get_cpu_ptr(&avc_pcpu_cache)->entries[hash % AVC_PCPU_SLOTS];
+	node = READ_ONCE(e->node);
+	if (node) {
+		barrier();
+		if (e->ssid != ssid || e->tsid != tsid ||
+		    e->tclass != tclass ||
+		    e->gen != atomic64_read(&avc->avc_cache.gen))
+			node = NULL;
+		barrier();
+		if (READ_ONCE(e->node) != node)
+			node = NULL;
+	}
+	put_cpu_ptr(&avc_pcpu_cache);
+
+	return node;
+}
+
+static inline void avc_pcpu_fill(struct avc_node *node, u64 gen, u32 hash)
+{
+	struct avc_pcpu_entry *e;
+
+	e = &get_cpu_ptr(&avc_pcpu_cache)->entries[hash % AVC_PCPU_SLOTS];
+	WRITE_ONCE(e->node, NULL);
+	barrier();
+	e->ssid = node->ae.ssid;
+	e->tsid = node->ae.tsid;
+	e->tclass = node->ae.tclass;
+	e->gen = gen;
+	barrier();
+	WRITE_ONCE(e->node, node);
+	put_cpu_ptr(&avc_pcpu_cache);
+}
+
 /**
  * avc_lookup - Look up an AVC entry.
  * @ssid: source security identifier
@@ -557,14 +776,32 @@ static struct avc_node *avc_lookup(struct selinux_avc *avc,
 				   u32 ssid, u32 tsid, u16 tclass)
 {
 	struct avc_node *node;
+	u32 hash = avc_hash(ssid, tsid, tclass);
+	u64 gen;
 
 	avc_cache_stats_incr(lookups);
-	node = avc_search_node(avc, ssid, tsid, tclass);
+	node = avc_pcpu_lookup(avc, ssid, tsid, tclass, hash);
+	if (node) {
+		avc_cache_stats_incr(pcpu_hits);
+		return node;
+	}
 
-	if (node)
+	/*
+	 * Sample the generation before searching: if the node found is
+	 * removed afterwards, the per-CPU entry is already stale.  Pairs
+	 * with the barrier in avc_cache_gen_bump().
+	 */
+	gen = atomic64_read(&avc->avc_cache.gen);
+	smp_rmb();
+	node = avc_search_node(avc, ssid, tsid, tclass, hash);
+
+	if (node) {
+		avc_pcpu_fill(node, gen, hash);
 		return node;
+	}
 
 	avc_cache_stats_incr(misses);
+	avc_class_stats_miss(tclass);
 	return NULL;
 }
 
@@ -615,7 +852,6 @@ static struct avc_node *avc_insert(struct selinux_avc *avc,
 				   struct avc_xperms_node *xp_node)
 {
 	struct avc_node *pos, *node = NULL;
-	int hvalue;
 	unsigned long flag;
 
 	if (avc_latest_notif_update(avc, avd->seqno, 1))
@@ -623,22 +859,27 @@ static struct avc_node *avc_insert(struct selinux_avc *avc,
 
 	node = avc_alloc_node(avc);
 	if (node) {
-		struct hlist_head *head;
-		spinlock_t *lock;
+		struct avc_table *tbl;
+		struct avc_slot *slot;
 		int rc = 0;
 
-		hvalue = avc_hash(ssid, tsid, tclass);
 		avc_node_populate(node, ssid, tsid, tclass, avd);
 		rc = avc_xperms_populate(node, xp_node);
 		if (rc) {
 			kmem_cache_free(avc_node_cachep, node);
 			return NULL;
 		}
-		head = &avc->avc_cache.slots[hvalue];
-		lock = &avc->avc_cache.slots_lock[hvalue];
-
-		spin_lock_irqsave(lock, flag);
-		hlist_for_each_entry(pos, head, list) {
+		tbl = rcu_dereference(avc->avc_cache.table);
+		slot = avc_hash_slot(tbl, avc_hash(ssid, tsid, tclass));
+
+		spin_lock_irqsave(&slot->lock, flag);
+		if (unlikely(rcu_access_pointer(avc->avc_cache.table) != tbl)) {
+			/* Resized under us: the decision is still returned. */
+			avc_node_kill(avc, node);
+			node = NULL;
+			goto found;
+		}
+		hlist_for_each_entry(pos, &slot->head, list) {
 			if (pos->ae.ssid == ssid &&
 			    pos->ae.tsid == tsid &&
 			    pos->ae.tclass == tclass) {
@@ -646,9 +887,9 @@ static struct avc_node *avc_insert(struct selinux_avc *avc,
 				goto found;
 			}
 		}
-		hlist_add_head_rcu(&node->list, head);
+		hlist_add_head_rcu(&node->list, &slot->head);
 found:
-		spin_unlock_irqrestore(lock, flag);
+		spin_unlock_irqrestore(&slot->lock, flag);
 	}
 out:
 	return node;
@@ -846,11 +1087,11 @@ static int avc_update_node(struct selinux_avc *avc,
 			   struct extended_perms_decision *xpd,
 			   u32 flags)
 {
-	int hvalue, rc = 0;
+	int rc = 0;
 	unsigned long flag;
 	struct avc_node *pos, *node, *orig = NULL;
-	struct hlist_head *head;
-	spinlock_t *lock;
+	struct avc_table *tbl;
+	struct avc_slot *slot;
 
 	/*
 	 * If we are in a non-blocking code path, e.g. VFS RCU walk,
@@ -875,14 +1116,20 @@ static int avc_update_node(struct selinux_avc *avc,
 	}
 
 	/* Lock the target slot */
-	hvalue = avc_hash(ssid, tsid, tclass);
+	rcu_read_lock();
+	tbl = rcu_dereference(avc->avc_cache.table);
+	slot = avc_hash_slot(tbl, avc_hash(ssid, tsid, tclass));
 
-	head = &avc->avc_cache.slots[hvalue];
-	lock = &avc->avc_cache.slots_lock[hvalue];
+	spin_lock_irqsave(&slot->lock, flag);
 
-	spin_lock_irqsave(lock, flag);
+	/* A resize has emptied the table, there is nothing to update */
+	if (unlikely(rcu_access_pointer(avc->avc_cache.table) != tbl)) {
+		rc = -ENOENT;
+		avc_node_kill(avc, node);
+		goto out_unlock;
+	}
 
-	hlist_for_each_entry(pos, head, list) {
+	hlist_for_each_entry(pos, &slot->head, list) {
 		if (ssid == pos->ae.ssid &&
 		    tsid == pos->ae.tsid &&
 		    tclass == pos->ae.tclass &&
@@ -940,39 +1187,45 @@ static int avc_update_node(struct selinux_avc *avc,
 	}
 	avc_node_replace(avc, node, orig);
 out_unlock:
-	spin_unlock_irqrestore(lock, flag);
+	spin_unlock_irqrestore(&slot->lock, flag);
+	rcu_read_unlock();
 out:
 	return rc;
 }
 
-/**
- * avc_flush - Flush the cache
- */
-static void avc_flush(struct selinux_avc *avc)
+static void avc_flush_table(struct selinux_avc *avc, struct avc_table *tbl)
 {
-	struct hlist_head *head;
+	struct avc_slot *slot;
 	struct avc_node *node;
-	spinlock_t *lock;
 	unsigned long flag;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
-		head = &avc->avc_cache.slots[i];
-		lock = &avc->avc_cache.slots_lock[i];
+	for (i = 0; i < tbl->size; i++) {
+		slot = &tbl->slots[i];
 
-		spin_lock_irqsave(lock, flag);
+		spin_lock_irqsave(&slot->lock, flag);
 		/*
 		 * With preemptable RCU, the outer spinlock does not
 		 * prevent RCU grace periods from ending.
 		 */
 		rcu_read_lock();
-		hlist_for_each_entry(node, head, list)
+		hlist_for_each_entry(node, &slot->head, list)
 			avc_node_delete(avc, node);
 		rcu_read_unlock();
-		spin_unlock_irqrestore(lock, flag);
+		spin_unlock_irqrestore(&slot->lock, flag);
 	}
 }
 
+/**
+ * avc_flush - Flush the cache
+ */
+static void avc_flush(struct selinux_avc *avc)
+{
+	rcu_read_lock();
+	avc_flush_table(avc, rcu_dereference(avc->avc_cache.table));
+	rcu_read_unlock();
+}
+
 /**
  * avc_ss_reset - Flush the cache and revalidate migrated permissions.
  * @seqno: policy sequence number
@@ -1099,6 +1352,17 @@ int avc_has_extended_perms(struct selinux_state *state,
 		avc_update_node(state->avc, AVC_CALLBACK_ADD_XPERMS, requested,
 				driver, xperm, ssid, tsid, tclass, avd.seqno,
 				&local_xpd, 0);
+	} else if (!(requested & ~avd.allowed) &&
+		   avc_xperms_has_perm(xpd, xperm, XPERMS_ALLOWED) &&
+		   !avc_xperms_audit_required(requested, &avd, xpd, xperm, 0,
+					      &denied)) {
+		/*
+		 * Granted and nothing to audit, which is what almost every
+		 * ioctl check ends up as: decide straight from the cached
+		 * decision without copying it out.
+		 */
+		rcu_read_unlock();
+		return 0;
 	} else {
 		avc_quick_copy_xperms_decision(xperm, &local_xpd, xpd);
 	}
@@ -39,6 +39,8 @@ struct avc_cache_stats {
 	unsigned int allocations;
 	unsigned int reclaims;
 	unsigned int frees;
+	unsigned int pcpu_hits;		/* hits in the per-CPU lookaside */
+	unsigned int reclaim_scans;	/* hash slots visited by reclaim */
 };
 
 /*
@@ -177,8 +179,11 @@ int avc_add_callback(int (*callback)(u32 event), u32 events);
 struct selinux_avc;
 int avc_get_hash_stats(struct selinux_avc *avc, char *page);
 unsigned int avc_get_cache_threshold(struct selinux_avc *avc);
-void avc_set_cache_threshold(struct selinux_avc *avc,
-			     unsigned int cache_threshold);
+int avc_set_cache_threshold(struct selinux_avc *avc,
+			    unsigned int cache_threshold);
+#ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
+int avc_get_class_stats(struct selinux_avc *avc, char *page);
+#endif
 
 /* Attempt to free avc node cache */
 void avc_disable(void);
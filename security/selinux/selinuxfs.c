@@ -1458,7 +1458,9 @@ static ssize_t sel_write_avc_cache_threshold(struct file *file,
 	if (sscanf(page, "%u", &new_value) != 1)
 		goto out;
 
-	avc_set_cache_threshold(state->avc, new_value);
+	ret = avc_set_cache_threshold(state->avc, new_value);
+	if (ret)
+		goto out;
 
 	ret = count;
 out:
@@ -1532,14 +1534,16 @@ static int sel_avc_stats_seq_show(struct seq_file *seq, void *v)
 
 	if (v == SEQ_START_TOKEN) {
 		seq_puts(seq,
-			 "lookups hits misses allocations reclaims frees\n");
+			 "lookups hits misses allocations reclaims frees "
+			 "pcpu_hits reclaim_scans\n");
 	} else {
 		unsigned int lookups = st->lookups;
 		unsigned int misses = st->misses;
 		unsigned int hits = lookups - misses;
-		seq_printf(seq, "%u %u %u %u %u %u\n", lookups,
+		seq_printf(seq, "%u %u %u %u %u %u %u %u\n", lookups,
 			   hits, misses, st->allocations,
-			   st->reclaims, st->frees);
+			   st->reclaims, st->frees,
+			   st->pcpu_hits, st->reclaim_scans);
 	}
 	return 0;
 }
@@ -1565,6 +1569,31 @@ static const struct file_operations sel_avc_cache_stats_ops = {
 	.llseek		= seq_lseek,
 	.release	= seq_release,
 };
+
+static ssize_t sel_read_avc_class_stats(struct file *filp, char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct selinux_fs_info *fsi = file_inode(filp)->i_sb->s_fs_info;
+	struct selinux_state *state = fsi->state;
+	char *page;
+	ssize_t length;
+
+	page = (char *)__get_free_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	length = avc_get_class_stats(state->avc, page);
+	if (length >= 0)
+		length = simple_read_from_buffer(buf, count, ppos, page, length);
+	free_page((unsigned long)page);
+
+	return length;
+}
+
+static const struct file_operations sel_avc_class_stats_ops = {
+	.read		= sel_read_avc_class_stats,
+	.llseek		= generic_file_llseek,
+};
 #endif
 
 static int sel_make_avc_files(struct dentry *dir)
@@ -1578,6 +1607,7 @@ static int sel_make_avc_files(struct dentry *dir)
 		{ "hash_stats", &sel_avc_hash_stats_ops, S_IRUGO },
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
 		{ "cache_stats", &sel_avc_cache_stats_ops, S_IRUGO },
+		{ "class_stats", &sel_avc_class_stats_ops, S_IRUGO },
 #endif
 	};
 
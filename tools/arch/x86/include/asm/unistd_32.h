@@ -14,3 +14,21 @@
 #ifndef __NR_setns
 # define __NR_setns 346
 #endif
+#ifndef __NR_io_setup
+# define __NR_io_setup 245
+#endif
+#ifndef __NR_io_destroy
+# define __NR_io_destroy 246
+#endif
+#ifndef __NR_io_getevents
+# define __NR_io_getevents 247
+#endif
+#ifndef __NR_io_submit
+# define __NR_io_submit 248
+#endif
+#ifndef __NR_io_uring_setup
+# define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+# define __NR_io_uring_enter 426
+#endif
@@ -41,6 +41,18 @@ int bench_futex_lock_pi(int argc, const char **argv);
 int bench_epoll_wait(int argc, const char **argv);
 int bench_epoll_ctl(int argc, const char **argv);
 
+int bench_mm_page_fault(int argc, const char **argv);
+int bench_mm_thp(int argc, const char **argv);
+int bench_mm_mmap(int argc, const char **argv);
+
+int bench_io_sync(int argc, const char **argv);
+int bench_io_aio(int argc, const char **argv);
+int bench_io_uring(int argc, const char **argv);
+
+int bench_net_tcp_rr(int argc, const char **argv);
+int bench_net_udp_rr(int argc, const char **argv);
+int bench_net_tcp_stream(int argc, const char **argv);
+
 #define BENCH_FORMAT_DEFAULT_STR	"default"
 #define BENCH_FORMAT_DEFAULT		0
 #define BENCH_FORMAT_SIMPLE_STR		"simple"
@@ -0,0 +1,620 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * io-rw.c
+ *
+ * sync: Measure block I/O throughput with threads issuing pread()/pwrite()
+ * one block at a time.
+ *
+ * aio: The same through Linux native AIO, each thread keeping a fixed
+ * queue depth of requests in flight.
+ *
+ * io_uring: The same through an io_uring per thread, driven with the raw
+ * system calls and without liburing.
+ *
+ * All of them run against a file or a block device such as /dev/nullb0,
+ * which takes the media out of the picture and leaves only the block layer
+ * and driver fast paths.  Without --file a scratch file is created in the
+ * current directory and removed again at the end.  Use --direct with aio,
+ * as buffered AIO completes synchronously on most filesystems.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <asm/barrier.h>
+#include <linux/aio_abi.h>
+#include <linux/compiler.h>
+#include <linux/fs.h>
+#include <linux/io_uring.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+#include "../util/stat.h"
+#include "../util/string2.h"
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "cpumap.h"
+#include "run.h"
+
+static const char *file_str;
+static const char *size_str = "256MB";
+static const char *bs_str = "4KB";
+static unsigned int nthreads = 1;
+static unsigned int nsecs = 5;
+static unsigned int iodepth = 32;
+static bool do_write, sequential, direct, silent;
+
+static bool use_aio;
+static bool use_uring;
+static size_t file_size;
+static size_t block_size;
+static int fd = -1;
+/* scratch file to remove at exit, including when a worker fails */
+static char *scratch;
+
+static struct stats throughput_stats;
+
+struct worker {
+	int tid;
+	pthread_t thread;
+	unsigned int seed;
+	u64 next;	/* next block for sequential I/O */
+	u64 first;	/* this thread's slice of the file, in blocks */
+	u64 nr;
+	unsigned long ops;
+};
+
+static const struct option options[] = {
+	OPT_STRING(  'f', "file",       &file_str, "path",
+		     "File or block device to use (default: a scratch file)"),
+	OPT_STRING(  's', "size",       &size_str, "256MB",
+		     "Size of the scratch file, or how much of --file to use"),
+	OPT_STRING(  'b', "block-size", &bs_str,   "4KB", "Size of each I/O"),
+	OPT_UINTEGER('t', "threads",    &nthreads, "Specify amount of threads"),
+	OPT_UINTEGER('r', "runtime",    &nsecs,    "Specify runtime (in seconds)"),
+	OPT_UINTEGER('q', "iodepth",    &iodepth,  "Requests in flight per thread (aio and io_uring only)"),
+	OPT_BOOLEAN( 'w', "write",      &do_write, "Write instead of read"),
+	OPT_BOOLEAN( 'l', "sequential", &sequential, "Sequential instead of random offsets"),
+	OPT_BOOLEAN( 'd', "direct",     &direct,   "Use O_DIRECT to bypass the page cache"),
+	OPT_BOOLEAN( 'S', "silent",     &silent,   "Silent mode: do not display data/details"),
+	OPT_END()
+};
+
+static const char * const bench_io_sync_usage[] = {
+	"perf bench io sync <options>",
+	NULL
+};
+
+static const char * const bench_io_aio_usage[] = {
+	"perf bench io aio <options>",
+	NULL
+};
+
+static const char * const bench_io_uring_usage[] = {
+	"perf bench io io_uring <options>",
+	NULL
+};
+
+static inline int io_setup(unsigned int nr, aio_context_t *ctx)
+{
+	return syscall(__NR_io_setup, nr, ctx);
+}
+
+static inline int io_destroy(aio_context_t ctx)
+{
+	return syscall(__NR_io_destroy, ctx);
+}
+
+static inline int io_submit(aio_context_t ctx, long nr, struct iocb **iocbpp)
+{
+	return syscall(__NR_io_submit, ctx, nr, iocbpp);
+}
+
+static inline int io_getevents(aio_context_t ctx, long min_nr, long max_nr,
+			       struct io_event *events)
+{
+	return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, NULL);
+}
+
+static inline int io_uring_setup(unsigned int entries,
+				 struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int io_uring_enter(int ring_fd, unsigned int to_submit,
+				 unsigned int min_complete, unsigned int flags)
+{
+	return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+static off_t next_offset(struct worker *w)
+{
+	u64 blk;
+
+	if (sequential) {
+		blk = w->first + w->next;
+		if (++w->next == w->nr)
+			w->next = 0;
+	} else {
+		blk = w->first + rand_r(&w->seed) % w->nr;
+	}
+
+	return (off_t)(blk * block_size);
+}
+
+static void *alloc_buf(void)
+{
+	void *buf;
+
+	if (posix_memalign(&buf, 4096, block_size))
+		err(EXIT_FAILURE, "posix_memalign");
+	memset(buf, 0xaa, block_size);
+
+	return buf;
+}
+
+static void *sync_workerfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	unsigned long ops = 0;
+	void *buf = alloc_buf();
+	ssize_t ret;
+
+	bench_run__worker_ready();
+
+	do {
+		off_t off = next_offset(w);
+
+		if (do_write)
+			ret = pwrite(fd, buf, block_size, off);
+		else
+			ret = pread(fd, buf, block_size, off);
+		if (ret < 0)
+			err(EXIT_FAILURE, do_write ? "pwrite" : "pread");
+		ops++;
+	} while (!bench_run.done);
+
+	w->ops = ops;
+	free(buf);
+	return NULL;
+}
+
+static void *aio_workerfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	struct io_event *events;
+	struct iocb *iocbs, **iocbps;
+	aio_context_t ctx = 0;
+	unsigned long ops = 0;
+	unsigned int i, inflight;
+	int nr;
+
+	iocbs = calloc(iodepth, sizeof(*iocbs));
+	iocbps = calloc(iodepth, sizeof(*iocbps));
+	events = calloc(iodepth, sizeof(*events));
+	if (!iocbs || !iocbps || !events)
+		err(EXIT_FAILURE, "calloc");
+
+	if (io_setup(iodepth, &ctx))
+		err(EXIT_FAILURE, "io_setup");
+
+	for (i = 0; i < iodepth; i++) {
+		iocbs[i].aio_fildes = fd;
+		iocbs[i].aio_lio_opcode = do_write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+		iocbs[i].aio_buf = (u64)(unsigned long)alloc_buf();
+		iocbs[i].aio_nbytes = block_size;
+		iocbs[i].aio_data = (u64)(unsigned long)&iocbs[i];
+		iocbps[i] = &iocbs[i];
+	}
+
+	bench_run__worker_ready();
+
+	for (i = 0; i < iodepth; i++)
+		iocbs[i].aio_offset = next_offset(w);
+	if (io_submit(ctx, iodepth, iocbps) != (int)iodepth)
+		err(EXIT_FAILURE, "io_submit");
+	inflight = iodepth;
+
+	while (inflight) {
+		nr = io_getevents(ctx, 1, iodepth, events);
+		if (nr < 0) {
+			if (errno == EINTR)
+				continue;
+			err(EXIT_FAILURE, "io_getevents");
+		}
+
+		inflight -= nr;
+		ops += nr;
+		if (bench_run.done)
+			continue;
+
+		/* Resubmit the completed requests at new offsets. */
+		for (i = 0; i < (unsigned int)nr; i++) {
+			struct iocb *iocb = (struct iocb *)(unsigned long)events[i].data;
+
+			if ((s64)events[i].res < 0)
+				errx(EXIT_FAILURE, "aio: %s", strerror(-(int)events[i].res));
+			iocb->aio_offset = next_offset(w);
+			iocbps[i] = iocb;
+		}
+		if (io_submit(ctx, nr, iocbps) != nr)
+			err(EXIT_FAILURE, "io_submit");
+		inflight += nr;
+	}
+
+	io_destroy(ctx);
+	for (i = 0; i < iodepth; i++)
+		free((void *)(unsigned long)iocbs[i].aio_buf);
+	free(events);
+	free(iocbps);
+	free(iocbs);
+
+	w->ops = ops;
+	return NULL;
+}
+
+/* The mmap()ed rings of an io_uring, see tools/io_uring/setup.c */
+struct uring {
+	int fd;
+	unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring, *cq_ring;
+	size_t sq_ring_sz, cq_ring_sz, sqes_sz;
+};
+
+static void uring_setup(struct uring *ring, unsigned int entries)
+{
+	struct io_uring_params p;
+	void *ptr;
+
+	memset(&p, 0, sizeof(p));
+	ring->fd = io_uring_setup(entries, &p);
+	if (ring->fd < 0)
+		err(EXIT_FAILURE, "io_uring_setup");
+
+	ring->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	ptr = mmap(NULL, ring->sq_ring_sz, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+	ring->sq_ring = ptr;
+	ring->sq_head = ptr + p.sq_off.head;
+	ring->sq_tail = ptr + p.sq_off.tail;
+	ring->sq_mask = ptr + p.sq_off.ring_mask;
+	ring->sq_array = ptr + p.sq_off.array;
+
+	ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, ring->sqes_sz, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+	ring->sqes = ptr;
+
+	ring->cq_ring_sz = p.cq_off.cqes +
+			   p.cq_entries * sizeof(struct io_uring_cqe);
+	ptr = mmap(NULL, ring->cq_ring_sz, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+	if (ptr == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+	ring->cq_ring = ptr;
+	ring->cq_head = ptr + p.cq_off.head;
+	ring->cq_tail = ptr + p.cq_off.tail;
+	ring->cq_mask = ptr + p.cq_off.ring_mask;
+	ring->cqes = ptr + p.cq_off.cqes;
+}
+
+static void uring_exit(struct uring *ring)
+{
+	munmap(ring->sqes, ring->sqes_sz);
+	munmap(ring->sq_ring, ring->sq_ring_sz);
+	munmap(ring->cq_ring, ring->cq_ring_sz);
+	close(ring->fd);
+}
+
+/*
+ * Queue the request for buffer @idx at a new offset.  The submission
+ * queue has room for all iodepth requests, and only this thread adds to
+ * it.
+ */
+static void uring_queue(struct uring *ring, struct worker *w,
+			struct iovec *iovs, unsigned int idx)
+{
+	unsigned int tail = *ring->sq_tail;
+	unsigned int index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = do_write ? IORING_OP_WRITEV : IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = next_offset(w);
+	sqe->addr = (unsigned long)&iovs[idx];
+	sqe->len = 1;
+	sqe->user_data = idx;
+	ring->sq_array[index] = index;
+	/* make the sqe visible before the new tail */
+	smp_store_release(ring->sq_tail, tail + 1);
+}
+
+static void *uring_workerfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	unsigned int i, head, tail, submit, inflight = 0;
+	unsigned long ops = 0;
+	struct iovec *iovs;
+	struct uring ring;
+	int ret;
+
+	iovs = calloc(iodepth, sizeof(*iovs));
+	if (!iovs)
+		err(EXIT_FAILURE, "calloc");
+
+	uring_setup(&ring, iodepth);
+
+	for (i = 0; i < iodepth; i++) {
+		iovs[i].iov_base = alloc_buf();
+		iovs[i].iov_len = block_size;
+	}
+
+	bench_run__worker_ready();
+
+	for (i = 0; i < iodepth; i++)
+		uring_queue(&ring, w, iovs, i);
+	submit = iodepth;
+
+	while (submit || inflight) {
+		ret = io_uring_enter(ring.fd, submit, 1,
+				     IORING_ENTER_GETEVENTS);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			err(EXIT_FAILURE, "io_uring_enter");
+		}
+		submit -= ret;
+		inflight += ret;
+
+		head = *ring.cq_head;
+		tail = smp_load_acquire(ring.cq_tail);
+		for (; head != tail; head++) {
+			struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+
+			if (cqe->res < 0)
+				errx(EXIT_FAILURE, "io_uring: %s", strerror(-cqe->res));
+			inflight--;
+			ops++;
+			if (bench_run.done)
+				continue;
+
+			/* Resubmit the completed request at a new offset. */
+			uring_queue(&ring, w, iovs, cqe->user_data);
+			submit++;
+		}
+		/* done with the cqes before the kernel may reuse them */
+		smp_store_release(ring.cq_head, head);
+	}
+
+	uring_exit(&ring);
+	for (i = 0; i < iodepth; i++)
+		free(iovs[i].iov_base);
+	free(iovs);
+
+	w->ops = ops;
+	return NULL;
+}
+
+static void remove_scratch(void)
+{
+	if (!scratch)
+		return;
+
+	unlink(scratch);
+	free(scratch);
+	scratch = NULL;
+}
+
+/*
+ * Open --file, or create and fill a scratch file so that reads do not just
+ * hit holes.  The scratch file is removed again by remove_scratch().
+ */
+static void open_file(void)
+{
+	int flags = (do_write ? O_RDWR : O_RDONLY) | (direct ? O_DIRECT : 0);
+	size_t len = 1024 * 1024, done_len;
+	struct stat st;
+	u64 dev_size;
+	void *buf;
+
+	if (file_str) {
+		fd = open(file_str, flags);
+		if (fd < 0)
+			err(EXIT_FAILURE, "open %s", file_str);
+		if (fstat(fd, &st))
+			err(EXIT_FAILURE, "fstat");
+		if (S_ISBLK(st.st_mode)) {
+			if (ioctl(fd, BLKGETSIZE64, &dev_size))
+				err(EXIT_FAILURE, "BLKGETSIZE64");
+		} else {
+			dev_size = st.st_size;
+		}
+		if (dev_size < file_size)
+			file_size = dev_size;
+		return;
+	}
+
+	scratch = strdup("perf-bench-io.XXXXXX");
+	if (!scratch)
+		err(EXIT_FAILURE, "strdup");
+	fd = mkstemp(scratch);
+	if (fd < 0) {
+		free(scratch);
+		scratch = NULL;
+		err(EXIT_FAILURE, "mkstemp");
+	}
+	/* err() exits, so make sure that the file goes away then too */
+	atexit(remove_scratch);
+
+	buf = calloc(1, len);
+	if (!buf)
+		err(EXIT_FAILURE, "calloc");
+	for (done_len = 0; done_len < file_size; done_len += len) {
+		if (write(fd, buf, min(len, file_size - done_len)) < 0)
+			err(EXIT_FAILURE, "write");
+	}
+	free(buf);
+	fsync(fd);
+	close(fd);
+
+	fd = open(scratch, flags);
+	if (fd < 0)
+		err(EXIT_FAILURE, "open %s", scratch);
+}
+
+static int bench_io_common(int argc, const char **argv,
+			   const char * const *usage)
+{
+	int ret = 0;
+	cpu_set_t cpuset;
+	unsigned int i;
+	pthread_attr_t thread_attr;
+	struct worker *worker = NULL;
+	struct cpu_map *cpu;
+	u64 nr_blocks;
+	double mbps;
+
+	argc = parse_options(argc, argv, options, usage, 0);
+	if (argc) {
+		usage_with_options(usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	file_size = (size_t)perf_atoll((char *)size_str);
+	block_size = (size_t)perf_atoll((char *)bs_str);
+	if ((s64)file_size <= 0 || (s64)block_size <= 0) {
+		fprintf(stderr, "Invalid size:%s or block size:%s\n", size_str, bs_str);
+		return 1;
+	}
+	if (!nthreads || ((use_aio || use_uring) && !iodepth)) {
+		fprintf(stderr, "Invalid number of threads or iodepth\n");
+		return 1;
+	}
+
+	open_file();
+	nr_blocks = file_size / block_size;
+	if (nr_blocks < nthreads) {
+		fprintf(stderr, "Too few blocks (%" PRIu64 ") for %u threads\n",
+			nr_blocks, nthreads);
+		ret = 1;
+		goto out_close;
+	}
+
+	cpu = cpu_map__new(NULL);
+	if (!cpu)
+		goto errmem;
+
+	worker = calloc(nthreads, sizeof(*worker));
+	if (!worker)
+		goto errmem;
+
+	printf("Run summary [PID %d]: %d threads, %s %s %s I/O of %s on %s%s for %d secs.\n\n",
+	       getpid(), nthreads,
+	       use_aio ? "aio" : use_uring ? "io_uring" : "sync",
+	       sequential ? "sequential" : "random",
+	       do_write ? "write" : "read", bs_str,
+	       scratch ?: file_str, direct ? " (O_DIRECT)" : "", nsecs);
+
+	init_stats(&throughput_stats);
+	bench_run__init(nthreads);
+
+	pthread_attr_init(&thread_attr);
+	for (i = 0; i < nthreads; i++) {
+		worker[i].tid = i;
+		worker[i].seed = getpid() + i;
+		/* Split the file so that sequential streams don't overlap. */
+		worker[i].nr = sequential ? nr_blocks / nthreads : nr_blocks;
+		worker[i].first = sequential ? worker[i].nr * i : 0;
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu->map[i % cpu->nr], &cpuset);
+
+		ret = pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &cpuset);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+
+		ret = pthread_create(&worker[i].thread, &thread_attr,
+				     use_aio ? aio_workerfn :
+				     use_uring ? uring_workerfn : sync_workerfn,
+				     (void *)(struct worker *) &worker[i]);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+	}
+	pthread_attr_destroy(&thread_attr);
+
+	bench_run__go(nsecs);
+
+	for (i = 0; i < nthreads; i++) {
+		ret = pthread_join(worker[i].thread, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+	}
+
+	/* cleanup & report results */
+	bench_run__exit();
+
+	for (i = 0; i < nthreads; i++) {
+		unsigned long t = bench_run__per_sec(worker[i].ops);
+
+		update_stats(&throughput_stats, t);
+		if (!silent)
+			printf("[thread %2d] %ld IOPS\n", worker[i].tid, t);
+	}
+
+	bench_run__print_summary(&throughput_stats, "IOPS per thread", silent);
+	mbps = avg_stats(&throughput_stats) * nthreads * block_size /
+		(1024 * 1024);
+	printf("Total throughput: %.2f MB/sec\n", mbps);
+
+	free(worker);
+	free(cpu);
+out_close:
+	close(fd);
+	remove_scratch();
+	return ret;
+errmem:
+	err(EXIT_FAILURE, "calloc");
+}
+
+int bench_io_sync(int argc, const char **argv)
+{
+	use_aio = false;
+	use_uring = false;
+	return bench_io_common(argc, argv, bench_io_sync_usage);
+}
+
+int bench_io_aio(int argc, const char **argv)
+{
+	use_aio = true;
+	use_uring = false;
+	return bench_io_common(argc, argv, bench_io_aio_usage);
+}
+
+int bench_io_uring(int argc, const char **argv)
+{
+	use_aio = false;
+	use_uring = true;
+	return bench_io_common(argc, argv, bench_io_uring_usage);
+}
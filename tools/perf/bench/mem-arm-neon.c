@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * NEON memcpy() and memset() variants for 'perf bench mem', built on both
+ * 32-bit ARM (when the compiler targets NEON) and arm64.  They compare the
+ * raw NEON load/store throughput against the C library's routines.
+ */
+#ifdef __ARM_NEON
+
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem-memcpy-arch.h"
+#include "mem-memset-arch.h"
+
+void *memcpy_neon(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+
+	for (; len >= 64; len -= 64, s += 64, d += 64) {
+		uint8x16_t a = vld1q_u8(s);
+		uint8x16_t b = vld1q_u8(s + 16);
+		uint8x16_t c = vld1q_u8(s + 32);
+		uint8x16_t e = vld1q_u8(s + 48);
+
+		vst1q_u8(d, a);
+		vst1q_u8(d + 16, b);
+		vst1q_u8(d + 32, c);
+		vst1q_u8(d + 48, e);
+	}
+
+	for (; len >= 16; len -= 16, s += 16, d += 16)
+		vst1q_u8(d, vld1q_u8(s));
+
+	while (len--)
+		*d++ = *s++;
+
+	return dst;
+}
+
+void *memset_neon(void *dst, int c, size_t len)
+{
+	uint8x16_t v = vdupq_n_u8((uint8_t)c);
+	uint8_t *d = dst;
+
+	for (; len >= 64; len -= 64, d += 64) {
+		vst1q_u8(d, v);
+		vst1q_u8(d + 16, v);
+		vst1q_u8(d + 32, v);
+		vst1q_u8(d + 48, v);
+	}
+
+	for (; len >= 16; len -= 16, d += 16)
+		vst1q_u8(d, v);
+
+	while (len--)
+		*d++ = (uint8_t)c;
+
+	return dst;
+}
+
+#endif /* __ARM_NEON */
@@ -11,3 +11,13 @@
 
 #endif
 
+#ifdef __ARM_NEON
+
+#define MEMCPY_FN(fn, name, desc)		\
+	void *fn(void *, const void *, size_t);
+
+#include "mem-memcpy-arm-neon-def.h"
+
+#undef MEMCPY_FN
+
+#endif
@@ -0,0 +1,5 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+MEMCPY_FN(memcpy_neon,
+	"arm-neon",
+	"NEON memcpy() copying 64 bytes per iteration in mem-arm-neon.c")
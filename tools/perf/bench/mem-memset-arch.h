@@ -11,3 +11,13 @@
 
 #endif
 
+#ifdef __ARM_NEON
+
+#define MEMSET_FN(fn, name, desc)		\
+	void *fn(void *, int, size_t);
+
+#include "mem-memset-arm-neon-def.h"
+
+#undef MEMSET_FN
+
+#endif
@@ -0,0 +1,5 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+MEMSET_FN(memset_neon,
+	"arm-neon",
+	"NEON memset() storing 64 bytes per iteration in mem-arm-neon.c")
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * mm-fault.c
+ *
+ * page-fault: Measure anonymous page fault throughput.  Every thread maps
+ * its own region, touches each page of it once and unmaps it again, so
+ * the run exercises the fault path, page allocation and zeroing, and the
+ * teardown in munmap().
+ *
+ * thp: The same, with 2MB aligned regions and MADV_HUGEPAGE, to stress
+ * transparent huge page allocation and, on a fragmented system, direct
+ * compaction.  The THP and compaction vmstat deltas are reported too.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+#include "../util/stat.h"
+#include "../util/string2.h"
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "cpumap.h"
+#include "run.h"
+
+#define THP_SIZE	(2UL << 20)
+
+static unsigned int nthreads;
+static unsigned int nsecs = 5;
+static const char *size_str = "16MB";
+static bool silent;
+static bool use_thp;
+
+static size_t region_size;
+static size_t page_size;
+
+static struct stats throughput_stats;
+
+struct worker {
+	int tid;
+	pthread_t thread;
+	unsigned long faults;
+	unsigned long loops;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads, "Specify amount of threads"),
+	OPT_UINTEGER('r', "runtime", &nsecs,    "Specify runtime (in seconds)"),
+	OPT_STRING(  's', "size",    &size_str, "16MB",
+		     "Specify the size of each thread's region. "
+		     "Available units: B, KB, MB, GB and TB (case insensitive)"),
+	OPT_BOOLEAN( 'S', "silent",  &silent,   "Silent mode: do not display data/details"),
+	OPT_END()
+};
+
+static const char * const bench_mm_page_fault_usage[] = {
+	"perf bench mm page-fault <options>",
+	NULL
+};
+
+static const char * const bench_mm_thp_usage[] = {
+	"perf bench mm thp <options>",
+	NULL
+};
+
+/* vmstat counters reported by the thp benchmark */
+static const char * const vmstat_names[] = {
+	"thp_fault_alloc",
+	"thp_fault_fallback",
+	"compact_stall",
+	"compact_success",
+	"compact_fail",
+};
+
+static void read_vmstat(unsigned long *vals)
+{
+	char name[64];
+	unsigned long val;
+	unsigned int i;
+	FILE *fp;
+
+	memset(vals, 0, ARRAY_SIZE(vmstat_names) * sizeof(*vals));
+
+	fp = fopen("/proc/vmstat", "r");
+	if (!fp)
+		return;
+
+	while (fscanf(fp, "%63s %lu", name, &val) == 2) {
+		for (i = 0; i < ARRAY_SIZE(vmstat_names); i++) {
+			if (!strcmp(name, vmstat_names[i]))
+				vals[i] = val;
+		}
+	}
+	fclose(fp);
+}
+
+static char *map_region(void)
+{
+	size_t len = region_size + (use_thp ? THP_SIZE : 0);
+	unsigned long addr;
+	char *p;
+
+	p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+
+	if (!use_thp)
+		return p;
+
+	/* Trim the mapping so that it starts on a huge page boundary. */
+	addr = ((unsigned long)p + THP_SIZE - 1) & ~(THP_SIZE - 1);
+	if (addr != (unsigned long)p)
+		munmap(p, addr - (unsigned long)p);
+	if (addr + region_size != (unsigned long)p + len)
+		munmap((char *)addr + region_size,
+		       (unsigned long)p + len - addr - region_size);
+
+	if (madvise((char *)addr, region_size, MADV_HUGEPAGE))
+		err(EXIT_FAILURE, "madvise");
+
+	return (char *)addr;
+}
+
+static void *workerfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	unsigned long faults = 0, loops = 0;
+	size_t off;
+	char *p;
+
+	bench_run__worker_ready();
+
+	do {
+		p = map_region();
+		for (off = 0; off < region_size; off += page_size, faults++)
+			p[off] = 1;
+		munmap(p, region_size);
+		loops++;
+	} while (!bench_run.done);
+
+	w->faults = faults;
+	w->loops = loops;
+	return NULL;
+}
+
+static int bench_mm_fault_common(int argc, const char **argv,
+				 const char * const *usage)
+{
+	unsigned long vm_before[ARRAY_SIZE(vmstat_names)];
+	unsigned long vm_after[ARRAY_SIZE(vmstat_names)];
+	int ret = 0;
+	cpu_set_t cpuset;
+	unsigned int i;
+	pthread_attr_t thread_attr;
+	struct worker *worker = NULL;
+	struct cpu_map *cpu;
+
+	argc = parse_options(argc, argv, options, usage, 0);
+	if (argc) {
+		usage_with_options(usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+	region_size = (size_t)perf_atoll((char *)size_str);
+	if ((s64)region_size <= 0) {
+		fprintf(stderr, "Invalid size:%s\n", size_str);
+		return 1;
+	}
+	if (use_thp)
+		region_size = roundup(region_size, THP_SIZE);
+	else
+		region_size = roundup(region_size, page_size);
+
+	cpu = cpu_map__new(NULL);
+	if (!cpu)
+		goto errmem;
+
+	if (!nthreads) /* default to the number of CPUs */
+		nthreads = cpu->nr;
+
+	worker = calloc(nthreads, sizeof(*worker));
+	if (!worker)
+		goto errmem;
+
+	printf("Run summary [PID %d]: %d threads, each faulting in %s%s regions for %d secs.\n\n",
+	       getpid(), nthreads, size_str, use_thp ? " THP" : "", nsecs);
+
+	init_stats(&throughput_stats);
+	bench_run__init(nthreads);
+
+	pthread_attr_init(&thread_attr);
+	for (i = 0; i < nthreads; i++) {
+		worker[i].tid = i;
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu->map[i % cpu->nr], &cpuset);
+
+		ret = pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &cpuset);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+
+		ret = pthread_create(&worker[i].thread, &thread_attr, workerfn,
+				     (void *)(struct worker *) &worker[i]);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+	}
+	pthread_attr_destroy(&thread_attr);
+
+	/* the workers don't fault anything in before the run starts */
+	read_vmstat(vm_before);
+	bench_run__go(nsecs);
+
+	for (i = 0; i < nthreads; i++) {
+		ret = pthread_join(worker[i].thread, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+	}
+	read_vmstat(vm_after);
+
+	/* cleanup & report results */
+	bench_run__exit();
+
+	for (i = 0; i < nthreads; i++) {
+		unsigned long t = bench_run__per_sec(worker[i].faults);
+
+		update_stats(&throughput_stats, t);
+		if (!silent)
+			printf("[thread %2d] %lu regions, %ld pages touched/sec\n",
+			       worker[i].tid, worker[i].loops, t);
+	}
+
+	bench_run__print_summary(&throughput_stats,
+				 "pages touched/sec per thread", silent);
+
+	if (use_thp) {
+		printf("\n");
+		for (i = 0; i < ARRAY_SIZE(vmstat_names); i++)
+			printf("%20s: %lu\n", vmstat_names[i],
+			       vm_after[i] - vm_before[i]);
+	}
+
+	free(worker);
+	free(cpu);
+	return ret;
+errmem:
+	err(EXIT_FAILURE, "calloc");
+}
+
+int bench_mm_page_fault(int argc, const char **argv)
+{
+	use_thp = false;
+	return bench_mm_fault_common(argc, argv, bench_mm_page_fault_usage);
+}
+
+int bench_mm_thp(int argc, const char **argv)
+{
+	use_thp = true;
+	return bench_mm_fault_common(argc, argv, bench_mm_thp_usage);
+}
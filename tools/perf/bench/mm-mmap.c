@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * mm-mmap.c
+ *
+ * mmap: Measure how mmap()/munmap() scale with the number of threads.
+ * All threads share one address space and loop mapping a small anonymous
+ * region, faulting in its first page and unmapping it, which contends on
+ * the mm's mmap_sem and VMA tree and sends TLB shootdowns to the other
+ * CPUs running the process.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+#include "../util/stat.h"
+#include "../util/string2.h"
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "cpumap.h"
+#include "run.h"
+
+static unsigned int nthreads;
+static unsigned int nsecs = 5;
+static const char *size_str = "64KB";
+static bool silent, no_touch;
+
+static size_t map_size;
+
+static struct stats throughput_stats;
+
+struct worker {
+	int tid;
+	pthread_t thread;
+	unsigned long ops;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads",  &nthreads, "Specify amount of threads"),
+	OPT_UINTEGER('r', "runtime",  &nsecs,    "Specify runtime (in seconds)"),
+	OPT_STRING(  's', "size",     &size_str, "64KB",
+		     "Specify the size of each mapping. "
+		     "Available units: B, KB, MB, GB and TB (case insensitive)"),
+	OPT_BOOLEAN( 'n', "no-touch", &no_touch, "Do not fault in the mapping before unmapping it"),
+	OPT_BOOLEAN( 'S', "silent",   &silent,   "Silent mode: do not display data/details"),
+	OPT_END()
+};
+
+static const char * const bench_mm_mmap_usage[] = {
+	"perf bench mm mmap <options>",
+	NULL
+};
+
+static void *workerfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	unsigned long ops = 0;
+	char *p;
+
+	bench_run__worker_ready();
+
+	do {
+		p = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			err(EXIT_FAILURE, "mmap");
+		if (!no_touch)
+			p[0] = 1;
+		munmap(p, map_size);
+		ops++;
+	} while (!bench_run.done);
+
+	w->ops = ops;
+	return NULL;
+}
+
+int bench_mm_mmap(int argc, const char **argv)
+{
+	int ret = 0;
+	cpu_set_t cpuset;
+	unsigned int i;
+	pthread_attr_t thread_attr;
+	struct worker *worker = NULL;
+	struct cpu_map *cpu;
+
+	argc = parse_options(argc, argv, options, bench_mm_mmap_usage, 0);
+	if (argc) {
+		usage_with_options(bench_mm_mmap_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	map_size = (size_t)perf_atoll((char *)size_str);
+	if ((s64)map_size <= 0) {
+		fprintf(stderr, "Invalid size:%s\n", size_str);
+		return 1;
+	}
+
+	cpu = cpu_map__new(NULL);
+	if (!cpu)
+		goto errmem;
+
+	if (!nthreads) /* default to the number of CPUs */
+		nthreads = cpu->nr;
+
+	worker = calloc(nthreads, sizeof(*worker));
+	if (!worker)
+		goto errmem;
+
+	printf("Run summary [PID %d]: %d threads mapping %s regions for %d secs.\n\n",
+	       getpid(), nthreads, size_str, nsecs);
+
+	init_stats(&throughput_stats);
+	bench_run__init(nthreads);
+
+	pthread_attr_init(&thread_attr);
+	for (i = 0; i < nthreads; i++) {
+		worker[i].tid = i;
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu->map[i % cpu->nr], &cpuset);
+
+		ret = pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &cpuset);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+
+		ret = pthread_create(&worker[i].thread, &thread_attr, workerfn,
+				     (void *)(struct worker *) &worker[i]);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+	}
+	pthread_attr_destroy(&thread_attr);
+
+	bench_run__go(nsecs);
+
+	for (i = 0; i < nthreads; i++) {
+		ret = pthread_join(worker[i].thread, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+	}
+
+	/* cleanup & report results */
+	bench_run__exit();
+
+	for (i = 0; i < nthreads; i++) {
+		unsigned long t = bench_run__per_sec(worker[i].ops);
+
+		update_stats(&throughput_stats, t);
+		if (!silent)
+			printf("[thread %2d] %ld mmap/munmap pairs/sec\n",
+			       worker[i].tid, t);
+	}
+
+	bench_run__print_summary(&throughput_stats,
+				 "mmap/munmap pairs/sec per thread", silent);
+
+	free(worker);
+	free(cpu);
+	return ret;
+errmem:
+	err(EXIT_FAILURE, "calloc");
+}
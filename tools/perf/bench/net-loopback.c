@@ -0,0 +1,386 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * net-loopback.c
+ *
+ * tcp-rr, udp-rr: Measure request/response transactions per second over
+ * loopback, each client sending a message and waiting for the echo before
+ * sending the next one.  This is dominated by the per-packet cost of the
+ * socket and protocol stacks and the wakeup latency between the two ends.
+ *
+ * tcp-stream: Measure bulk TCP throughput over loopback, the clients
+ * writing as fast as the servers can read.
+ *
+ * Every client gets its own server thread and socket pair.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+#include "../util/stat.h"
+#include "../util/string2.h"
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "cpumap.h"
+#include "run.h"
+
+enum net_mode {
+	NET_TCP_RR,
+	NET_UDP_RR,
+	NET_TCP_STREAM,
+};
+
+static unsigned int nclients = 1;
+static unsigned int nsecs = 5;
+static const char *size_str;
+static bool silent;
+
+static enum net_mode mode;
+static size_t msg_size;
+
+static struct stats throughput_stats;
+
+struct worker {
+	int tid;
+	pthread_t client, server;
+	int listen_fd;
+	struct sockaddr_in addr;
+	unsigned long ops;
+	u64 bytes;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nclients, "Specify amount of client/server pairs"),
+	OPT_UINTEGER('r', "runtime", &nsecs,    "Specify runtime (in seconds)"),
+	OPT_STRING(  's', "size",    &size_str, "size",
+		     "Specify the message size (default: 1B for rr, 64KB for stream). "
+		     "Available units: B, KB, MB, GB and TB (case insensitive)"),
+	OPT_BOOLEAN( 'S', "silent",  &silent,   "Silent mode: do not display data/details"),
+	OPT_END()
+};
+
+static const char * const bench_net_tcp_rr_usage[] = {
+	"perf bench net tcp-rr <options>",
+	NULL
+};
+
+static const char * const bench_net_udp_rr_usage[] = {
+	"perf bench net udp-rr <options>",
+	NULL
+};
+
+static const char * const bench_net_tcp_stream_usage[] = {
+	"perf bench net tcp-stream <options>",
+	NULL
+};
+
+/* Wake up every second to notice the end of the run on an idle socket. */
+static void set_rcvtimeo(int fd)
+{
+	struct timeval tv = { .tv_sec = 1 };
+
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)))
+		err(EXIT_FAILURE, "setsockopt");
+}
+
+/* Receive a whole message, returns false once the peer or the run is gone. */
+static bool recv_full(int fd, char *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = recv(fd, buf, len, 0);
+		if (ret < 0 && (errno == EAGAIN || errno == EINTR) &&
+		    !bench_run.done)
+			continue;
+		if (ret <= 0)
+			return false;
+		buf += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+static void *serverfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	struct sockaddr_in peer;
+	socklen_t peer_len;
+	char *buf;
+	ssize_t ret;
+	int fd;
+
+	buf = malloc(msg_size);
+	if (!buf)
+		err(EXIT_FAILURE, "malloc");
+
+	if (mode == NET_UDP_RR) {
+		fd = w->listen_fd;
+	} else {
+		fd = accept(w->listen_fd, NULL, NULL);
+		if (fd < 0)
+			err(EXIT_FAILURE, "accept");
+	}
+	set_rcvtimeo(fd);
+
+	bench_run__worker_ready();
+
+	while (!bench_run.done) {
+		switch (mode) {
+		case NET_UDP_RR:
+			peer_len = sizeof(peer);
+			ret = recvfrom(fd, buf, msg_size, 0,
+				       (struct sockaddr *)&peer, &peer_len);
+			if (ret > 0)
+				sendto(fd, buf, ret, 0,
+				       (struct sockaddr *)&peer, peer_len);
+			break;
+		case NET_TCP_RR:
+			if (!recv_full(fd, buf, msg_size))
+				goto out;
+			if (send(fd, buf, msg_size, MSG_NOSIGNAL) < 0)
+				goto out;
+			break;
+		case NET_TCP_STREAM:
+			ret = recv(fd, buf, msg_size, 0);
+			if (ret < 0 && (errno == EAGAIN || errno == EINTR))
+				continue;
+			if (ret <= 0)
+				goto out;
+			break;
+		}
+	}
+out:
+	if (fd != w->listen_fd)
+		close(fd);
+	free(buf);
+	return NULL;
+}
+
+static void *clientfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	unsigned long ops = 0;
+	u64 bytes = 0;
+	int one = 1;
+	char *buf;
+	int fd;
+
+	buf = calloc(1, msg_size);
+	if (!buf)
+		err(EXIT_FAILURE, "calloc");
+
+	fd = socket(AF_INET, mode == NET_UDP_RR ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if (fd < 0)
+		err(EXIT_FAILURE, "socket");
+	if (mode == NET_TCP_RR &&
+	    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)))
+		err(EXIT_FAILURE, "setsockopt");
+	if (connect(fd, (struct sockaddr *)&w->addr, sizeof(w->addr)))
+		err(EXIT_FAILURE, "connect");
+	set_rcvtimeo(fd);
+
+	bench_run__worker_ready();
+
+	do {
+		switch (mode) {
+		case NET_UDP_RR:
+			/* A lost datagram just times out and is resent. */
+			if (send(fd, buf, msg_size, 0) < 0)
+				err(EXIT_FAILURE, "send");
+			if (recv(fd, buf, msg_size, 0) <= 0)
+				continue;
+			break;
+		case NET_TCP_RR:
+			if (send(fd, buf, msg_size, MSG_NOSIGNAL) < 0)
+				goto out;
+			if (!recv_full(fd, buf, msg_size))
+				goto out;
+			break;
+		case NET_TCP_STREAM:
+			/* Fails once the server has gone at the end of the run. */
+			if (send(fd, buf, msg_size, MSG_NOSIGNAL) < 0)
+				goto out;
+			break;
+		}
+		ops++;
+		bytes += msg_size;
+	} while (!bench_run.done);
+out:
+	close(fd);
+	free(buf);
+
+	w->ops = ops;
+	w->bytes = bytes;
+	return NULL;
+}
+
+static int open_server(struct worker *w)
+{
+	socklen_t len = sizeof(w->addr);
+	int fd;
+
+	fd = socket(AF_INET, mode == NET_UDP_RR ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if (fd < 0)
+		err(EXIT_FAILURE, "socket");
+
+	memset(&w->addr, 0, sizeof(w->addr));
+	w->addr.sin_family = AF_INET;
+	w->addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(fd, (struct sockaddr *)&w->addr, sizeof(w->addr)))
+		err(EXIT_FAILURE, "bind");
+	if (getsockname(fd, (struct sockaddr *)&w->addr, &len))
+		err(EXIT_FAILURE, "getsockname");
+	if (mode != NET_UDP_RR && listen(fd, 1))
+		err(EXIT_FAILURE, "listen");
+
+	return fd;
+}
+
+static int bench_net_common(int argc, const char **argv,
+			    const char * const *usage)
+{
+	int ret = 0;
+	cpu_set_t cpuset;
+	unsigned int i;
+	pthread_attr_t thread_attr;
+	struct worker *worker = NULL;
+	struct cpu_map *cpu;
+
+	argc = parse_options(argc, argv, options, usage, 0);
+	if (argc) {
+		usage_with_options(usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	if (size_str)
+		msg_size = (size_t)perf_atoll((char *)size_str);
+	else
+		msg_size = mode == NET_TCP_STREAM ? 64 * 1024 : 1;
+	if ((s64)msg_size <= 0 || (mode == NET_UDP_RR && msg_size > 65507)) {
+		fprintf(stderr, "Invalid size:%s\n", size_str);
+		return 1;
+	}
+	if (!nclients) {
+		fprintf(stderr, "Invalid number of threads\n");
+		return 1;
+	}
+
+	cpu = cpu_map__new(NULL);
+	if (!cpu)
+		goto errmem;
+
+	worker = calloc(nclients, sizeof(*worker));
+	if (!worker)
+		goto errmem;
+
+	printf("Run summary [PID %d]: %d client/server pairs, %zu byte messages for %d secs.\n\n",
+	       getpid(), nclients, msg_size, nsecs);
+
+	init_stats(&throughput_stats);
+	bench_run__init(2 * nclients);
+
+	pthread_attr_init(&thread_attr);
+	for (i = 0; i < nclients; i++) {
+		worker[i].tid = i;
+		worker[i].listen_fd = open_server(&worker[i]);
+
+		/* Keep the two ends of a pair on different CPUs. */
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu->map[(2 * i) % cpu->nr], &cpuset);
+		ret = pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &cpuset);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+
+		ret = pthread_create(&worker[i].server, &thread_attr, serverfn,
+				     (void *)(struct worker *) &worker[i]);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu->map[(2 * i + 1) % cpu->nr], &cpuset);
+		ret = pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &cpuset);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+
+		ret = pthread_create(&worker[i].client, &thread_attr, clientfn,
+				     (void *)(struct worker *) &worker[i]);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+	}
+	pthread_attr_destroy(&thread_attr);
+
+	bench_run__go(nsecs);
+
+	for (i = 0; i < nclients; i++) {
+		ret = pthread_join(worker[i].client, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+		ret = pthread_join(worker[i].server, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+		close(worker[i].listen_fd);
+	}
+
+	/* cleanup & report results */
+	bench_run__exit();
+
+	for (i = 0; i < nclients; i++) {
+		unsigned long t;
+
+		if (mode == NET_TCP_STREAM) {
+			t = bench_run__per_sec(worker[i].bytes) / (1024 * 1024);
+			if (!silent)
+				printf("[client %2d] %ld MB/sec\n", worker[i].tid, t);
+		} else {
+			t = bench_run__per_sec(worker[i].ops);
+			if (!silent)
+				printf("[client %2d] %ld transactions/sec\n",
+				       worker[i].tid, t);
+		}
+		update_stats(&throughput_stats, t);
+	}
+
+	bench_run__print_summary(&throughput_stats,
+				 mode == NET_TCP_STREAM ?
+				 "MB/sec per client" :
+				 "transactions/sec per client", silent);
+
+	free(worker);
+	free(cpu);
+	return ret;
+errmem:
+	err(EXIT_FAILURE, "calloc");
+}
+
+int bench_net_tcp_rr(int argc, const char **argv)
+{
+	mode = NET_TCP_RR;
+	return bench_net_common(argc, argv, bench_net_tcp_rr_usage);
+}
+
+int bench_net_udp_rr(int argc, const char **argv)
+{
+	mode = NET_UDP_RR;
+	return bench_net_common(argc, argv, bench_net_udp_rr_usage);
+}
+
+int bench_net_tcp_stream(int argc, const char **argv)
+{
+	mode = NET_TCP_STREAM;
+	return bench_net_common(argc, argv, bench_net_tcp_stream_usage);
+}
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * run.c
+ *
+ * Start and stop handling shared by the timed, multithreaded benchmarks,
+ * see run.h.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <linux/compiler.h>
+
+#include "../util/stat.h"
+#include "run.h"
+
+struct bench_run bench_run;
+
+static pthread_mutex_t thread_lock;
+static unsigned int threads_starting;
+static pthread_cond_t thread_parent, thread_worker;
+
+static void toggle_done(int sig __maybe_unused,
+			siginfo_t *info __maybe_unused,
+			void *uc __maybe_unused)
+{
+	/* inform all threads that we're done for the day */
+	bench_run.done = true;
+	gettimeofday(&bench_run.end, NULL);
+	timersub(&bench_run.end, &bench_run.start, &bench_run.runtime);
+}
+
+/* Call before starting @nthreads workers. */
+void bench_run__init(unsigned int nthreads)
+{
+	struct sigaction act;
+
+	memset(&bench_run, 0, sizeof(bench_run));
+
+	memset(&act, 0, sizeof(act));
+	sigfillset(&act.sa_mask);
+	act.sa_sigaction = toggle_done;
+	act.sa_flags = SA_SIGINFO;
+	sigaction(SIGINT, &act, NULL);
+
+	pthread_mutex_init(&thread_lock, NULL);
+	pthread_cond_init(&thread_parent, NULL);
+	pthread_cond_init(&thread_worker, NULL);
+	threads_starting = nthreads;
+}
+
+/* Called by each worker once set up, returns when the run starts. */
+void bench_run__worker_ready(void)
+{
+	pthread_mutex_lock(&thread_lock);
+	threads_starting--;
+	if (!threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+}
+
+/* Wait for all workers, start them and stop them again after @nsecs. */
+void bench_run__go(unsigned int nsecs)
+{
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	gettimeofday(&bench_run.start, NULL);
+	pthread_cond_broadcast(&thread_worker);
+	pthread_mutex_unlock(&thread_lock);
+
+	sleep(nsecs);
+	toggle_done(0, NULL, NULL);
+}
+
+/* Call once all workers have been joined. */
+void bench_run__exit(void)
+{
+	pthread_cond_destroy(&thread_parent);
+	pthread_cond_destroy(&thread_worker);
+	pthread_mutex_destroy(&thread_lock);
+}
+
+/*
+ * @count per second of the run.  SIGINT can end the run within its first
+ * second, so this cannot just divide by the whole seconds.
+ */
+unsigned long bench_run__per_sec(u64 count)
+{
+	u64 usecs = bench_run.runtime.tv_sec * 1000000ULL +
+		    bench_run.runtime.tv_usec;
+
+	return usecs ? (double)count * 1000000 / usecs : 0;
+}
+
+void bench_run__print_summary(struct stats *stats, const char *unit,
+			      bool silent)
+{
+	unsigned long avg = avg_stats(stats);
+	double stddev = stddev_stats(stats);
+
+	printf("%sAveraged %ld %s (+- %.2f%%), total secs = %d\n",
+	       !silent ? "\n" : "", avg, unit, rel_stddev_stats(stddev, avg),
+	       (int) bench_run.runtime.tv_sec);
+}
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Start and stop handling shared by the timed, multithreaded mm, io and
+ * net benchmarks.  Workers call bench_run__worker_ready() once set up and
+ * then loop until bench_run.done, which bench_run__go() sets after the
+ * runtime, or SIGINT sets earlier.
+ */
+
+#ifndef _BENCH_RUN_H
+#define _BENCH_RUN_H
+
+#include <stdbool.h>
+#include <sys/time.h>
+#include <linux/types.h>
+
+struct stats;
+
+struct bench_run {
+	bool done;
+	struct timeval start, end, runtime;
+};
+
+extern struct bench_run bench_run;
+
+void bench_run__init(unsigned int nthreads);
+void bench_run__worker_ready(void);
+void bench_run__go(unsigned int nsecs);
+void bench_run__exit(void);
+unsigned long bench_run__per_sec(u64 count);
+void bench_run__print_summary(struct stats *stats, const char *unit,
+			      bool silent);
+
+#endif /* _BENCH_RUN_H */
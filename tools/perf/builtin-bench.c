@@ -15,6 +15,9 @@
  *  numa  ... NUMA scheduling and MM performance
  *  futex ... Futex performance
  *  epoll ... Event poll performance
+ *  mm    ... Page fault and address space performance
+ *  io    ... Block I/O performance
+ *  net   ... Loopback networking performance
  */
 #include "perf.h"
 #include <subcmd/parse-options.h>
@@ -77,6 +80,30 @@ static struct bench epoll_benchmarks[] = {
 };
 #endif // HAVE_EVENTFD
 
+static struct bench mm_benchmarks[] = {
+	{ "page-fault",	"Benchmark for anonymous page faults",		bench_mm_page_fault	},
+	{ "thp",	"Benchmark for transparent huge page faults",	bench_mm_thp		},
+	{ "mmap",	"Benchmark for concurrent mmap() and munmap()",	bench_mm_mmap		},
+	{ "all",	"Run all mm benchmarks",			NULL			},
+	{ NULL,		NULL,						NULL			}
+};
+
+static struct bench io_benchmarks[] = {
+	{ "sync",	"Benchmark for pread()/pwrite() I/O",		bench_io_sync		},
+	{ "aio",	"Benchmark for Linux native AIO",		bench_io_aio		},
+	{ "io_uring",	"Benchmark for io_uring",			bench_io_uring		},
+	{ "all",	"Run all I/O benchmarks",			NULL			},
+	{ NULL,		NULL,						NULL			}
+};
+
+static struct bench net_benchmarks[] = {
+	{ "tcp-rr",	"Benchmark for TCP request/response over loopback", bench_net_tcp_rr	},
+	{ "udp-rr",	"Benchmark for UDP request/response over loopback", bench_net_udp_rr	},
+	{ "tcp-stream",	"Benchmark for TCP bulk transfer over loopback", bench_net_tcp_stream	},
+	{ "all",	"Run all networking benchmarks",		NULL			},
+	{ NULL,		NULL,						NULL			}
+};
+
 struct collection {
 	const char	*name;
 	const char	*summary;
@@ -93,6 +120,9 @@ static struct collection collections[] = {
 #ifdef HAVE_EVENTFD
 	{"epoll",       "Epoll stressing benchmarks",                   epoll_benchmarks        },
 #endif
+	{ "mm",		"Memory management benchmarks",			mm_benchmarks		},
+	{ "io",		"Block I/O benchmarks",				io_benchmarks		},
+	{ "net",	"Networking benchmarks",			net_benchmarks		},
 	{ "all",	"All benchmarks",				NULL			},
 	{ NULL,		NULL,						NULL			}
 };
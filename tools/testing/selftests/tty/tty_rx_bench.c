@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Measure n_tty receive throughput over a pty pair.
+ *
+ * A writer thread pushes blocks into the pty master while the main
+ * thread reads them back from the slave.  By default the slave is put
+ * in raw mode (cfmakeraw()), which takes the real_raw receive path;
+ * -p also sets INPCK and PARMRK, which keeps the tty raw but moves it
+ * off real_raw onto n_tty_receive_buf_raw(); -c keeps ISIG enabled and
+ * sets IXON, so the data goes through the char_map checking path.
+ *
+ * The writer sends a fixed pattern whose period (PATTERN_LEN) does not
+ * divide the 4096 byte read ring, so the ring wraps at a different
+ * point in the pattern each time round.  Every byte read is checked
+ * against it, catching data lost or reordered by the two-piece copy of
+ * a wrapped ring.
+ *
+ * Usage: tty_rx_bench [-s block size] [-t seconds] [-p | -c]
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define READ_SIZE	65536
+#define PATTERN_LEN	251	/* prime, so it never divides the ring */
+
+static volatile int done;
+static size_t block_size = 4096;
+static int master;
+/* long enough to compare a full read or write at any phase */
+static unsigned char *pattern;
+
+static void *writer(void *arg)
+{
+	unsigned long long pos = 0;
+	ssize_t n;
+
+	while (!done) {
+		n = write(master, pattern + pos % PATTERN_LEN, block_size);
+		if (n > 0)
+			pos += n;
+		else if (n < 0 && errno != EINTR && errno != EAGAIN)
+			break;
+	}
+
+	return NULL;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	struct termios tio;
+	unsigned long long total = 0, reads = 0;
+	double start, elapsed;
+	unsigned char *buf;
+	int seconds = 5, cooked = 0, parmrk = 0, ret = 0;
+	const char *mode;
+	size_t i, len;
+	pthread_t thread;
+	int slave, opt;
+	ssize_t n;
+
+	while ((opt = getopt(argc, argv, "s:t:pc")) != -1) {
+		switch (opt) {
+		case 's':
+			block_size = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			seconds = atoi(optarg);
+			break;
+		case 'p':
+			parmrk = 1;
+			break;
+		case 'c':
+			cooked = 1;
+			break;
+		default:
+			fprintf(stderr,
+				"Usage: %s [-s block size] [-t seconds] "
+				"[-p | -c]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (!block_size || seconds <= 0 || (parmrk && cooked)) {
+		fprintf(stderr, "invalid block size, runtime or mode\n");
+		return 1;
+	}
+
+	len = (block_size > READ_SIZE ? block_size : READ_SIZE) + PATTERN_LEN;
+	pattern = malloc(len);
+	if (!pattern)
+		return 1;
+	/* avoid the ISIG and IXON special chars for the -c case */
+	for (i = 0; i < len; i++)
+		pattern[i] = 'A' + i % PATTERN_LEN % 26;
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) || unlockpt(master)) {
+		perror("posix_openpt");
+		return 1;
+	}
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if (slave < 0) {
+		perror("open slave");
+		return 1;
+	}
+
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	if (parmrk) {
+		/* still raw, but no longer real_raw */
+		tio.c_iflag |= INPCK | PARMRK;
+		mode = "raw INPCK|PARMRK";
+	} else if (cooked) {
+		tio.c_lflag |= ISIG;
+		tio.c_iflag |= IXON;
+		mode = "char_map";
+	} else {
+		mode = "raw";
+	}
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	if (tcsetattr(slave, TCSANOW, &tio)) {
+		perror("tcsetattr");
+		return 1;
+	}
+
+	buf = malloc(READ_SIZE);
+	if (!buf)
+		return 1;
+
+	if (pthread_create(&thread, NULL, writer, NULL)) {
+		perror("pthread_create");
+		return 1;
+	}
+
+	start = now();
+	do {
+		n = read(slave, buf, READ_SIZE);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("read");
+			ret = 1;
+			break;
+		}
+		if (memcmp(buf, pattern + total % PATTERN_LEN, n)) {
+			i = 0;
+			while (buf[i] == pattern[(total + i) % PATTERN_LEN])
+				i++;
+			fprintf(stderr, "data mismatch at byte %llu\n",
+				total + i);
+			ret = 1;
+			break;
+		}
+		total += n;
+		reads++;
+	} while (now() - start < seconds);
+	elapsed = now() - start;
+
+	done = 1;
+	/* keep draining until a writer blocked on a full pty sees the flag */
+	fcntl(master, F_SETFL, O_NONBLOCK);
+	fcntl(slave, F_SETFL, O_NONBLOCK);
+	while (pthread_tryjoin_np(thread, NULL))
+		while (read(slave, buf, READ_SIZE) > 0)
+			;
+
+	printf("%s mode, %zu byte writes: %.1f MB/s, %.0f bytes/read\n",
+	       mode, block_size,
+	       total / elapsed / 1e6, reads ? (double)total / reads : 0.0);
+
+	free(buf);
+	free(pattern);
+	close(slave);
+	close(master);
+	return ret;
+}